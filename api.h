@@ -97,24 +97,49 @@ struct R3_ContextInfo
 	int32 max_dispatch_x;
 	int32 max_dispatch_y;
 	int32 max_dispatch_z;
+	int32 max_unordered_views; // compute UAV slots (GL: image units), at most 16
 	int32 max_anisotropy_level;
+	uint32 supported_sample_counts; // bit N set means 1<<N samples work for both color and depth textures
+	int32 max_viewports;
 
 	uint64 supported_texture_formats      [2];
 	uint64 supported_render_target_formats[2];
 	
 	bool has_instancing;
 	bool has_base_vertex;
+	bool has_base_instance;
 	bool has_32bit_index;
 	bool has_separate_alpha_blend;
 	bool has_compute_pipeline;
+	bool has_layered_rendering; // array and cube textures attach all their layers
+	bool has_vertex_layer_output; // vertex shaders can write gl_Layer/gl_ViewportIndex (SV_RenderTargetArrayIndex/SV_ViewportArrayIndex)
+	bool has_timestamp_query;
+	bool has_debug_groups; // R3_PushDebugGroup() shows up in external tools (RenderDoc, Nsight, PIX)
+	bool has_occlusion_query;
+	bool has_pipeline_statistics_query;
+	bool has_conditional_render;
 }
 typedef R3_ContextInfo;
 
 struct R3_Context typedef R3_Context;
 
+// NOTE(ljre): Persistent storage for compiled GL programs, usually backed by files in a cache directory.
+//             Keys are a hash of the final shader sources (including the '#version' header we inject) and the
+//             driver's renderer and version strings, so a driver update simply misses the cache. Entries that
+//             the driver rejects are recompiled and stored again. D3D11 ignores it.
+struct R3_ProgramCache
+{
+	void* user_data;
+	// NOTE(ljre): Returns the blob stored under 'key', allocated from 'arena', or an empty Buffer if there's none.
+	Buffer (*load)(void* user_data, uint64 key, Arena* arena);
+	void (*store)(void* user_data, uint64 key, Buffer data);
+}
+typedef R3_ProgramCache;
+
 struct R3_ContextDesc
 {
 	struct OS_Window* window;
+	R3_ProgramCache program_cache; // optional
 }
 typedef R3_ContextDesc;
 
@@ -146,19 +171,29 @@ struct R3_Texture
 {
 	int32 width, height, depth;
 	R3_Format format;
+	int32 sample_count;
+	uint64 memory_size; // R3_EstimateTextureSize()
+	uint32 capture_id; // see R3_SetCapture()
 
 	struct ID3D11Texture2D* d3d11_tex2d;
 	struct ID3D11Texture3D* d3d11_tex3d;
 	struct ID3D11ShaderResourceView* d3d11_srv;
 	struct ID3D11UnorderedAccessView* d3d11_uav;
+	struct ID3D11UnorderedAccessView* d3d11_mip_uavs[15]; // mips 1 and up, d3d11_uav is mip 0
+	struct ID3D11RenderTargetView* d3d11_rtv; // mip 0, used by render passes
+	struct ID3D11DepthStencilView* d3d11_dsv;
 
 	uint32 gl_id;
 	uint32 gl_renderbuffer_id;
+	uint32 gl_target;
 }
 typedef R3_Texture;
 
 struct R3_Buffer
 {
+	uint32 size;
+	uint32 capture_id;
+
 	struct ID3D11Buffer* d3d11_buffer;
 	struct ID3D11ShaderResourceView* d3d11_srv;
 	struct ID3D11UnorderedAccessView* d3d11_uav;
@@ -169,15 +204,20 @@ typedef R3_Buffer;
 
 struct R3_RenderTarget
 {
+	uint32 capture_id;
+
 	struct ID3D11RenderTargetView* d3d11_rtvs[8];
 	struct ID3D11DepthStencilView* d3d11_dsv;
 
 	uint32 gl_id;
+	uint32 gl_attachments[9]; // texture names, depth-stencil last; for hazard tracking
 }
 typedef R3_RenderTarget;
 
 struct R3_Pipeline
 {
+	uint32 capture_id;
+
 	struct ID3D11BlendState* d3d11_blend;
 	struct ID3D11RasterizerState* d3d11_rasterizer;
 	struct ID3D11DepthStencilState* d3d11_depth_stencil;
@@ -196,11 +236,18 @@ struct R3_Pipeline
 	uint32 gl_cull_mode;
 	uint32 gl_frontface;
 	R3_LayoutDesc gl_layout[16];
+	uint32 gl_vs, gl_fs; // shader modules, shared with other pipelines made from the same sources
+	bool gl_pending; // a 'flag_async' pipeline that is still compiling
+	uint64 gl_cache_key;
 }
 typedef R3_Pipeline;
 
 struct R3_ComputePipeline
 {
+	// NOTE(ljre): Reflected from the shader's local_size/numthreads. Useful for sizing R3_Dispatch() calls.
+	int32 group_size_x, group_size_y, group_size_z;
+	uint32 capture_id;
+
 	struct ID3D11ComputeShader* d3d11_cs;
 
 	uint32 gl_program;
@@ -209,6 +256,8 @@ typedef R3_ComputePipeline;
 
 struct R3_Sampler
 {
+	uint32 capture_id;
+
 	struct ID3D11SamplerState* d3d11_sampler;
 
 	uint32 gl_sampler;
@@ -225,6 +274,13 @@ struct R3_TextureDesc
 	R3_Usage usage;
 	uint32 binding_flags;
 	int32 mipmap_count;
+	// NOTE(ljre): 0 or 1 for a regular texture. Multisampled textures can only be used as render pass
+	//             attachments and as the source of R3_ResolveTexture(). On GL they're always renderbuffers.
+	int32 sample_count;
+	// NOTE(ljre): 'depth' is the layer count of a 2D array texture. Cubemaps have 'depth == 6' and no initial data.
+	//             Array and cube textures are attached to render passes with all their layers; the shader picks
+	//             one per primitive (see has_vertex_layer_output).
+	bool flag_cubemap;
 	
 	void const* initial_data;
 }
@@ -298,7 +354,11 @@ struct R3_PipelineDesc
 {
 	bool flag_cw_frontface;
 	bool flag_depth_test;
-	//bool flag_scissor : 1;
+	// NOTE(ljre): GL only. R3_MakePipeline returns right after submitting the compile and link, see
+	//             R3_IsPipelineReady(). D3D11 creates shaders from bytecode, which doesn't block anyway.
+	bool flag_async;
+	// NOTE(ljre): Clips to the rects given to R3_SetScissorRects(), which stay set across pipeline changes.
+	bool flag_scissor;
 	
 	struct
 	{
@@ -319,6 +379,8 @@ struct R3_PipelineDesc
 		// NOTE(ljre): These buffers should contain null-terminated strings.
 		//             The bufffer size INCLUDES the null-terminator!
 		Buffer vs, fs;
+		// NOTE(ljre): Optional, same rules. Inserted into both stages right after the '#version' header.
+		Buffer defines;
 	} glsl;
 	struct
 	{
@@ -363,6 +425,13 @@ struct R3_Viewport
 }
 typedef R3_Viewport;
 
+struct R3_ScissorRect
+{
+	int32 x, y;
+	int32 width, height;
+}
+typedef R3_ScissorRect;
+
 struct R3_ResourceView
 {
 	R3_Buffer* buffer;
@@ -374,6 +443,7 @@ struct R3_UnorderedView
 {
 	R3_Buffer* buffer;
 	R3_Texture* texture;
+	int32 mip; // texture only
 }
 typedef R3_UnorderedView;
 
@@ -389,6 +459,44 @@ struct R3_ClearDesc
 }
 typedef R3_ClearDesc;
 
+enum R3_LoadAction
+{
+	R3_LoadAction_Load = 0,
+	R3_LoadAction_Clear,
+	R3_LoadAction_DontCare, // contents are undefined at the start of the pass
+}
+typedef R3_LoadAction;
+
+enum R3_StoreAction
+{
+	R3_StoreAction_Store = 0,
+	R3_StoreAction_Discard, // contents are undefined after the pass
+}
+typedef R3_StoreAction;
+
+// NOTE(ljre): If no texture is given, the pass renders to the backbuffer. The depth-stencil attachment takes a
+//             single pair of actions for both aspects.
+struct R3_RenderPassDesc
+{
+	R3_Texture* color_textures[8];
+	R3_Texture* depth_stencil_texture;
+
+	struct
+	{
+		R3_LoadAction load;
+		R3_StoreAction store;
+		float32 clear_color[4];
+	} colors[8];
+	struct
+	{
+		R3_LoadAction load;
+		R3_StoreAction store;
+		float32 clear_depth;
+		uint32 clear_stencil;
+	} depth_stencil;
+}
+typedef R3_RenderPassDesc;
+
 struct R3_VertexInputs
 {
 	R3_Buffer* ibuffer;
@@ -421,7 +529,19 @@ enum R3_PrimitiveType
 }
 typedef R3_PrimitiveType;
 
+// NOTE(ljre): Up to max_viewports. Shaders select one per primitive with gl_ViewportIndex (SV_ViewportArrayIndex).
 API void R3_SetViewports(R3_Context* ctx, intz count, R3_Viewport viewports[]);
+// NOTE(ljre): Rect i applies to viewport i, and only to pipelines made with 'flag_scissor'. Clears and resolves
+//             are never clipped. Same coordinate convention as R3_SetViewports().
+API void R3_SetScissorRects(R3_Context* ctx, intz count, R3_ScissorRect rects[]);
+// NOTE(ljre): Pipelines made with 'flag_async' are compiled by the driver in the background, on its own threads
+//             when GL_KHR_parallel_shader_compile (or the ARB one) is available. R3_IsPipelineReady() polls
+//             without blocking, and finishes the pipeline once the driver is done; without the extension it
+//             blocks instead. Keep the R3_Pipeline in a single place, since it's updated in place.
+//
+//             Setting a pipeline that isn't ready, or that failed to build, is allowed: every draw is skipped
+//             until the next R3_SetPipeline().
+API bool R3_IsPipelineReady(R3_Context* ctx, R3_Pipeline* pipeline);
 API void R3_SetPipeline(R3_Context* ctx, R3_Pipeline* pipeline);
 API void R3_SetRenderTarget(R3_Context* ctx, R3_RenderTarget* rendertarget);
 API void R3_SetVertexInputs(R3_Context* ctx, R3_VertexInputs const* desc);
@@ -430,15 +550,66 @@ API void R3_SetResourceViews(R3_Context* ctx, intz count, R3_ResourceView views[
 API void R3_SetSamplers(R3_Context* ctx, intz count, R3_Sampler* samplers[]);
 API void R3_SetPrimitiveType(R3_Context* ctx, R3_PrimitiveType type);
 API void R3_Clear(R3_Context* ctx, R3_ClearDesc const* desc);
+// NOTE(ljre): Binds the attachments (replacing R3_SetRenderTarget()) and tells the driver which of them have to
+//             be loaded and stored. On tilers, an attachment that is cleared or don't-care'd and then discarded
+//             never touches memory, e.g. a depth buffer only used for depth testing. Passes don't nest.
+API void R3_BeginRenderPass(R3_Context* ctx, R3_RenderPassDesc const* desc);
+API void R3_EndRenderPass(R3_Context* ctx);
 API void R3_Draw(R3_Context* ctx, uint32 start_vertex, uint32 vertex_count, uint32 start_instance, uint32 instance_count);
 API void R3_DrawIndexed(R3_Context* ctx, uint32 start_index, uint32 index_count, uint32 start_instance, uint32 instance_count, int32 base_vertex);
 
+// NOTE(ljre): Layout of the arguments read by the indirect draws. 'buffer' needs R3_BindingFlag_Indirect and
+//             'offset' is in bytes. Both GL and D3D11 use the same layout. 'start_instance' needs
+//             has_base_instance, otherwise it has to be 0.
+struct R3_DrawIndirectArgs
+{
+	uint32 vertex_count;
+	uint32 instance_count;
+	uint32 start_vertex;
+	uint32 start_instance;
+}
+typedef R3_DrawIndirectArgs;
+
+struct R3_DrawIndexedIndirectArgs
+{
+	uint32 index_count;
+	uint32 instance_count;
+	uint32 start_index;
+	int32 base_vertex;
+	uint32 start_instance;
+}
+typedef R3_DrawIndexedIndirectArgs;
+
+API void R3_DrawIndirect(R3_Context* ctx, R3_Buffer* buffer, uint32 offset);
+API void R3_DrawIndexedIndirect(R3_Context* ctx, R3_Buffer* buffer, uint32 offset);
+
+// NOTE(ljre): GLSL bindings for compute:
+//                 - R3_SetComputeUniformBuffers(): uniform block 'type_UniformBuffer<i>';
+//                 - R3_SetComputeResourceViews(): 'uniform sampler* uTexture<i>' for textures, or
+//                   'layout(binding = <i>) buffer' for buffers;
+//                 - R3_SetComputeUnorderedViews(): 'layout(binding = <i>) uniform image*' for textures, or
+//                   'layout(binding = <16+i>) buffer' for buffers.
+//             The source is compiled as '#version 430' (or '#version 310 es'). The user's '#version' line, if
+//             any, is replaced. On failure, the compile/link log is logged and a null pipeline is returned.
 API void R3_SetComputePipeline(R3_Context* ctx, R3_ComputePipeline* pipeline);
 API void R3_SetComputeUniformBuffers(R3_Context* ctx, intz count, R3_UniformBuffer buffers[]);
 API void R3_SetComputeResourceViews(R3_Context* ctx, intz count, R3_ResourceView views[]);
 API void R3_SetComputeUnorderedViews(R3_Context* ctx, intz count, R3_UnorderedView views[]);
 API void R3_Dispatch(R3_Context* ctx, uint32 x, uint32 y, uint32 z);
 
+// NOTE(ljre): Layout of the arguments read by R3_DispatchIndirect(). Same rules as the indirect draws: 'buffer'
+//             needs R3_BindingFlag_Indirect and 'offset' is in bytes (a multiple of 4). Add
+//             R3_BindingFlag_UnorderedAccess to fill it from a compute shader.
+struct R3_DispatchIndirectArgs
+{
+	uint32 group_count_x;
+	uint32 group_count_y;
+	uint32 group_count_z;
+}
+typedef R3_DispatchIndirectArgs;
+
+API void R3_DispatchIndirect(R3_Context* ctx, R3_Buffer* buffer, uint32 offset);
+
 // =============================================================================
 // =============================================================================
 // Resource Mapping & Copying
@@ -467,8 +638,1114 @@ API R3_MappedResource R3_MapTexture  (R3_Context* ctx, R3_Texture* texture, uint
 API void              R3_UnmapTexture(R3_Context* ctx, R3_Texture* texture, uint32 slice);
 
 API void R3_CopyBuffer(R3_Context* ctx, R3_Buffer* src, uint32 src_offset, R3_Buffer* dst, uint32 dst_offset, uint32 size);
+// NOTE(ljre): Resolves a multisampled color texture into a single-sampled one of the same size and format.
+//             Multisampled depth can't be resolved: give it R3_StoreAction_Discard so it never leaves the tile.
+API void R3_ResolveTexture(R3_Context* ctx, R3_Texture* src, R3_Texture* dst);
 API void R3_CopyTexture2D(R3_Context* ctx, R3_Texture* src, uint32 src_x, uint32 src_y, R3_Texture* dst, uint32 dst_x, uint32 dst_y, uint32 width, uint32 height);
 
+// =============================================================================
+// =============================================================================
+// Queries
+// NOTE(ljre): Results arrive a few frames late. R3_GetQueryResult() never blocks: it returns false until the
+//             result is there. Only reissue a query after reading its result.
+//
+//             Timestamps are in nanoseconds, only meaningful relative to each other. On D3D11 they're bracketed
+//             by a disjoint query that rotates at R3_Present(); 'disjoint' means the GPU clock changed frequency
+//             in the meantime (or, on GL ES, that the GPU was disjoint), so the value should be dropped.
+//
+//             Occlusion and pipeline statistics queries count what's drawn between R3_BeginQuery() and
+//             R3_EndQuery(). Only one query of each kind can be active at a time. Occlusion results are
+//             conservative on GL when the driver allows it (GL_ANY_SAMPLES_PASSED_CONSERVATIVE), so they may
+//             say visible for something that isn't, never the opposite.
+//
+//             Draws between R3_BeginConditionalRender() and R3_EndConditionalRender() are skipped by the GPU
+//             if the occlusion query ended with no samples passed. If the result isn't there yet the draws
+//             happen anyway on GL (GL_QUERY_NO_WAIT). On D3D11 it's up to the driver to either wait for it
+//             or just draw. Either way, a missing result never skips a draw.
+enum R3_QueryKind
+{
+	R3_QueryKind_Timestamp = 0,      // needs has_timestamp_query
+	R3_QueryKind_Occlusion,          // needs has_occlusion_query
+	R3_QueryKind_PipelineStatistics, // needs has_pipeline_statistics_query
+}
+typedef R3_QueryKind;
+
+struct R3_Query
+{
+	R3_QueryKind kind;
+	uint32 capture_id;
+
+	struct ID3D11Query* d3d11_query; // an ID3D11Predicate for occlusion queries
+	uint64 d3d11_frame;
+
+	uint32 gl_query;
+	uint32 gl_statistics_queries[7]; // one per counter, GL has no single query for all of them
+}
+typedef R3_Query;
+
+// NOTE(ljre): Counters that the backend can't provide are left as 0. 'input_vertices' and 'input_primitives'
+//             are what the input assembler fetched; clipping counts are primitives entering and leaving clipping.
+struct R3_PipelineStatistics
+{
+	uint64 input_vertices;
+	uint64 input_primitives;
+	uint64 vertex_invocations;
+	uint64 clipping_input_primitives;
+	uint64 clipping_output_primitives;
+	uint64 fragment_invocations;
+	uint64 compute_invocations;
+}
+typedef R3_PipelineStatistics;
+
+struct R3_QueryResult
+{
+	uint64 timestamp_ns;
+	bool disjoint;
+	bool any_samples_passed;
+	R3_PipelineStatistics statistics;
+}
+typedef R3_QueryResult;
+
+API R3_Query R3_MakeQuery(R3_Context* ctx, R3_QueryKind kind);
+API void R3_FreeQuery(R3_Context* ctx, R3_Query* query);
+API void R3_WriteTimestamp(R3_Context* ctx, R3_Query* query);
+API void R3_BeginQuery(R3_Context* ctx, R3_Query* query);
+API void R3_EndQuery(R3_Context* ctx, R3_Query* query);
+API bool R3_GetQueryResult(R3_Context* ctx, R3_Query* query, R3_QueryResult* out_result);
+// NOTE(ljre): Needs has_conditional_render and an occlusion query that has been ended. Doesn't nest.
+API void R3_BeginConditionalRender(R3_Context* ctx, R3_Query* query);
+API void R3_EndConditionalRender(R3_Context* ctx);
+
+// NOTE(ljre): Named regions shown by RenderDoc, Nsight, PIX and friends (KHR_debug on GL,
+//             ID3DUserDefinedAnnotation on D3D11). No-ops without has_debug_groups.
+API void R3_PushDebugGroup(R3_Context* ctx, String name);
+API void R3_PopDebugGroup(R3_Context* ctx);
+
+// =============================================================================
+// =============================================================================
+// Query pools
+// NOTE(ljre): Queries of one kind, made on first use and recycled. R3_PollPooledQuery() is R3_GetQueryResult()
+//             that gives the query back to the pool once its result is read, so a typical frame acquires,
+//             issues and forgets, then polls the ones from earlier frames. Acquiring returns NULL when every
+//             query is still in flight; skip the measurement (or draw unconditionally) in that case.
+struct R3_QueryPoolDesc
+{
+	Arena* arena;
+	R3_QueryKind kind;
+	int32 capacity;
+}
+typedef R3_QueryPoolDesc;
+
+struct R3_QueryPool
+{
+	R3_QueryKind kind;
+	int32 capacity;
+	int32 made_count; // queries[i] exists if i < made_count
+	int32 free_count;
+	R3_Query* queries;
+	int32* free_list;
+}
+typedef R3_QueryPool;
+
+API R3_QueryPool R3_MakeQueryPool(R3_Context* ctx, R3_QueryPoolDesc const* desc);
+API void R3_FreeQueryPool(R3_Context* ctx, R3_QueryPool* pool);
+API R3_Query* R3_AcquirePooledQuery(R3_Context* ctx, R3_QueryPool* pool);
+API void R3_ReleasePooledQuery(R3_Context* ctx, R3_QueryPool* pool, R3_Query* query);
+API bool R3_PollPooledQuery(R3_Context* ctx, R3_QueryPool* pool, R3_Query* query, R3_QueryResult* out_result);
+
+// =============================================================================
+// =============================================================================
+// Frame statistics
+// NOTE(ljre): Counted by the backend as commands are issued, so they cost an increment each. R3_GetFrameStats()
+//             returns the last frame finished by R3_Present(); the 'live' counts are running totals instead and
+//             are never reset. Texture memory is an estimate (see R3_EstimateTextureSize()), buffers count the
+//             size they were made or last updated with.
+//
+//             State changes count the R3_Set*() calls themselves, redundant ones included. Triangles aren't
+//             counted for indirect draws, nor for line and point primitives.
+struct R3_FrameStats
+{
+	uint64 frame;
+
+	uint32 draws; // indirect ones included
+	uint32 indirect_draws;
+	uint32 dispatches;
+	uint64 instances;
+	uint64 triangles;
+
+	uint32 pipeline_changes;       // graphics and compute
+	uint32 render_target_changes;  // R3_SetRenderTarget() and R3_BeginRenderPass()
+	uint32 vertex_input_changes;
+	uint32 uniform_buffer_changes; // graphics and compute
+	uint32 resource_view_changes;  // graphics and compute, unordered views included
+	uint32 sampler_changes;
+	uint32 fixed_function_changes; // viewports, scissor rects and primitive type
+	uint32 clears; // R3_Clear() calls, plus attachments cleared by R3_BeginRenderPass()
+
+	uint32 buffer_updates;
+	uint32 texture_updates;
+	uint64 buffer_update_bytes;
+	uint64 texture_update_bytes;
+	uint64 copy_bytes; // R3_CopyBuffer() and R3_CopyTexture2D()
+
+	uint32 resources_created;
+	uint32 resources_destroyed;
+
+	struct
+	{
+		uint32 textures;
+		uint32 buffers;
+		uint32 pipelines; // graphics and compute
+		uint32 samplers;
+		uint64 texture_bytes;
+		uint64 buffer_bytes;
+	} live;
+}
+typedef R3_FrameStats;
+
+API R3_FrameStats R3_GetFrameStats(R3_Context* ctx);
+// NOTE(ljre): Size of the texture and all its mips, as the format says. Drivers add their own padding and
+//             alignment on top of this.
+API uint64 R3_EstimateTextureSize(R3_TextureDesc const* desc);
+
+// =============================================================================
+// =============================================================================
+// Timeline capture
+// NOTE(ljre): A ring of timed events from any thread, exported as Chrome Trace Event JSON (chrome://tracing,
+//             ui.perfetto.dev). Pushing is a couple of atomics and no locks; once the ring is full the oldest
+//             events are overwritten. While disabled, or with no timeline set, it costs a single branch.
+//
+//             With R3_SetTimeline() the backend records R3_Present() (the time it blocks in the swap chain),
+//             uploads with their sizes, and pipeline creation. R3_GpuScopes with a timeline add
+//             GPU scopes on their own track, once they're read back.
+//
+//             The GPU track is submit-aligned: each GPU frame starts at the CPU tick of its first
+//             R3_BeginGpuScope() call, not at the time the GPU actually ran it, since D3D11 has no way to
+//             correlate GPU timestamps with the CPU clock. Durations and the spacing of scopes within a frame
+//             are exact, but the real GPU work usually happens later than it shows, by up to a few frames.
+//
+//             Names are stored as they are, so they have to outlive the export (string literals are fine).
+enum R3_TimelineKind
+{
+	R3_TimelineKind_Cpu = 0,
+	R3_TimelineKind_Gpu,
+	R3_TimelineKind_Upload,
+	R3_TimelineKind_Present,
+
+	R3_TimelineKind__Count,
+}
+typedef R3_TimelineKind;
+
+struct R3_TimelineEvent
+{
+	String name;
+	uint64 begin_tick; // OS_CurrentTick()
+	uint64 end_tick;
+	uint64 bytes;
+	uint64 sequence;
+	R3_TimelineKind kind;
+	uint32 thread;
+}
+typedef R3_TimelineEvent;
+
+struct R3_TimelineDesc
+{
+	Arena* arena;
+	uint32 max_events; // rounded up to a power of 2, at least 1024
+	bool enabled;
+}
+typedef R3_TimelineDesc;
+
+struct R3_Timeline
+{
+	R3_TimelineEvent* events;
+	uint64 mask;
+	uint64 head;
+	bool enabled;
+}
+typedef R3_Timeline;
+
+API R3_Timeline R3_MakeTimeline(R3_TimelineDesc const* desc);
+API void R3_SetTimelineEnabled(R3_Timeline* timeline, bool enabled);
+// NOTE(ljre): Begin returns 0 when nothing is being recorded, and End does nothing for it. 'timeline' may be NULL.
+API uint64 R3_TimelineBegin(R3_Timeline* timeline);
+API void R3_TimelineEnd(R3_Timeline* timeline, R3_TimelineKind kind, String name, uint64 begin_tick, uint64 bytes);
+API void R3_PushTimelineEvent(R3_Timeline* timeline, R3_TimelineKind kind, String name, uint64 begin_tick, uint64 end_tick, uint64 bytes);
+API String R3_ExportTimelineJson(R3_Timeline* timeline, Arena* output_arena);
+API void R3_SetTimeline(R3_Context* ctx, R3_Timeline* timeline);
+
+// =============================================================================
+// =============================================================================
+// API capture & replay
+// NOTE(ljre): With R3_SetCapture() the backend serializes every call that reaches the GPU into a compact binary
+//             stream, payloads included: initial data, updates, and the shader sources of every backend, so a
+//             capture from one backend replays on the other. The helpers in
+//             the other render3_*.c files are made of these calls, so they're captured as well. Query results,
+//             R3_QueryInfo() and R3_GetFrameStats() aren't recorded.
+//
+//             Handles are identified by 'capture_id', given to them as they're made while capturing. Start
+//             capturing right after making the context: handles made before have no id and replay as NULL. Once
+//             'max_size' bytes are used, recording stops at the last R3_Present() and 'overflowed' is set.
+//
+//             R3_GetCaptureData() returns the bytes to save, up to the last R3_Present(). The format follows the
+//             struct layouts of this header, so replay captures with a build of the same version.
+//
+//             R3_ReplayCapture() re-executes a capture as fast as the context goes (R3_Present() still waits if
+//             the swap chain has vsync) and times every frame: CPU time from its first command until R3_Present()
+//             returns, GPU time from timestamps written at both ends when has_timestamp_query. Pipelines made
+//             with 'flag_async' are made synchronously, so no draw is skipped and runs are repeatable.
+enum R3_CaptureOp
+{
+	R3_CaptureOp_Null = 0,
+
+	R3_CaptureOp_MakeTexture,
+	R3_CaptureOp_MakeBuffer,
+	R3_CaptureOp_MakeRenderTarget,
+	R3_CaptureOp_MakePipeline,
+	R3_CaptureOp_MakeComputePipeline,
+	R3_CaptureOp_MakeSampler,
+	R3_CaptureOp_MakeQuery,
+	R3_CaptureOp_FreeTexture,
+	R3_CaptureOp_FreeBuffer,
+	R3_CaptureOp_FreeRenderTarget,
+	R3_CaptureOp_FreePipeline,
+	R3_CaptureOp_FreeComputePipeline,
+	R3_CaptureOp_FreeSampler,
+	R3_CaptureOp_FreeQuery,
+	R3_CaptureOp_UpdateBuffer,
+	R3_CaptureOp_UpdateTexture,
+
+	R3_CaptureOp_SetViewports,
+	R3_CaptureOp_SetScissorRects,
+	R3_CaptureOp_SetPipeline,
+	R3_CaptureOp_SetRenderTarget,
+	R3_CaptureOp_SetVertexInputs,
+	R3_CaptureOp_SetUniformBuffers,
+	R3_CaptureOp_SetResourceViews,
+	R3_CaptureOp_SetSamplers,
+	R3_CaptureOp_SetPrimitiveType,
+	R3_CaptureOp_Clear,
+	R3_CaptureOp_BeginRenderPass,
+	R3_CaptureOp_EndRenderPass,
+	R3_CaptureOp_Draw,
+	R3_CaptureOp_DrawIndexed,
+	R3_CaptureOp_DrawIndirect,
+	R3_CaptureOp_DrawIndexedIndirect,
+	R3_CaptureOp_SetComputePipeline,
+	R3_CaptureOp_SetComputeUniformBuffers,
+	R3_CaptureOp_SetComputeResourceViews,
+	R3_CaptureOp_SetComputeUnorderedViews,
+	R3_CaptureOp_Dispatch,
+	R3_CaptureOp_DispatchIndirect,
+
+	R3_CaptureOp_CopyBuffer,
+	R3_CaptureOp_ResolveTexture,
+	R3_CaptureOp_CopyTexture2D,
+
+	R3_CaptureOp_WriteTimestamp,
+	R3_CaptureOp_BeginQuery,
+	R3_CaptureOp_EndQuery,
+	R3_CaptureOp_BeginConditionalRender,
+	R3_CaptureOp_EndConditionalRender,
+	R3_CaptureOp_PushDebugGroup,
+	R3_CaptureOp_PopDebugGroup,
+
+	R3_CaptureOp_ResizeBuffers,
+	R3_CaptureOp_Present,
+
+	R3_CaptureOp__Count,
+}
+typedef R3_CaptureOp;
+
+// NOTE(ljre): What the backends hand to R3_RecordCapture(), only the fields the call has are set. 'object' is the
+//             handle made, freed, bound or used (the source of copies), 'other' the destination of copies; Make
+//             calls pass it after it's made, so its id can be assigned. 'args' are the integer parameters in the
+//             order the function takes them.
+struct R3_CaptureCall
+{
+	R3_CaptureOp op;
+	void const* desc;
+	void* object;
+	void* other;
+	void const* array;
+	intz count;
+	void const* memory;
+	uint32 size;
+	uint32 args[8];
+	String name;
+}
+typedef R3_CaptureCall;
+
+struct R3_CaptureDesc
+{
+	Arena* arena;
+	uintz max_size;
+}
+typedef R3_CaptureDesc;
+
+struct R3_Capture
+{
+	uint8* data;
+	uintz size;
+	uintz capacity;
+	uintz frame_end; // offset right after the last R3_Present()
+	uint32 next_id;
+	uint32 frame_count;
+	bool overflowed;
+}
+typedef R3_Capture;
+
+struct R3_ReplayDesc
+{
+	Arena* arena; // for the results
+	Buffer data;  // from R3_GetCaptureData(), has to outlive the call
+}
+typedef R3_ReplayDesc;
+
+struct R3_ReplayFrame
+{
+	float64 cpu_ms;
+	float64 gpu_ms;
+	bool gpu_timed; // false without timestamps, or if the GPU clock was disjoint
+	R3_FrameStats stats;
+}
+typedef R3_ReplayFrame;
+
+struct R3_ReplayResult
+{
+	bool ok; // false if the data isn't a capture of this version, or is truncated
+	int32 frame_count;
+	R3_ReplayFrame* frames;
+	float64 total_cpu_ms;
+	float64 total_gpu_ms;
+}
+typedef R3_ReplayResult;
+
+API R3_Capture R3_MakeCapture(R3_CaptureDesc const* desc);
+// NOTE(ljre): Pass NULL to stop capturing.
+API void R3_SetCapture(R3_Context* ctx, R3_Capture* capture);
+// NOTE(ljre): Called by the backends while a capture is set.
+API void R3_RecordCapture(R3_Capture* capture, R3_CaptureCall const* call);
+API Buffer R3_GetCaptureData(R3_Capture* capture);
+API R3_ReplayResult R3_ReplayCapture(R3_Context* ctx, R3_ReplayDesc const* desc);
+
+// =============================================================================
+// =============================================================================
+// GPU scopes
+// NOTE(ljre): Measures GPU time of nested regions of a frame. Each scope writes a timestamp at its begin and
+//             end, and also pushes a debug group so the same regions show up in external tools. Results are
+//             read 'frame_latency' frames later at most, without ever stalling: when the GPU falls that far
+//             behind, frames are simply left untimed.
+//
+//             Call R3_EndGpuScopesFrame() once per frame, before R3_Present(), with no scopes open. After it,
+//             R3_GetGpuScopeResults() gives the most recent frame read back ('result_frame'), in the order the
+//             scopes began. Names aren't copied, they have to live until then (string literals are fine).
+struct R3_GpuScopesDesc
+{
+	Arena* arena;
+	int32 max_scopes;    // per frame, default 64
+	int32 frame_latency; // frames in flight, default 4
+	R3_Timeline* timeline; // optional, gets the scopes as they're read back
+}
+typedef R3_GpuScopesDesc;
+
+struct R3_GpuScopeResult
+{
+	String name;
+	int32 depth;
+	int32 parent;       // index in the results, -1 at the top level
+	float64 begin_ms;   // relative to the first scope of the frame
+	float64 duration_ms;
+}
+typedef R3_GpuScopeResult;
+
+struct R3_GpuScopes
+{
+	int32 max_scopes;
+	int32 frame_latency;
+	bool has_timer;
+	struct R3_GpuScopesFrame_* frames;
+	R3_Timeline* timeline;
+
+	uint64 frame;
+	uint64 read_frame;
+	int32 depth;
+	int32 stack[16];
+	uint64 dropped_scopes; // didn't fit in 'max_scopes'
+
+	R3_GpuScopeResult* results;
+	int32 result_count;
+	uint64 result_frame;
+}
+typedef R3_GpuScopes;
+
+API R3_GpuScopes R3_MakeGpuScopes(R3_Context* ctx, R3_GpuScopesDesc const* desc);
+API void R3_FreeGpuScopes(R3_Context* ctx, R3_GpuScopes* scopes);
+API void R3_BeginGpuScope(R3_Context* ctx, R3_GpuScopes* scopes, String name);
+API void R3_EndGpuScope(R3_Context* ctx, R3_GpuScopes* scopes);
+API void R3_EndGpuScopesFrame(R3_Context* ctx, R3_GpuScopes* scopes);
+API R3_GpuScopeResult const* R3_GetGpuScopeResults(R3_GpuScopes* scopes, int32* out_count);
+
+// =============================================================================
+// =============================================================================
+// Dynamic resolution
+// NOTE(ljre): Renders the scene into the top-left part of 'color_texture' and sizes that part so the GPU time
+//             of the frame stays under 'frame_budget_ms', measured with timestamps a few frames late. It drops
+//             resolution as soon as a frame goes over, but only climbs back after 'upscale_delay_frames' frames
+//             under the hysteresis band. Without has_timestamp_query the scale stays at 'max_scale'.
+//
+//             Per frame: R3_BeginDynamicResolutionFrame() first, render the scene with the returned viewport,
+//             R3_DynamicResolutionUpscale() into the final target (binding it and its viewport is up to you),
+//             then R3_EndDynamicResolutionFrame() right before R3_Present().
+//
+//             'color_texture' is the full size render target, and needs R3_BindingFlag_ShaderResource. The
+//             built-in shaders are GLSL only; on D3D11 pass 'dx50_vs' and 'dx50_ps' following the GLSL ones in
+//             render3_dynres.c (with v flipped, since the viewport starts at the top there).
+enum R3_UpscaleFilter
+{
+	R3_UpscaleFilter_Bilinear = 0,
+	R3_UpscaleFilter_Sharpened, // bilinear plus an unsharp mask clamped to the neighbourhood
+}
+typedef R3_UpscaleFilter;
+
+struct R3_DynamicResolutionDesc
+{
+	R3_Texture* color_texture;
+	float32 frame_budget_ms;
+	float32 min_scale;            // default 0.5
+	float32 max_scale;            // default 1.0
+	float32 hysteresis;           // fraction of the budget, default 0.1
+	float32 max_scale_step;       // largest increase per step, default 0.05
+	int32 upscale_delay_frames;   // default 30
+	R3_UpscaleFilter filter;
+	float32 sharpness;            // 0 to 1, R3_UpscaleFilter_Sharpened only
+
+	Buffer dx50_vs;
+	Buffer dx50_ps;
+}
+typedef R3_DynamicResolutionDesc;
+
+struct R3_DynamicResolution
+{
+	R3_Texture* color_texture;
+	float32 frame_budget_ms;
+	float32 min_scale, max_scale;
+	float32 hysteresis;
+	float32 max_scale_step;
+	int32 upscale_delay_frames;
+	R3_UpscaleFilter filter;
+	float32 sharpness;
+
+	R3_Pipeline pipeline;
+	R3_Sampler sampler;
+	R3_Buffer uniforms;
+
+	bool has_timer;
+	bool timing_frame;
+	uint64 frame;
+	uint64 read_frame;
+	R3_Query timestamps[4][2];
+
+	float32 scale;
+	float32 gpu_ms; // last measured
+	int32 frames_under_budget;
+	int32 width, height;
+}
+typedef R3_DynamicResolution;
+
+API R3_DynamicResolution R3_MakeDynamicResolution(R3_Context* ctx, R3_DynamicResolutionDesc const* desc);
+API void R3_FreeDynamicResolution(R3_Context* ctx, R3_DynamicResolution* dynres);
+API R3_Viewport R3_BeginDynamicResolutionFrame(R3_Context* ctx, R3_DynamicResolution* dynres);
+API void R3_DynamicResolutionUpscale(R3_Context* ctx, R3_DynamicResolution* dynres);
+API void R3_EndDynamicResolutionFrame(R3_Context* ctx, R3_DynamicResolution* dynres);
+
+// =============================================================================
+// =============================================================================
+// Transient textures
+// NOTE(ljre): Textures that only live for part of a frame. Passes acquire them by description and release them
+//             once nothing later in the frame reads them; a released texture is handed back to the next acquire
+//             with the same description (size, format, usage, binding flags, mips and sample count), so
+//             non-overlapping lifetimes share physical memory. Since render passes look FBOs up by the
+//             attachments, they get shared as well.
+//
+//             Everything is counted per frame, between two R3_BeginTransientFrame() calls. 'requested_bytes' is
+//             what all acquires would take without aliasing, 'physical_bytes' what the distinct textures used in
+//             the frame take, and 'peak_live_bytes' the most acquired at once. Sizes are estimates.
+struct R3_TransientPoolDesc
+{
+	Arena* arena;
+	uint32 max_textures;
+	uint32 max_unused_frames; // textures not acquired for this many frames are freed; 0 keeps them forever
+}
+typedef R3_TransientPoolDesc;
+
+struct R3_TransientStats
+{
+	uint64 requested_bytes;
+	uint64 physical_bytes;
+	uint64 peak_live_bytes;
+	uint32 acquire_count;
+	uint32 physical_count;
+}
+typedef R3_TransientStats;
+
+struct R3_TransientPool
+{
+	struct R3_TransientTexture_* textures;
+	uint32 capacity;
+	uint32 max_unused_frames;
+	uint64 frame;
+	uint64 live_bytes;
+	uint64 allocated_bytes; // every texture owned by the pool
+
+	R3_TransientStats stats; // frame in progress
+	R3_TransientStats last_frame_stats;
+}
+typedef R3_TransientPool;
+
+API R3_TransientPool R3_MakeTransientPool(R3_Context* ctx, R3_TransientPoolDesc const* desc);
+API void R3_FreeTransientPool(R3_Context* ctx, R3_TransientPool* pool);
+// NOTE(ljre): Every texture has to be released by then.
+API void R3_BeginTransientFrame(R3_Context* ctx, R3_TransientPool* pool);
+API R3_Texture* R3_AcquireTransientTexture(R3_Context* ctx, R3_TransientPool* pool, R3_TextureDesc const* desc);
+API void R3_ReleaseTransientTexture(R3_Context* ctx, R3_TransientPool* pool, R3_Texture* texture);
+
+// =============================================================================
+// =============================================================================
+// Render graph
+// NOTE(ljre): Passes declare the textures and buffers they touch, and R3_ExecuteGraph() runs them in declaration
+//             order, which is what defines the data flow. A pass is culled unless it has side effects or writes
+//             something a later kept pass reads, or that is exported (the backbuffer always is). Attachments get
+//             their load and store actions from that: contents nobody produced are don't-care'd, and contents
+//             nobody consumes afterwards are discarded. GL memory barriers are still emitted by the backend,
+//             right before the command that needs them.
+//
+//             Transient textures come from the R3_TransientPool and only live between the first and last kept
+//             pass using them. Use R3_GraphGetTexture() inside 'execute' to get the actual objects.
+struct R3_GraphResource
+{
+	uint32 id; // 0 is none
+}
+typedef R3_GraphResource;
+
+struct R3_Graph typedef R3_Graph;
+
+struct R3_GraphPassDesc
+{
+	String name;
+
+	// NOTE(ljre): Giving any attachment makes this a render pass. Attachments that aren't cleared are loaded.
+	R3_GraphResource color_attachments[8];
+	R3_GraphResource depth_stencil_attachment;
+	struct
+	{
+		bool flag_clear;
+		float32 clear_color[4];
+	} colors[8];
+	struct
+	{
+		bool flag_clear;
+		float32 clear_depth;
+		uint32 clear_stencil;
+	} depth_stencil;
+
+	R3_GraphResource reads[16]; // sampled textures, read buffers
+	R3_GraphResource writes[16]; // unordered views, treated as read-modify-write
+	bool flag_side_effects; // never culled
+
+	void* user_data;
+	void (*execute)(R3_Context* ctx, R3_Graph* graph, void* user_data);
+}
+typedef R3_GraphPassDesc;
+
+struct R3_GraphDesc
+{
+	Arena* arena; // everything lives here, build a new graph every frame
+	R3_TransientPool* pool; // only needed by R3_GraphCreateTexture()
+	uint32 max_passes;
+	uint32 max_resources;
+}
+typedef R3_GraphDesc;
+
+struct R3_Graph
+{
+	R3_TransientPool* pool;
+	struct R3_GraphPassInfo_* passes;
+	struct R3_GraphResourceInfo_* resources;
+	uint32 pass_count, max_passes;
+	uint32 resource_count, max_resources;
+	uint32 culled_pass_count; // by the last R3_ExecuteGraph()
+};
+
+API R3_Graph R3_MakeGraph(R3_Context* ctx, R3_GraphDesc const* desc);
+API R3_GraphResource R3_GraphImportTexture(R3_Graph* graph, R3_Texture* texture);
+API R3_GraphResource R3_GraphImportBuffer(R3_Graph* graph, R3_Buffer* buffer);
+API R3_GraphResource R3_GraphImportBackbuffer(R3_Graph* graph);
+API R3_GraphResource R3_GraphCreateTexture(R3_Graph* graph, R3_TextureDesc const* desc);
+// NOTE(ljre): Marks an imported resource as consumed after the graph, so its writers are kept.
+API void R3_GraphExport(R3_Graph* graph, R3_GraphResource resource);
+API void R3_AddGraphPass(R3_Graph* graph, R3_GraphPassDesc const* desc);
+API R3_Texture* R3_GraphGetTexture(R3_Graph* graph, R3_GraphResource resource);
+API R3_Buffer* R3_GraphGetBuffer(R3_Graph* graph, R3_GraphResource resource);
+API void R3_ExecuteGraph(R3_Context* ctx, R3_Graph* graph);
+
+// =============================================================================
+// =============================================================================
+// Shader permutations
+// NOTE(ljre): A base R3_PipelineDesc plus a list of features packed into a key, in order, from the lowest bit.
+//             A feature with 'bits == 1' is a boolean, wider ones are integers in [0, 2^bits). Each variant is
+//             compiled on first use with one '#define NAME value' line per feature inserted into 'glsl.defines',
+//             so shaders select code with '#if NAME' and the rest is compiled away.
+//
+//             The optional 'specialize' callback can patch the descriptor of a variant before it is compiled,
+//             e.g. to pick the precompiled D3D11 bytecode matching 'key'.
+struct R3_ShaderFeature
+{
+	String name;
+	int32 bits;
+}
+typedef R3_ShaderFeature;
+
+struct R3_PipelinePermutationsDesc
+{
+	R3_PipelineDesc base; // 'glsl.defines' must be empty
+	R3_ShaderFeature features[16];
+	int32 feature_count;
+
+	Arena* arena;
+	uint32 max_variants; // compiled ones at the same time
+
+	void* user_data;
+	void (*specialize)(void* user_data, uint64 key, R3_PipelineDesc* desc);
+}
+typedef R3_PipelinePermutationsDesc;
+
+struct R3_PipelinePermutations
+{
+	R3_PipelineDesc base;
+	R3_ShaderFeature features[16];
+	int32 feature_count;
+	int32 key_bits;
+
+	void* user_data;
+	void (*specialize)(void* user_data, uint64 key, R3_PipelineDesc* desc);
+
+	struct R3_PipelineVariant_* variants;
+	uint32 variant_capacity;
+	uint32 variant_count;
+	uint64 hits;
+}
+typedef R3_PipelinePermutations;
+
+// NOTE(ljre): The base descriptor (and the shader sources it points to) and the feature names must outlive the
+//             permutations object.
+API R3_PipelinePermutations R3_MakePipelinePermutations(R3_Context* ctx, R3_PipelinePermutationsDesc const* desc);
+API void R3_FreePipelinePermutations(R3_Context* ctx, R3_PipelinePermutations* perms);
+API R3_Pipeline* R3_GetPipelineVariant(R3_Context* ctx, R3_PipelinePermutations* perms, uint64 key);
+
+// =============================================================================
+// =============================================================================
+// Pipeline & sampler interning
+// NOTE(ljre): Makes pipelines and samplers shared and reference counted. Descriptors are hashed by content
+//             (every field, the bytes of the shader sources and the whole 'input_layout'), so identical ones
+//             give the same pointer back, and a pointer comparison is enough to tell two of them apart.
+//
+//             Objects returned by R3_InternPipeline()/R3_InternSampler() belong to the cache: release them with
+//             R3_ReleasePipeline()/R3_ReleaseSampler() instead of freeing them. Pointers stay valid until the
+//             last reference is released.
+//
+//             A copy of the shader sources of every pipeline made is kept in 'arena', so a hash collision can't
+//             hand back the wrong pipeline. Each table slot keeps its copy around and reuses it for the next
+//             pipeline that lands there if it fits, so 'arena' only grows when a pipeline needs more source
+//             bytes than its slot already has. Nothing is returned to 'arena' before R3_FreeInternCache().
+struct R3_InternCacheDesc
+{
+	Arena* arena;
+	uint32 max_pipelines; // live ones at the same time
+	uint32 max_samplers;
+}
+typedef R3_InternCacheDesc;
+
+struct R3_InternCache
+{
+	struct R3_InternedPipeline_* pipelines;
+	struct R3_InternedSampler_* samplers;
+	Arena* arena;
+	uint32 pipeline_capacity, sampler_capacity;
+	uint32 pipeline_count, sampler_count;
+	uint64 pipeline_hits, sampler_hits;
+}
+typedef R3_InternCache;
+
+API R3_InternCache R3_MakeInternCache(R3_Context* ctx, R3_InternCacheDesc const* desc);
+// NOTE(ljre): Frees every object still in the cache, whatever its reference count.
+API void R3_FreeInternCache(R3_Context* ctx, R3_InternCache* cache);
+API R3_Pipeline* R3_InternPipeline(R3_Context* ctx, R3_InternCache* cache, R3_PipelineDesc const* desc);
+API void R3_ReleasePipeline(R3_Context* ctx, R3_InternCache* cache, R3_Pipeline* pipeline);
+API R3_Sampler* R3_InternSampler(R3_Context* ctx, R3_InternCache* cache, R3_SamplerDesc const* desc);
+API void R3_ReleaseSampler(R3_Context* ctx, R3_InternCache* cache, R3_Sampler* sampler);
+
+// =============================================================================
+// =============================================================================
+// GPU-driven culling
+// NOTE(ljre): Instances are tested against the frustum and, optionally, against the previous frame's depth
+//             pyramid (a R3_Format_F32x1 texture where each mip holds the MAX depth of the 2x2 texels below it).
+//             Visible instances are compacted into 'visible_instances' and counted straight into the
+//             'instance_count' of each draw's R3_DrawIndexedIndirectArgs, so R3_GpuCullerDraw never needs the
+//             CPU to know how many survived.
+//
+//             'visible_instances' holds one uint32 instance index per surviving instance, in the range
+//             [draw.first_instance, draw.first_instance + draw.max_instance_count). Bind it as a vertex buffer
+//             with a R3_Format_U32x1 layout and divisor 1 to fetch per-instance data in the vertex shader;
+//             since 'start_instance' is set to 'first_instance' this needs has_base_instance when there's
+//             more than one draw.
+//
+//             Instances whose 'draw_index' is out of range are dropped, and so are the ones past a draw's
+//             'max_instance_count'. Which of them survive is then up to scheduling.
+//
+//             The GLSL is built in. For D3D11 you need to pass the bytecode of equivalent shaders. The draw
+//             arguments buffer holds 'draw_count' R3_DrawIndexedIndirectArgs followed by one uint32
+//             'max_instance_count' per draw, and the cull shader has to respect both bounds.
+struct R3_GpuCullInstance
+{
+	// NOTE(ljre): std430 layout of each element of the instance buffer (struct_size = 32)
+	float32 center[3];
+	float32 radius;
+	uint32 draw_index;
+	uint32 user_data[3];
+}
+typedef R3_GpuCullInstance;
+
+struct R3_GpuCullDraw
+{
+	uint32 index_count;
+	uint32 start_index;
+	int32 base_vertex;
+	uint32 first_instance;
+	uint32 max_instance_count;
+}
+typedef R3_GpuCullDraw;
+
+struct R3_GpuCullerDesc
+{
+	uint32 max_instance_count;
+	uint32 draw_count;
+	R3_GpuCullDraw const* draws;
+
+	Buffer dx50_reset_cs, dx50_cull_cs;
+}
+typedef R3_GpuCullerDesc;
+
+struct R3_GpuCuller
+{
+	R3_ComputePipeline reset_pipeline;
+	R3_ComputePipeline cull_pipeline;
+	R3_Buffer uniforms;
+	R3_Buffer draw_args;
+	R3_Buffer visible_instances;
+
+	uint32 draw_count;
+	uint32 max_instance_count;
+}
+typedef R3_GpuCuller;
+
+struct R3_GpuCullParams
+{
+	// NOTE(ljre): Column-major, same memory layout as GLSL's mat4.
+	float32 view_proj[4][4];
+	float32 prev_view_proj[4][4]; // matrix the depth pyramid was rendered with
+
+	R3_Buffer* instances; // R3_BindingFlag_StructuredBuffer|R3_BindingFlag_ShaderResource, R3_GpuCullInstance[]
+	uint32 instance_count;
+
+	R3_Texture* depth_pyramid; // NULL disables occlusion culling
+	int32 depth_pyramid_mip_count;
+
+	bool flag_zero_to_one_depth; // D3D-style clip space (z in [0,1], texture origin at the top)
+}
+typedef R3_GpuCullParams;
+
+API R3_GpuCuller R3_MakeGpuCuller(R3_Context* ctx, R3_GpuCullerDesc const* desc);
+API void R3_FreeGpuCuller(R3_Context* ctx, R3_GpuCuller* culler);
+API void R3_GpuCull(R3_Context* ctx, R3_GpuCuller* culler, R3_GpuCullParams const* params);
+// NOTE(ljre): Issues one R3_DrawIndexedIndirect per draw. The pipeline, vertex inputs, and so on should
+//             already be set.
+API void R3_GpuCullerDraw(R3_Context* ctx, R3_GpuCuller* culler);
+
+// =============================================================================
+// =============================================================================
+// Software occlusion culling
+// NOTE(ljre): CPU-side fallback for when there's no compute (or just no depth pyramid). A low resolution
+//             depth buffer is rasterized from a handful of simple occluder meshes, then object AABBs are
+//             tested against it before issuing their draws. Depth is stored in [0,1] (smaller is nearer)
+//             regardless of the clip space convention.
+//
+//             Per frame:
+//               1. R3_SwOcclusionBegin()
+//               2. R3_SwOcclusionAddOccluder() for each occluder. Triangles are set up and binned into
+//                  screen tiles here, from a single thread.
+//               3. R3_SwOcclusionRasterizeTile() for every tile in [0, tile_count). Different tiles can be
+//                  rasterized from different threads at the same time. R3_SwOcclusionRasterize() just
+//                  does all of them in the calling thread.
+//               4. R3_SwOcclusionTestAabb() or R3_SwOcclusionDrawIndexed() for each object. These only read
+//                  from the depth buffer, so they're also fine to call from many threads. Stats are not
+//                  counted atomically, though.
+struct R3_SwOcclusionTile_ typedef R3_SwOcclusionTile_;
+struct R3_SwOcclusionTriangle_ typedef R3_SwOcclusionTriangle_;
+
+struct R3_SwOcclusionDesc
+{
+	int32 width, height; // resolution of the depth buffer, e.g. 256x128 or 512x256
+	int32 max_triangles; // triangles past this are dropped, which is always safe. 0 means 8192
+	Arena* arena; // all memory is pushed here once
+}
+typedef R3_SwOcclusionDesc;
+
+struct R3_SwOcclusionStats
+{
+	uint64 occluder_triangles; // triangles passed to R3_SwOcclusionAddOccluder
+	uint64 rasterized_triangles; // after clipping and culling, before binning
+	uint64 dropped_triangles;
+	uint64 rasterize_ticks; // OS_CurrentTick() units, summed across tiles (so across threads too)
+	float64 triangles_per_ms;
+
+	uint64 tested_objects;
+	uint64 frustum_culled_objects;
+	uint64 occlusion_culled_objects;
+	float64 culled_ratio;
+}
+typedef R3_SwOcclusionStats;
+
+struct R3_SwOcclusion
+{
+	int32 width, height;
+	int32 tiles_x, tiles_y;
+	int32 tile_count;
+
+	float32 view_proj[4][4];
+	bool zero_to_one_depth;
+
+	int32 max_triangles;
+	int32 triangle_count;
+	R3_SwOcclusionTriangle_* triangles;
+
+	// NOTE(ljre): Each tile has a linked list of fixed-size chunks of triangle indices.
+	int32 max_bin_chunks;
+	int32 bin_chunk_count;
+	int32* bin_chunk_next;
+	uint32* bin_chunks;
+	R3_SwOcclusionTile_* tiles;
+	float32* depth; // tile-major, see R3_SwOcclusionDepthAt()
+	float32* hiz; // farthest depth of each 8x8 block
+
+	R3_SwOcclusionStats stats;
+}
+typedef R3_SwOcclusion;
+
+API R3_SwOcclusion R3_MakeSwOcclusion(R3_SwOcclusionDesc const* desc);
+// NOTE(ljre): 'view_proj' is column-major, as in R3_GpuCullParams. 'zero_to_one_depth' is the D3D-style clip
+//             space (z in [0,1]).
+API void R3_SwOcclusionBegin(R3_SwOcclusion* occ, float32 const view_proj[4][4], bool zero_to_one_depth);
+// NOTE(ljre): 'positions' are float32[3] strided by 'stride' bytes. 'model' can be NULL for identity.
+//             Triangles are rasterized double-sided.
+API void R3_SwOcclusionAddOccluder(R3_SwOcclusion* occ, void const* positions, intz vertex_count, uint32 stride, uint32 const* indices, intz index_count, float32 const model[4][4]);
+API void R3_SwOcclusionRasterizeTile(R3_SwOcclusion* occ, int32 tile_index);
+API void R3_SwOcclusionRasterize(R3_SwOcclusion* occ);
+API float32 R3_SwOcclusionDepthAt(R3_SwOcclusion const* occ, int32 x, int32 y);
+// NOTE(ljre): World-space AABB. Returns true if the box might be visible.
+API bool R3_SwOcclusionTestAabb(R3_SwOcclusion* occ, float32 const aabb_min[3], float32 const aabb_max[3]);
+// NOTE(ljre): R3_DrawIndexed() if R3_SwOcclusionTestAabb() passes. Returns whether the draw was issued.
+API bool R3_SwOcclusionDrawIndexed(R3_Context* ctx, R3_SwOcclusion* occ, float32 const aabb_min[3], float32 const aabb_max[3], uint32 start_index, uint32 index_count, uint32 start_instance, uint32 instance_count, int32 base_vertex);
+// NOTE(ljre): Fills in the derived fields and resets the counters.
+API R3_SwOcclusionStats R3_SwOcclusionTakeStats(R3_SwOcclusion* occ);
+
+// =============================================================================
+// =============================================================================
+// Single-pass downsampler
+// NOTE(ljre): Builds mip chains and Hi-Z pyramids in the style of AMD's FidelityFX SPD. Each workgroup reduces a
+//             64x64 block of the source down to 1x1 (6 mips) using shared memory, and the last workgroup to
+//             finish reduces those results into the next 6 mips. A 4096x4096 texture becomes 1x1 in a single
+//             R3_Dispatch() as long as info.max_unordered_views >= 13; otherwise the chain is split into as few
+//             dispatches as the UAV slots allow.
+//
+//             sRGB destinations are not supported: GLES 3.1 doesn't allow image load/store on sRGB formats. To
+//             get an sRGB-correct mip chain, render into a linear F16x4 (or U8x4Norm) texture and downsample
+//             that instead. sRGB textures can still be used as 'src', since they're only sampled.
+//
+//             The built-in shader is GLSL only. On D3D11, 'src' and 'dst' must be different textures, since a
+//             texture can't be bound as a resource view and an unordered view at the same time. For the same
+//             reason, 'mip_count' must not exceed max_mips_per_dispatch there.
+enum R3_DownsampleMode
+{
+	R3_DownsampleMode_Average = 0,
+	R3_DownsampleMode_Min,
+	R3_DownsampleMode_Max,
+}
+typedef R3_DownsampleMode;
+
+struct R3_DownsamplerDesc
+{
+	// NOTE(ljre): Format of the destination textures. One of U8x1Norm, U8x2Norm, U8x4Norm, F16x2, F16x4,
+	//             F32x1, F32x2 or F32x4.
+	R3_Format format;
+	Buffer dx50_cs;
+}
+typedef R3_DownsamplerDesc;
+
+struct R3_Downsampler
+{
+	R3_ComputePipeline pipeline;
+	R3_Buffer uniforms;
+	R3_Buffer scratch; // atomic counter + one texel per workgroup, R3_BindingFlag_UnorderedAccess
+	R3_Format format;
+	int32 max_mips_per_dispatch;
+}
+typedef R3_Downsampler;
+
+struct R3_DownsampleParams
+{
+	R3_Texture* src; // R3_BindingFlag_ShaderResource
+	int32 src_mip;
+	R3_Texture* dst; // R3_BindingFlag_UnorderedAccess, can be the same as 'src'
+	int32 dst_mip; // first mip written, half the size of 'src' at 'src_mip'
+	int32 mip_count; // 0 means down to 1x1
+	R3_DownsampleMode mode;
+}
+typedef R3_DownsampleParams;
+
+API R3_Downsampler R3_MakeDownsampler(R3_Context* ctx, R3_DownsamplerDesc const* desc);
+API void R3_FreeDownsampler(R3_Context* ctx, R3_Downsampler* downsampler);
+// NOTE(ljre): Leaves the unordered views unbound, same as R3_GpuCull().
+API void R3_Downsample(R3_Context* ctx, R3_Downsampler* downsampler, R3_DownsampleParams const* params);
+
+// =============================================================================
+// =============================================================================
+// GPU parallel primitives
+// NOTE(ljre): Prefix sums, stream compaction and radix sort over uint32 buffers, all done in compute. Scans
+//             are reduce-then-scan: each workgroup reduces a partition of 1024 elements, a single workgroup
+//             scans the partition sums, and a last dispatch scans each partition again adding its offset.
+//             Unlike decoupled look-back, this doesn't depend on the driver scheduling workgroups in order.
+//
+//             The radix sort is a stable LSD sort of uint32 keys with optional uint32 values, 4 bits per pass.
+//
+//             Every buffer passed in here needs R3_BindingFlag_ShaderResource|R3_BindingFlag_UnorderedAccess
+//             and holds tightly packed uint32s. 'count' can't be more than 'max_count', which itself can't be
+//             more than 65535*1024.
+//
+//             The GLSL is built in. For D3D11 you need to pass the bytecode of equivalent shaders, using the
+//             same uniform block. The radix shaders AND every key with 'uKeyMask' before taking digits, and
+//             the compact shader is also dispatched with 'count' == 0, and must write 0 to 'out_count' then.
+struct R3_GpuPrimitivesDesc
+{
+	uint32 max_count;
+
+	Buffer dx50_scan_reduce_cs, dx50_scan_partials_cs, dx50_scan_downsweep_cs;
+	Buffer dx50_compact_cs;
+	Buffer dx50_radix_histogram_cs, dx50_radix_scatter_cs;
+}
+typedef R3_GpuPrimitivesDesc;
+
+struct R3_GpuPrimitives
+{
+	R3_ComputePipeline scan_reduce_pipeline;
+	R3_ComputePipeline scan_partials_pipeline;
+	R3_ComputePipeline scan_downsweep_pipeline;
+	R3_ComputePipeline compact_pipeline;
+	R3_ComputePipeline radix_histogram_pipeline;
+	R3_ComputePipeline radix_scatter_pipeline;
+	R3_Buffer uniforms;
+	R3_Buffer partials;
+	R3_Buffer histogram;
+	R3_Buffer digit_offsets;
+	R3_Buffer temp_keys;
+	R3_Buffer temp_values;
+
+	uint32 max_count;
+}
+typedef R3_GpuPrimitives;
+
+struct R3_GpuScanParams
+{
+	R3_Buffer* input;
+	R3_Buffer* output; // can't be the same as 'input'
+	uint32 count;
+	bool inclusive;
+}
+typedef R3_GpuScanParams;
+
+struct R3_GpuCompactParams
+{
+	R3_Buffer* input;
+	R3_Buffer* flags; // input[i] is kept if flags[i] != 0
+	R3_Buffer* output;
+	R3_Buffer* out_count; // receives the number of kept elements as its first uint32
+	uint32 count;
+}
+typedef R3_GpuCompactParams;
+
+struct R3_GpuRadixSortParams
+{
+	R3_Buffer* keys;
+	R3_Buffer* values; // optional
+	uint32 count;
+	int32 key_bits; // only the low 'key_bits' bits of the keys are sorted, 0 means 32
+}
+typedef R3_GpuRadixSortParams;
+
+API R3_GpuPrimitives R3_MakeGpuPrimitives(R3_Context* ctx, R3_GpuPrimitivesDesc const* desc);
+API void R3_FreeGpuPrimitives(R3_Context* ctx, R3_GpuPrimitives* prims);
+API void R3_GpuScan(R3_Context* ctx, R3_GpuPrimitives* prims, R3_GpuScanParams const* params);
+// NOTE(ljre): Keeps the relative order of the kept elements.
+API void R3_GpuCompact(R3_Context* ctx, R3_GpuPrimitives* prims, R3_GpuCompactParams const* params);
+// NOTE(ljre): Sorts in place. Passes ping-pong with buffers inside 'prims', so the contents of 'keys' and
+//             'values' are undefined until the GPU is done.
+API void R3_GpuRadixSort(R3_Context* ctx, R3_GpuPrimitives* prims, R3_GpuRadixSortParams const* params);
+
+// =============================================================================
+// =============================================================================
+// Mesh optimization
+// NOTE(ljre): These work on CPU-side triangle lists with 32-bit indices and don't touch the GPU, so they can
+//             be run either offline or right before R3_MakeBuffer. Use R3_CompactIndices last to get the
+//             smallest index format the mesh fits in.
+struct R3_MeshOptimizeDesc
+{
+	uint32* indices; // in/out
+	intz index_count;
+	void* vertices; // in/out
+	intz vertex_count;
+	uint32 vertex_stride;
+	uint32 position_offset; // byte offset of a R3_Format_F32x3 position inside each vertex
+
+	int32 cache_size; // 0 means 16
+	float32 overdraw_threshold; // max allowed ACMR increase when reordering for overdraw. 0 means 1.05
+
+	bool flag_vertex_cache;
+	bool flag_overdraw;
+	bool flag_vertex_fetch;
+}
+typedef R3_MeshOptimizeDesc;
+
+struct R3_MeshOptimizeStats
+{
+	// NOTE(ljre): ACMR = average cache miss ratio, vertex shader invocations per triangle (0.5 is ideal).
+	//             ATVR = average transformed vertex ratio, invocations per unique vertex (1.0 is ideal).
+	float32 acmr_before, acmr_after;
+	float32 atvr_before, atvr_after;
+	intz vertex_count; // vertex count after R3_OptimizeVertexFetch dropped unreferenced vertices
+	intz cluster_count;
+}
+typedef R3_MeshOptimizeStats;
+
+API R3_MeshOptimizeStats R3_OptimizeMesh(R3_MeshOptimizeDesc const* desc);
+
+API float32 R3_AnalyzeVertexCache  (uint32 const* indices, intz index_count, intz vertex_count, int32 cache_size, float32* out_atvr);
+API intz    R3_OptimizeVertexCache (uint32* dst, uint32 const* indices, intz index_count, intz vertex_count, int32 cache_size, uint32* out_clusters);
+API void    R3_OptimizeOverdraw    (uint32* dst, uint32 const* indices, intz index_count, uint32 const* clusters, intz cluster_count, void const* vertices, intz vertex_count, uint32 vertex_stride, uint32 position_offset, int32 cache_size, float32 threshold);
+API intz    R3_OptimizeVertexFetch (void* dst_vertices, uint32* indices, intz index_count, void const* vertices, intz vertex_count, uint32 vertex_stride);
+// NOTE(ljre): Writes the indices as U16 if they all fit, U32 otherwise. 'dst' can be the same as 'indices'.
+//             Returns the format to use in R3_VertexInputs::index_format.
+API R3_Format R3_CompactIndices(void* dst, uint32 const* indices, intz index_count);
+
 // =============================================================================
 // =============================================================================
 // Font drawing
@@ -0,0 +1,1109 @@
+#include <base/base.h>
+#include <base/base_intrinsics.h>
+#include <base/base_assert.h>
+#include <base/base_string.h>
+#include <base/base_arena.h>
+#include <layer_os/api.h>
+#include "api.h"
+
+// NOTE(ljre): A capture is this header followed by commands. Each command is its R3_CaptureOp and the size of
+//             its payload, both as uint32, then the payload. Handles are written as their capture ids, 0 being
+//             NULL; blobs as their size followed by the bytes.
+#define CAPTURE_MAGIC_ 0x50433352u // "R3CP"
+#define CAPTURE_VERSION_ 1u
+
+struct CaptureHeader_
+{
+	uint32 magic;
+	uint32 version;
+	uint32 id_count;
+	uint32 frame_count;
+}
+typedef CaptureHeader_;
+
+static void
+CaptureWrite_(R3_Capture* capture, void const* data, uintz size)
+{
+	if (capture->size + size > capture->capacity)
+	{
+		capture->overflowed = true;
+		return;
+	}
+	if (size)
+		MemoryCopy(capture->data + capture->size, data, size);
+	capture->size += size;
+}
+
+static void
+CaptureWriteU32_(R3_Capture* capture, uint32 value)
+{
+	CaptureWrite_(capture, &value, sizeof(value));
+}
+
+static void
+CaptureWriteBlob_(R3_Capture* capture, void const* data, uintz size)
+{
+	CaptureWriteU32_(capture, (uint32)size);
+	CaptureWrite_(capture, data, size);
+}
+
+static uint32
+CaptureTextureId_(R3_Texture const* texture)
+{ return texture ? texture->capture_id : 0; }
+
+static uint32
+CaptureBufferId_(R3_Buffer const* buffer)
+{ return buffer ? buffer->capture_id : 0; }
+
+// NOTE(ljre): Where the id lives in the handle a call takes, or NULL if the call takes none.
+static uint32*
+CaptureIdField_(R3_CaptureOp op, void* object)
+{
+	if (!object)
+		return NULL;
+
+	switch (op)
+	{
+		case R3_CaptureOp_MakeTexture:
+		case R3_CaptureOp_FreeTexture:
+		case R3_CaptureOp_UpdateTexture:
+		case R3_CaptureOp_ResolveTexture:
+		case R3_CaptureOp_CopyTexture2D:
+			return &((R3_Texture*)object)->capture_id;
+		case R3_CaptureOp_MakeBuffer:
+		case R3_CaptureOp_FreeBuffer:
+		case R3_CaptureOp_UpdateBuffer:
+		case R3_CaptureOp_DrawIndirect:
+		case R3_CaptureOp_DrawIndexedIndirect:
+		case R3_CaptureOp_DispatchIndirect:
+		case R3_CaptureOp_CopyBuffer:
+			return &((R3_Buffer*)object)->capture_id;
+		case R3_CaptureOp_MakeRenderTarget:
+		case R3_CaptureOp_FreeRenderTarget:
+		case R3_CaptureOp_SetRenderTarget:
+			return &((R3_RenderTarget*)object)->capture_id;
+		case R3_CaptureOp_MakePipeline:
+		case R3_CaptureOp_FreePipeline:
+		case R3_CaptureOp_SetPipeline:
+			return &((R3_Pipeline*)object)->capture_id;
+		case R3_CaptureOp_MakeComputePipeline:
+		case R3_CaptureOp_FreeComputePipeline:
+		case R3_CaptureOp_SetComputePipeline:
+			return &((R3_ComputePipeline*)object)->capture_id;
+		case R3_CaptureOp_MakeSampler:
+		case R3_CaptureOp_FreeSampler:
+			return &((R3_Sampler*)object)->capture_id;
+		case R3_CaptureOp_MakeQuery:
+		case R3_CaptureOp_FreeQuery:
+		case R3_CaptureOp_WriteTimestamp:
+		case R3_CaptureOp_BeginQuery:
+		case R3_CaptureOp_EndQuery:
+		case R3_CaptureOp_BeginConditionalRender:
+			return &((R3_Query*)object)->capture_id;
+		default: return NULL;
+	}
+}
+
+static void
+CaptureWriteMakeCall_(R3_Capture* capture, R3_CaptureCall const* call)
+{
+	switch (call->op)
+	{
+		case R3_CaptureOp_MakeTexture:
+		{
+			R3_TextureDesc const* desc = call->desc;
+			int32 fields[] = {
+				desc->width, desc->height, desc->depth, desc->format, desc->usage, (int32)desc->binding_flags,
+				desc->mipmap_count, desc->sample_count, desc->flag_cubemap,
+			};
+			CaptureWrite_(capture, fields, sizeof(fields));
+
+			// NOTE(ljre): Initial data is the first mip of every layer.
+			uint64 initial_size = 0;
+			if (desc->initial_data)
+			{
+				R3_TextureDesc base = *desc;
+				base.mipmap_count = 1;
+				base.sample_count = 1;
+				initial_size = R3_EstimateTextureSize(&base);
+			}
+			CaptureWriteBlob_(capture, desc->initial_data, initial_size);
+		} break;
+		case R3_CaptureOp_MakeBuffer:
+		{
+			R3_BufferDesc const* desc = call->desc;
+			uint32 fields[] = { desc->size, desc->binding_flags, desc->usage, desc->struct_size };
+			CaptureWrite_(capture, fields, sizeof(fields));
+			CaptureWriteBlob_(capture, desc->initial_data, desc->initial_data ? desc->size : 0);
+		} break;
+		case R3_CaptureOp_MakeRenderTarget:
+		{
+			R3_RenderTargetDesc const* desc = call->desc;
+			for (intz i = 0; i < ArrayLength(desc->color_textures); ++i)
+				CaptureWriteU32_(capture, CaptureTextureId_(desc->color_textures[i]));
+			CaptureWriteU32_(capture, CaptureTextureId_(desc->depth_stencil_texture));
+		} break;
+		case R3_CaptureOp_MakePipeline:
+		{
+			R3_PipelineDesc const* desc = call->desc;
+			uint8 flags[] = { desc->flag_cw_frontface, desc->flag_depth_test, desc->flag_async, desc->flag_scissor };
+			CaptureWrite_(capture, flags, sizeof(flags));
+			for (intz i = 0; i < ArrayLength(desc->rendertargets); ++i)
+			{
+				int32 fields[] = {
+					desc->rendertargets[i].enable_blend,
+					desc->rendertargets[i].src, desc->rendertargets[i].dst, desc->rendertargets[i].op,
+					desc->rendertargets[i].src_alpha, desc->rendertargets[i].dst_alpha, desc->rendertargets[i].op_alpha,
+				};
+				CaptureWrite_(capture, fields, sizeof(fields));
+			}
+			CaptureWriteU32_(capture, desc->fill_mode);
+			CaptureWriteU32_(capture, desc->cull_mode);
+
+			Buffer const sources[] = {
+				desc->glsl.vs, desc->glsl.fs, desc->glsl.defines,
+				desc->dx50.vs, desc->dx50.ps,
+				desc->dx40.vs, desc->dx40.ps,
+				desc->dx40_93.vs, desc->dx40_93.ps,
+				desc->dx40_91.vs, desc->dx40_91.ps,
+			};
+			for (intz i = 0; i < ArrayLength(sources); ++i)
+				CaptureWriteBlob_(capture, sources[i].data, sources[i].size);
+			CaptureWrite_(capture, desc->input_layout, sizeof(desc->input_layout));
+		} break;
+		case R3_CaptureOp_MakeComputePipeline:
+		{
+			R3_ComputePipelineDesc const* desc = call->desc;
+			CaptureWriteBlob_(capture, desc->glsl.data, desc->glsl.size);
+			CaptureWriteBlob_(capture, desc->dx50.data, desc->dx50.size);
+			CaptureWriteBlob_(capture, desc->dx40.data, desc->dx40.size);
+		} break;
+		case R3_CaptureOp_MakeSampler:
+		{
+			R3_SamplerDesc const* desc = call->desc;
+			CaptureWriteU32_(capture, desc->filtering);
+			CaptureWrite_(capture, &desc->anisotropy, sizeof(desc->anisotropy));
+		} break;
+		case R3_CaptureOp_MakeQuery: CaptureWriteU32_(capture, call->args[0]); break;
+		default: SafeAssert(false);
+	}
+}
+
+static void
+CaptureWriteBindings_(R3_Capture* capture, R3_CaptureCall const* call)
+{
+	CaptureWriteU32_(capture, (uint32)call->count);
+	for (intz i = 0; i < call->count; ++i)
+	{
+		switch (call->op)
+		{
+			case R3_CaptureOp_SetUniformBuffers:
+			case R3_CaptureOp_SetComputeUniformBuffers:
+			{
+				R3_UniformBuffer const* ubo = &((R3_UniformBuffer const*)call->array)[i];
+				uint32 fields[] = { CaptureBufferId_(ubo->buffer), ubo->size, ubo->offset };
+				CaptureWrite_(capture, fields, sizeof(fields));
+			} break;
+			case R3_CaptureOp_SetResourceViews:
+			case R3_CaptureOp_SetComputeResourceViews:
+			{
+				R3_ResourceView const* view = &((R3_ResourceView const*)call->array)[i];
+				uint32 fields[] = { CaptureBufferId_(view->buffer), CaptureTextureId_(view->texture) };
+				CaptureWrite_(capture, fields, sizeof(fields));
+			} break;
+			case R3_CaptureOp_SetComputeUnorderedViews:
+			{
+				R3_UnorderedView const* view = &((R3_UnorderedView const*)call->array)[i];
+				uint32 fields[] = { CaptureBufferId_(view->buffer), CaptureTextureId_(view->texture), (uint32)view->mip };
+				CaptureWrite_(capture, fields, sizeof(fields));
+			} break;
+			case R3_CaptureOp_SetSamplers:
+			{
+				R3_Sampler* const* samplers = call->array;
+				CaptureWriteU32_(capture, samplers[i] ? samplers[i]->capture_id : 0);
+			} break;
+			default: SafeAssert(false);
+		}
+	}
+}
+
+static void
+CaptureWriteCall_(R3_Capture* capture, R3_CaptureCall const* call)
+{
+	uint32* id = CaptureIdField_(call->op, call->object);
+	uint32* other_id = CaptureIdField_(call->op, call->other);
+
+	switch (call->op)
+	{
+		case R3_CaptureOp_MakeTexture:
+		case R3_CaptureOp_MakeBuffer:
+		case R3_CaptureOp_MakeRenderTarget:
+		case R3_CaptureOp_MakePipeline:
+		case R3_CaptureOp_MakeComputePipeline:
+		case R3_CaptureOp_MakeSampler:
+		case R3_CaptureOp_MakeQuery:
+		{
+			*id = ++capture->next_id;
+			CaptureWriteU32_(capture, *id);
+			CaptureWriteMakeCall_(capture, call);
+		} break;
+
+		case R3_CaptureOp_FreeTexture:
+		case R3_CaptureOp_FreeBuffer:
+		case R3_CaptureOp_FreeRenderTarget:
+		case R3_CaptureOp_FreePipeline:
+		case R3_CaptureOp_FreeComputePipeline:
+		case R3_CaptureOp_FreeSampler:
+		case R3_CaptureOp_FreeQuery:
+		case R3_CaptureOp_SetPipeline:
+		case R3_CaptureOp_SetRenderTarget:
+		case R3_CaptureOp_SetComputePipeline:
+		case R3_CaptureOp_WriteTimestamp:
+		case R3_CaptureOp_BeginQuery:
+		case R3_CaptureOp_EndQuery:
+		case R3_CaptureOp_BeginConditionalRender:
+			CaptureWriteU32_(capture, id ? *id : 0);
+			break;
+
+		case R3_CaptureOp_UpdateBuffer:
+		case R3_CaptureOp_UpdateTexture:
+		{
+			CaptureWriteU32_(capture, id ? *id : 0);
+			CaptureWriteU32_(capture, call->args[0]); // slice
+			CaptureWriteBlob_(capture, call->memory, call->size);
+		} break;
+
+		case R3_CaptureOp_SetViewports:
+		{
+			CaptureWriteU32_(capture, (uint32)call->count);
+			CaptureWrite_(capture, call->array, sizeof(R3_Viewport) * call->count);
+		} break;
+		case R3_CaptureOp_SetScissorRects:
+		{
+			CaptureWriteU32_(capture, (uint32)call->count);
+			CaptureWrite_(capture, call->array, sizeof(R3_ScissorRect) * call->count);
+		} break;
+		case R3_CaptureOp_SetVertexInputs:
+		{
+			R3_VertexInputs const* desc = call->desc;
+			CaptureWriteU32_(capture, CaptureBufferId_(desc->ibuffer));
+			CaptureWriteU32_(capture, desc->index_format);
+			for (intz i = 0; i < ArrayLength(desc->vbuffers); ++i)
+			{
+				uint32 fields[] = { CaptureBufferId_(desc->vbuffers[i].buffer), desc->vbuffers[i].offset, desc->vbuffers[i].stride };
+				CaptureWrite_(capture, fields, sizeof(fields));
+			}
+		} break;
+		case R3_CaptureOp_SetUniformBuffers:
+		case R3_CaptureOp_SetResourceViews:
+		case R3_CaptureOp_SetSamplers:
+		case R3_CaptureOp_SetComputeUniformBuffers:
+		case R3_CaptureOp_SetComputeResourceViews:
+		case R3_CaptureOp_SetComputeUnorderedViews:
+			CaptureWriteBindings_(capture, call);
+			break;
+		case R3_CaptureOp_Clear: CaptureWrite_(capture, call->desc, sizeof(R3_ClearDesc)); break;
+		case R3_CaptureOp_BeginRenderPass:
+		{
+			R3_RenderPassDesc const* desc = call->desc;
+			for (intz i = 0; i < ArrayLength(desc->color_textures); ++i)
+				CaptureWriteU32_(capture, CaptureTextureId_(desc->color_textures[i]));
+			CaptureWriteU32_(capture, CaptureTextureId_(desc->depth_stencil_texture));
+			CaptureWrite_(capture, desc->colors, sizeof(desc->colors));
+			CaptureWrite_(capture, &desc->depth_stencil, sizeof(desc->depth_stencil));
+		} break;
+
+		case R3_CaptureOp_SetPrimitiveType:
+		case R3_CaptureOp_Draw:
+		case R3_CaptureOp_DrawIndexed:
+		case R3_CaptureOp_Dispatch:
+			CaptureWrite_(capture, call->args, sizeof(call->args));
+			break;
+		case R3_CaptureOp_DrawIndirect:
+		case R3_CaptureOp_DrawIndexedIndirect:
+		case R3_CaptureOp_DispatchIndirect:
+		{
+			CaptureWriteU32_(capture, id ? *id : 0);
+			CaptureWriteU32_(capture, call->args[0]); // offset
+		} break;
+
+		case R3_CaptureOp_CopyBuffer:
+		case R3_CaptureOp_ResolveTexture:
+		case R3_CaptureOp_CopyTexture2D:
+		{
+			CaptureWriteU32_(capture, id ? *id : 0);
+			CaptureWriteU32_(capture, other_id ? *other_id : 0);
+			CaptureWrite_(capture, call->args, sizeof(call->args));
+		} break;
+
+		case R3_CaptureOp_PushDebugGroup: CaptureWriteBlob_(capture, call->name.data, call->name.size); break;
+
+		case R3_CaptureOp_EndRenderPass:
+		case R3_CaptureOp_EndConditionalRender:
+		case R3_CaptureOp_PopDebugGroup:
+		case R3_CaptureOp_ResizeBuffers:
+		case R3_CaptureOp_Present:
+			break;
+
+		default: SafeAssert(false);
+	}
+}
+
+//------------------------------------------------------------------------
+struct ReplayReader_
+{
+	uint8 const* data;
+	uintz size;
+	uintz offset;
+	bool failed;
+}
+typedef ReplayReader_;
+
+static void
+ReplayRead_(ReplayReader_* r, void* out, uintz size)
+{
+	if (r->failed || size > r->size - r->offset)
+	{
+		r->failed = true;
+		MemoryZero(out, size);
+		return;
+	}
+	MemoryCopy(out, r->data + r->offset, size);
+	r->offset += size;
+}
+
+static uint32
+ReplayReadU32_(ReplayReader_* r)
+{
+	uint32 value;
+	ReplayRead_(r, &value, sizeof(value));
+	return value;
+}
+
+// NOTE(ljre): Points into the capture itself, nothing is copied. Empty blobs are NULL.
+static Buffer
+ReplayReadBlob_(ReplayReader_* r)
+{
+	uint32 size = ReplayReadU32_(r);
+	if (r->failed || size > r->size - r->offset)
+	{
+		r->failed = true;
+		return (Buffer) {};
+	}
+	Buffer result = { .data = size ? r->data + r->offset : NULL, .size = size };
+	r->offset += size;
+	return result;
+}
+
+struct ReplayObject_
+{
+	R3_CaptureOp made_by; // R3_CaptureOp_Null while not alive
+	union
+	{
+		R3_Texture texture;
+		R3_Buffer buffer;
+		R3_RenderTarget rendertarget;
+		R3_Pipeline pipeline;
+		R3_ComputePipeline compute_pipeline;
+		R3_Sampler sampler;
+		R3_Query query;
+	};
+}
+typedef ReplayObject_;
+
+struct ReplayState_
+{
+	R3_Context* ctx;
+	ReplayReader_ r;
+	ReplayObject_* objects;
+	uint32 object_count;
+}
+typedef ReplayState_;
+
+static ReplayObject_*
+ReplayFind_(ReplayState_* state, uint32 id, R3_CaptureOp made_by)
+{
+	if (id == 0 || id >= state->object_count || state->objects[id].made_by != made_by)
+		return NULL;
+	return &state->objects[id];
+}
+
+static R3_Texture*
+ReplayTexture_(ReplayState_* state, uint32 id)
+{
+	ReplayObject_* object = ReplayFind_(state, id, R3_CaptureOp_MakeTexture);
+	return object ? &object->texture : NULL;
+}
+
+static R3_Buffer*
+ReplayBuffer_(ReplayState_* state, uint32 id)
+{
+	ReplayObject_* object = ReplayFind_(state, id, R3_CaptureOp_MakeBuffer);
+	return object ? &object->buffer : NULL;
+}
+
+static R3_Query*
+ReplayQuery_(ReplayState_* state, uint32 id)
+{
+	ReplayObject_* object = ReplayFind_(state, id, R3_CaptureOp_MakeQuery);
+	return object ? &object->query : NULL;
+}
+
+// NOTE(ljre): Made objects go to their slot as long as the id is in range. Every other call on a missing handle
+//             is skipped, like a handle made before the capture began.
+static ReplayObject_*
+ReplayNewObject_(ReplayState_* state, uint32 id, R3_CaptureOp made_by)
+{
+	if (id == 0 || id >= state->object_count || state->objects[id].made_by != R3_CaptureOp_Null)
+	{
+		state->r.failed = true;
+		return NULL;
+	}
+	state->objects[id].made_by = made_by;
+	return &state->objects[id];
+}
+
+static void
+ReplayFreeObject_(ReplayState_* state, ReplayObject_* object)
+{
+	R3_Context* ctx = state->ctx;
+	switch (object->made_by)
+	{
+		case R3_CaptureOp_MakeTexture: R3_FreeTexture(ctx, &object->texture); break;
+		case R3_CaptureOp_MakeBuffer: R3_FreeBuffer(ctx, &object->buffer); break;
+		case R3_CaptureOp_MakeRenderTarget: R3_FreeRenderTarget(ctx, &object->rendertarget); break;
+		case R3_CaptureOp_MakePipeline: R3_FreePipeline(ctx, &object->pipeline); break;
+		case R3_CaptureOp_MakeComputePipeline: R3_FreeComputePipeline(ctx, &object->compute_pipeline); break;
+		case R3_CaptureOp_MakeSampler: R3_FreeSampler(ctx, &object->sampler); break;
+		case R3_CaptureOp_MakeQuery: R3_FreeQuery(ctx, &object->query); break;
+		default: break;
+	}
+	object->made_by = R3_CaptureOp_Null;
+}
+
+// NOTE(ljre): Bytes the backends read for the first mip of 'depth' layers, as in initial data and updates.
+static uint64
+ReplayTextureDataSize_(int32 width, int32 height, int32 depth, R3_Format format)
+{
+	R3_TextureDesc desc = {
+		.width = width,
+		.height = height,
+		.depth = depth,
+		.format = format,
+		.mipmap_count = 1,
+	};
+	return R3_EstimateTextureSize(&desc);
+}
+
+static void
+ReplayMake_(ReplayState_* state, R3_CaptureOp op)
+{
+	R3_Context* ctx = state->ctx;
+	ReplayReader_* r = &state->r;
+	uint32 id = ReplayReadU32_(r);
+
+	switch (op)
+	{
+		case R3_CaptureOp_MakeTexture:
+		{
+			int32 fields[9];
+			ReplayRead_(r, fields, sizeof(fields));
+			Buffer initial_data = ReplayReadBlob_(r);
+			R3_TextureDesc desc = {
+				.width = fields[0],
+				.height = fields[1],
+				.depth = fields[2],
+				.format = (R3_Format)fields[3],
+				.usage = (R3_Usage)fields[4],
+				.binding_flags = (uint32)fields[5],
+				.mipmap_count = fields[6],
+				.sample_count = fields[7],
+				.flag_cubemap = fields[8],
+				.initial_data = initial_data.data,
+			};
+			if (initial_data.size && (uint64)initial_data.size != ReplayTextureDataSize_(desc.width, desc.height, desc.depth, desc.format))
+				r->failed = true;
+			ReplayObject_* object = r->failed ? NULL : ReplayNewObject_(state, id, op);
+			if (object)
+				object->texture = R3_MakeTexture(ctx, &desc);
+		} break;
+		case R3_CaptureOp_MakeBuffer:
+		{
+			uint32 fields[4];
+			ReplayRead_(r, fields, sizeof(fields));
+			Buffer initial_data = ReplayReadBlob_(r);
+			R3_BufferDesc desc = {
+				.size = fields[0],
+				.binding_flags = fields[1],
+				.usage = (R3_Usage)fields[2],
+				.struct_size = fields[3],
+				.initial_data = initial_data.data,
+			};
+			if (initial_data.size && initial_data.size != desc.size)
+				r->failed = true;
+			ReplayObject_* object = r->failed ? NULL : ReplayNewObject_(state, id, op);
+			if (object)
+				object->buffer = R3_MakeBuffer(ctx, &desc);
+		} break;
+		case R3_CaptureOp_MakeRenderTarget:
+		{
+			R3_RenderTargetDesc desc = {};
+			for (intz i = 0; i < ArrayLength(desc.color_textures); ++i)
+				desc.color_textures[i] = ReplayTexture_(state, ReplayReadU32_(r));
+			desc.depth_stencil_texture = ReplayTexture_(state, ReplayReadU32_(r));
+			ReplayObject_* object = r->failed ? NULL : ReplayNewObject_(state, id, op);
+			if (object)
+				object->rendertarget = R3_MakeRenderTarget(ctx, &desc);
+		} break;
+		case R3_CaptureOp_MakePipeline:
+		{
+			R3_PipelineDesc desc = {};
+			uint8 flags[4];
+			ReplayRead_(r, flags, sizeof(flags));
+			desc.flag_cw_frontface = flags[0];
+			desc.flag_depth_test = flags[1];
+			desc.flag_async = false; // see the note in the header
+			desc.flag_scissor = flags[3];
+			for (intz i = 0; i < ArrayLength(desc.rendertargets); ++i)
+			{
+				int32 fields[7];
+				ReplayRead_(r, fields, sizeof(fields));
+				desc.rendertargets[i].enable_blend = fields[0];
+				desc.rendertargets[i].src = (R3_BlendFunc)fields[1];
+				desc.rendertargets[i].dst = (R3_BlendFunc)fields[2];
+				desc.rendertargets[i].op = (R3_BlendOp)fields[3];
+				desc.rendertargets[i].src_alpha = (R3_BlendFunc)fields[4];
+				desc.rendertargets[i].dst_alpha = (R3_BlendFunc)fields[5];
+				desc.rendertargets[i].op_alpha = (R3_BlendOp)fields[6];
+			}
+			desc.fill_mode = (R3_FillMode)ReplayReadU32_(r);
+			desc.cull_mode = (R3_CullMode)ReplayReadU32_(r);
+
+			Buffer* const sources[] = {
+				&desc.glsl.vs, &desc.glsl.fs, &desc.glsl.defines,
+				&desc.dx50.vs, &desc.dx50.ps,
+				&desc.dx40.vs, &desc.dx40.ps,
+				&desc.dx40_93.vs, &desc.dx40_93.ps,
+				&desc.dx40_91.vs, &desc.dx40_91.ps,
+			};
+			for (intz i = 0; i < ArrayLength(sources); ++i)
+				*sources[i] = ReplayReadBlob_(r);
+			ReplayRead_(r, desc.input_layout, sizeof(desc.input_layout));
+
+			ReplayObject_* object = r->failed ? NULL : ReplayNewObject_(state, id, op);
+			if (object)
+				object->pipeline = R3_MakePipeline(ctx, &desc);
+		} break;
+		case R3_CaptureOp_MakeComputePipeline:
+		{
+			R3_ComputePipelineDesc desc = {
+				.glsl = ReplayReadBlob_(r),
+				.dx50 = ReplayReadBlob_(r),
+				.dx40 = ReplayReadBlob_(r),
+			};
+			ReplayObject_* object = r->failed ? NULL : ReplayNewObject_(state, id, op);
+			if (object)
+				object->compute_pipeline = R3_MakeComputePipeline(ctx, &desc);
+		} break;
+		case R3_CaptureOp_MakeSampler:
+		{
+			R3_SamplerDesc desc = {};
+			desc.filtering = (R3_TextureFiltering)ReplayReadU32_(r);
+			ReplayRead_(r, &desc.anisotropy, sizeof(desc.anisotropy));
+			ReplayObject_* object = r->failed ? NULL : ReplayNewObject_(state, id, op);
+			if (object)
+				object->sampler = R3_MakeSampler(ctx, &desc);
+		} break;
+		case R3_CaptureOp_MakeQuery:
+		{
+			R3_QueryKind kind = (R3_QueryKind)ReplayReadU32_(r);
+			ReplayObject_* object = r->failed ? NULL : ReplayNewObject_(state, id, op);
+			if (object)
+				object->query = R3_MakeQuery(ctx, kind);
+		} break;
+		default: SafeAssert(false);
+	}
+}
+
+// NOTE(ljre): Bindings go through a scratch array, at most 'max_count' of them.
+static intz
+ReplayReadCount_(ReplayReader_* r, intz max_count)
+{
+	uint32 count = ReplayReadU32_(r);
+	if (count > max_count)
+	{
+		r->failed = true;
+		return 0;
+	}
+	return count;
+}
+
+static void
+ReplayCommand_(ReplayState_* state, R3_CaptureOp op)
+{
+	R3_Context* ctx = state->ctx;
+	ReplayReader_* r = &state->r;
+
+	switch (op)
+	{
+		case R3_CaptureOp_MakeTexture:
+		case R3_CaptureOp_MakeBuffer:
+		case R3_CaptureOp_MakeRenderTarget:
+		case R3_CaptureOp_MakePipeline:
+		case R3_CaptureOp_MakeComputePipeline:
+		case R3_CaptureOp_MakeSampler:
+		case R3_CaptureOp_MakeQuery:
+			ReplayMake_(state, op);
+			break;
+
+		case R3_CaptureOp_FreeTexture:
+		case R3_CaptureOp_FreeBuffer:
+		case R3_CaptureOp_FreeRenderTarget:
+		case R3_CaptureOp_FreePipeline:
+		case R3_CaptureOp_FreeComputePipeline:
+		case R3_CaptureOp_FreeSampler:
+		case R3_CaptureOp_FreeQuery:
+		{
+			// NOTE(ljre): The Free ops are in the same order as the Make ones.
+			R3_CaptureOp made_by = (R3_CaptureOp)(op - R3_CaptureOp_FreeTexture + R3_CaptureOp_MakeTexture);
+			ReplayObject_* object = ReplayFind_(state, ReplayReadU32_(r), made_by);
+			if (object)
+				ReplayFreeObject_(state, object);
+		} break;
+
+		case R3_CaptureOp_UpdateBuffer:
+		case R3_CaptureOp_UpdateTexture:
+		{
+			uint32 id = ReplayReadU32_(r);
+			uint32 slice = ReplayReadU32_(r);
+			Buffer memory = ReplayReadBlob_(r);
+			// NOTE(ljre): A blob that doesn't match its target means the capture is corrupt. Don't let the backend
+			//             read past it.
+			if (op == R3_CaptureOp_UpdateBuffer)
+			{
+				R3_Buffer* buffer = ReplayBuffer_(state, id);
+				if (buffer && memory.size > buffer->size)
+					r->failed = true;
+				else if (buffer)
+					R3_UpdateBuffer(ctx, buffer, memory.data, (uint32)memory.size);
+			}
+			else
+			{
+				R3_Texture* texture = ReplayTexture_(state, id);
+				if (texture && (uint64)memory.size != ReplayTextureDataSize_(texture->width, texture->height, 1, texture->format))
+					r->failed = true;
+				else if (texture)
+					R3_UpdateTexture(ctx, texture, memory.data, (uint32)memory.size, slice);
+			}
+		} break;
+
+		case R3_CaptureOp_SetViewports:
+		{
+			R3_Viewport viewports[16];
+			intz count = ReplayReadCount_(r, ArrayLength(viewports));
+			ReplayRead_(r, viewports, sizeof(viewports[0]) * count);
+			R3_SetViewports(ctx, count, viewports);
+		} break;
+		case R3_CaptureOp_SetScissorRects:
+		{
+			R3_ScissorRect rects[16];
+			intz count = ReplayReadCount_(r, ArrayLength(rects));
+			ReplayRead_(r, rects, sizeof(rects[0]) * count);
+			R3_SetScissorRects(ctx, count, rects);
+		} break;
+		case R3_CaptureOp_SetPipeline:
+		{
+			ReplayObject_* object = ReplayFind_(state, ReplayReadU32_(r), R3_CaptureOp_MakePipeline);
+			if (object)
+				R3_SetPipeline(ctx, &object->pipeline);
+		} break;
+		case R3_CaptureOp_SetRenderTarget:
+		{
+			ReplayObject_* object = ReplayFind_(state, ReplayReadU32_(r), R3_CaptureOp_MakeRenderTarget);
+			R3_SetRenderTarget(ctx, object ? &object->rendertarget : NULL);
+		} break;
+		case R3_CaptureOp_SetComputePipeline:
+		{
+			ReplayObject_* object = ReplayFind_(state, ReplayReadU32_(r), R3_CaptureOp_MakeComputePipeline);
+			if (object)
+				R3_SetComputePipeline(ctx, &object->compute_pipeline);
+		} break;
+		case R3_CaptureOp_SetVertexInputs:
+		{
+			R3_VertexInputs desc = {};
+			desc.ibuffer = ReplayBuffer_(state, ReplayReadU32_(r));
+			desc.index_format = (R3_Format)ReplayReadU32_(r);
+			for (intz i = 0; i < ArrayLength(desc.vbuffers); ++i)
+			{
+				desc.vbuffers[i].buffer = ReplayBuffer_(state, ReplayReadU32_(r));
+				desc.vbuffers[i].offset = ReplayReadU32_(r);
+				desc.vbuffers[i].stride = ReplayReadU32_(r);
+			}
+			R3_SetVertexInputs(ctx, &desc);
+		} break;
+		case R3_CaptureOp_SetUniformBuffers:
+		case R3_CaptureOp_SetComputeUniformBuffers:
+		{
+			R3_UniformBuffer buffers[16];
+			intz count = ReplayReadCount_(r, ArrayLength(buffers));
+			for (intz i = 0; i < count; ++i)
+			{
+				buffers[i].buffer = ReplayBuffer_(state, ReplayReadU32_(r));
+				buffers[i].size = ReplayReadU32_(r);
+				buffers[i].offset = ReplayReadU32_(r);
+			}
+			if (op == R3_CaptureOp_SetUniformBuffers)
+				R3_SetUniformBuffers(ctx, count, buffers);
+			else
+				R3_SetComputeUniformBuffers(ctx, count, buffers);
+		} break;
+		case R3_CaptureOp_SetResourceViews:
+		case R3_CaptureOp_SetComputeResourceViews:
+		{
+			R3_ResourceView views[32];
+			intz count = ReplayReadCount_(r, ArrayLength(views));
+			for (intz i = 0; i < count; ++i)
+			{
+				views[i].buffer = ReplayBuffer_(state, ReplayReadU32_(r));
+				views[i].texture = ReplayTexture_(state, ReplayReadU32_(r));
+			}
+			if (op == R3_CaptureOp_SetResourceViews)
+				R3_SetResourceViews(ctx, count, views);
+			else
+				R3_SetComputeResourceViews(ctx, count, views);
+		} break;
+		case R3_CaptureOp_SetComputeUnorderedViews:
+		{
+			R3_UnorderedView views[16];
+			intz count = ReplayReadCount_(r, ArrayLength(views));
+			for (intz i = 0; i < count; ++i)
+			{
+				views[i].buffer = ReplayBuffer_(state, ReplayReadU32_(r));
+				views[i].texture = ReplayTexture_(state, ReplayReadU32_(r));
+				views[i].mip = (int32)ReplayReadU32_(r);
+			}
+			R3_SetComputeUnorderedViews(ctx, count, views);
+		} break;
+		case R3_CaptureOp_SetSamplers:
+		{
+			R3_Sampler* samplers[32];
+			intz count = ReplayReadCount_(r, ArrayLength(samplers));
+			for (intz i = 0; i < count; ++i)
+			{
+				ReplayObject_* object = ReplayFind_(state, ReplayReadU32_(r), R3_CaptureOp_MakeSampler);
+				samplers[i] = object ? &object->sampler : NULL;
+			}
+			R3_SetSamplers(ctx, count, samplers);
+		} break;
+		case R3_CaptureOp_Clear:
+		{
+			R3_ClearDesc desc;
+			ReplayRead_(r, &desc, sizeof(desc));
+			R3_Clear(ctx, &desc);
+		} break;
+		case R3_CaptureOp_BeginRenderPass:
+		{
+			R3_RenderPassDesc desc = {};
+			for (intz i = 0; i < ArrayLength(desc.color_textures); ++i)
+				desc.color_textures[i] = ReplayTexture_(state, ReplayReadU32_(r));
+			desc.depth_stencil_texture = ReplayTexture_(state, ReplayReadU32_(r));
+			ReplayRead_(r, desc.colors, sizeof(desc.colors));
+			ReplayRead_(r, &desc.depth_stencil, sizeof(desc.depth_stencil));
+			R3_BeginRenderPass(ctx, &desc);
+		} break;
+		case R3_CaptureOp_EndRenderPass: R3_EndRenderPass(ctx); break;
+
+		case R3_CaptureOp_SetPrimitiveType:
+		case R3_CaptureOp_Draw:
+		case R3_CaptureOp_DrawIndexed:
+		case R3_CaptureOp_Dispatch:
+		{
+			uint32 args[8];
+			ReplayRead_(r, args, sizeof(args));
+			if (op == R3_CaptureOp_SetPrimitiveType)
+				R3_SetPrimitiveType(ctx, (R3_PrimitiveType)args[0]);
+			else if (op == R3_CaptureOp_Draw)
+				R3_Draw(ctx, args[0], args[1], args[2], args[3]);
+			else if (op == R3_CaptureOp_DrawIndexed)
+				R3_DrawIndexed(ctx, args[0], args[1], args[2], args[3], (int32)args[4]);
+			else
+				R3_Dispatch(ctx, args[0], args[1], args[2]);
+		} break;
+		case R3_CaptureOp_DrawIndirect:
+		case R3_CaptureOp_DrawIndexedIndirect:
+		case R3_CaptureOp_DispatchIndirect:
+		{
+			R3_Buffer* buffer = ReplayBuffer_(state, ReplayReadU32_(r));
+			uint32 offset = ReplayReadU32_(r);
+			if (!buffer)
+				break;
+			if (op == R3_CaptureOp_DrawIndirect)
+				R3_DrawIndirect(ctx, buffer, offset);
+			else if (op == R3_CaptureOp_DrawIndexedIndirect)
+				R3_DrawIndexedIndirect(ctx, buffer, offset);
+			else
+				R3_DispatchIndirect(ctx, buffer, offset);
+		} break;
+
+		case R3_CaptureOp_CopyBuffer:
+		case R3_CaptureOp_ResolveTexture:
+		case R3_CaptureOp_CopyTexture2D:
+		{
+			uint32 src_id = ReplayReadU32_(r);
+			uint32 dst_id = ReplayReadU32_(r);
+			uint32 args[8];
+			ReplayRead_(r, args, sizeof(args));
+			if (op == R3_CaptureOp_CopyBuffer)
+			{
+				R3_Buffer* src = ReplayBuffer_(state, src_id);
+				R3_Buffer* dst = ReplayBuffer_(state, dst_id);
+				if (src && dst)
+					R3_CopyBuffer(ctx, src, args[0], dst, args[1], args[2]);
+				break;
+			}
+
+			R3_Texture* src = ReplayTexture_(state, src_id);
+			R3_Texture* dst = ReplayTexture_(state, dst_id);
+			if (!src || !dst)
+				break;
+			if (op == R3_CaptureOp_ResolveTexture)
+				R3_ResolveTexture(ctx, src, dst);
+			else
+				R3_CopyTexture2D(ctx, src, args[0], args[1], dst, args[2], args[3], args[4], args[5]);
+		} break;
+
+		case R3_CaptureOp_WriteTimestamp:
+		case R3_CaptureOp_BeginQuery:
+		case R3_CaptureOp_EndQuery:
+		case R3_CaptureOp_BeginConditionalRender:
+		{
+			R3_Query* query = ReplayQuery_(state, ReplayReadU32_(r));
+			if (!query)
+				break;
+			if (op == R3_CaptureOp_WriteTimestamp)
+				R3_WriteTimestamp(ctx, query);
+			else if (op == R3_CaptureOp_BeginQuery)
+				R3_BeginQuery(ctx, query);
+			else if (op == R3_CaptureOp_EndQuery)
+				R3_EndQuery(ctx, query);
+			else
+				R3_BeginConditionalRender(ctx, query);
+		} break;
+		case R3_CaptureOp_EndConditionalRender: R3_EndConditionalRender(ctx); break;
+		case R3_CaptureOp_PushDebugGroup: R3_PushDebugGroup(ctx, ReplayReadBlob_(r)); break;
+		case R3_CaptureOp_PopDebugGroup: R3_PopDebugGroup(ctx); break;
+		case R3_CaptureOp_ResizeBuffers: R3_ResizeBuffers(ctx); break;
+
+		// NOTE(ljre): Unknown ops are skipped by the caller, R3_Present() is handled there too.
+		default: break;
+	}
+}
+
+// NOTE(ljre): Blocks until both timestamps are there. Replay is offline, and by the time a slot is reused the
+//             GPU is a few presents past it anyway.
+static void
+ReplayResolveFrame_(R3_Context* ctx, R3_Query queries[2], R3_ReplayFrame* frame)
+{
+	R3_QueryResult begin, end;
+	while (!R3_GetQueryResult(ctx, &queries[0], &begin) || !R3_GetQueryResult(ctx, &queries[1], &end))
+	{
+		if (R3_IsDeviceLost(ctx))
+			return;
+	}
+
+	if (!begin.disjoint && !end.disjoint && end.timestamp_ns >= begin.timestamp_ns)
+	{
+		frame->gpu_ms = (float64)(end.timestamp_ns - begin.timestamp_ns) / 1000000.0;
+		frame->gpu_timed = true;
+	}
+}
+
+//------------------------------------------------------------------------
+API R3_Capture
+R3_MakeCapture(R3_CaptureDesc const* desc)
+{
+	Trace();
+	R3_Capture out = {};
+	SafeAssert(desc->arena && desc->max_size >= sizeof(CaptureHeader_));
+
+	out.data = ArenaPushArray(desc->arena, uint8, desc->max_size);
+	SafeAssert(out.data);
+	out.capacity = desc->max_size;
+
+	CaptureHeader_ header = {
+		.magic = CAPTURE_MAGIC_,
+		.version = CAPTURE_VERSION_,
+	};
+	CaptureWrite_(&out, &header, sizeof(header));
+	out.frame_end = out.size;
+
+	return out;
+}
+
+API void
+R3_RecordCapture(R3_Capture* capture, R3_CaptureCall const* call)
+{
+	Trace();
+	if (capture->overflowed)
+		return;
+
+	uintz begin = capture->size;
+	uint32 command[2] = { call->op, 0 };
+	CaptureWrite_(capture, command, sizeof(command));
+	CaptureWriteCall_(capture, call);
+
+	if (capture->overflowed)
+	{
+		capture->size = capture->frame_end;
+		return;
+	}
+
+	uint32 payload_size = (uint32)(capture->size - begin - sizeof(command));
+	MemoryCopy(capture->data + begin + sizeof(uint32), &payload_size, sizeof(payload_size));
+	if (call->op == R3_CaptureOp_Present)
+	{
+		++capture->frame_count;
+		capture->frame_end = capture->size;
+	}
+}
+
+API Buffer
+R3_GetCaptureData(R3_Capture* capture)
+{
+	Trace();
+	CaptureHeader_ header = {
+		.magic = CAPTURE_MAGIC_,
+		.version = CAPTURE_VERSION_,
+		.id_count = capture->next_id + 1,
+		.frame_count = capture->frame_count,
+	};
+	MemoryCopy(capture->data, &header, sizeof(header));
+
+	return (Buffer) { .data = capture->data, .size = capture->frame_end };
+}
+
+API R3_ReplayResult
+R3_ReplayCapture(R3_Context* ctx, R3_ReplayDesc const* desc)
+{
+	Trace();
+	R3_ReplayResult result = {};
+	SafeAssert(desc->arena);
+
+	CaptureHeader_ header = {};
+	if ((uintz)desc->data.size >= sizeof(header))
+		MemoryCopy(&header, desc->data.data, sizeof(header));
+	if (header.magic != CAPTURE_MAGIC_ || header.version != CAPTURE_VERSION_ || header.id_count == 0)
+		return result;
+
+	result.frames = ArenaPushArray(desc->arena, R3_ReplayFrame, header.frame_count);
+	SafeAssert(result.frames || !header.frame_count);
+	MemoryZero(result.frames, sizeof(R3_ReplayFrame) * header.frame_count);
+
+	ArenaSavepoint scratch = ArenaSave(OS_ScratchArena(&(Arena*) { desc->arena }, 1));
+	ReplayState_ state = {
+		.ctx = ctx,
+		.r = {
+			.data = desc->data.data,
+			.size = desc->data.size,
+			.offset = sizeof(header),
+		},
+		.objects = ArenaPushArray(scratch.arena, ReplayObject_, header.id_count),
+		.object_count = header.id_count,
+	};
+	SafeAssert(state.objects);
+	MemoryZero(state.objects, sizeof(ReplayObject_) * header.id_count);
+
+	// NOTE(ljre): A pair of timestamps per frame in flight, read back when the slot comes around again.
+	R3_Query timestamps[4][2] = {};
+	int32 pending_frames[ArrayLength(timestamps)];
+	bool gpu_timing = R3_QueryInfo(ctx).has_timestamp_query;
+	for (intz i = 0; i < ArrayLength(timestamps); ++i)
+	{
+		pending_frames[i] = -1;
+		if (gpu_timing)
+		{
+			timestamps[i][0] = R3_MakeQuery(ctx, R3_QueryKind_Timestamp);
+			timestamps[i][1] = R3_MakeQuery(ctx, R3_QueryKind_Timestamp);
+		}
+	}
+
+	uint64 tick_rate = OS_TickRate();
+	uint64 frame_begin = 0;
+	bool frame_open = false;
+	int32 frame_count = 0;
+	ReplayReader_* r = &state.r;
+
+	while (r->offset < r->size && !r->failed && frame_count < (int32)header.frame_count)
+	{
+		R3_CaptureOp op = (R3_CaptureOp)ReplayReadU32_(r);
+		uint32 payload_size = ReplayReadU32_(r);
+		if (r->failed || payload_size > r->size - r->offset)
+		{
+			r->failed = true;
+			break;
+		}
+
+		intz slot = frame_count % ArrayLength(timestamps);
+		if (!frame_open)
+		{
+			if (pending_frames[slot] != -1)
+				ReplayResolveFrame_(ctx, timestamps[slot], &result.frames[pending_frames[slot]]);
+			pending_frames[slot] = -1;
+
+			frame_open = true;
+			frame_begin = OS_CurrentTick();
+			if (gpu_timing)
+				R3_WriteTimestamp(ctx, &timestamps[slot][0]);
+		}
+
+		uintz payload_end = r->offset + payload_size;
+		if (op == R3_CaptureOp_Present)
+		{
+			if (gpu_timing)
+			{
+				R3_WriteTimestamp(ctx, &timestamps[slot][1]);
+				pending_frames[slot] = frame_count;
+			}
+			R3_Present(ctx);
+
+			R3_ReplayFrame* frame = &result.frames[frame_count++];
+			frame->cpu_ms = (float64)(OS_CurrentTick() - frame_begin) * 1000.0 / (float64)tick_rate;
+			frame->stats = R3_GetFrameStats(ctx);
+			frame_open = false;
+		}
+		else
+		{
+			// NOTE(ljre): Limit the reader to this command, so a bad payload can't spill into the next one.
+			r->size = payload_end;
+			ReplayCommand_(&state, op);
+			r->size = desc->data.size;
+		}
+
+		if (!r->failed)
+			r->offset = payload_end;
+	}
+
+	for (intz i = 0; i < ArrayLength(timestamps); ++i)
+	{
+		if (pending_frames[i] != -1)
+			ReplayResolveFrame_(ctx, timestamps[i], &result.frames[pending_frames[i]]);
+		if (gpu_timing)
+		{
+			R3_FreeQuery(ctx, &timestamps[i][0]);
+			R3_FreeQuery(ctx, &timestamps[i][1]);
+		}
+	}
+	for (uint32 i = 0; i < state.object_count; ++i)
+		ReplayFreeObject_(&state, &state.objects[i]);
+	ArenaRestore(scratch);
+
+	result.ok = !r->failed && frame_count == (int32)header.frame_count;
+	result.frame_count = frame_count;
+	for (int32 i = 0; i < frame_count; ++i)
+	{
+		result.total_cpu_ms += result.frames[i].cpu_ms;
+		result.total_gpu_ms += result.frames[i].gpu_ms;
+	}
+
+	return result;
+}
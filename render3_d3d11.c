@@ -36,6 +36,27 @@ struct R3_Context
 	D3D_FEATURE_LEVEL feature_level;
 	HRESULT hr_status;
 	uint8 adapter_desc[256];
+
+	// NOTE(ljre): Timestamps need a disjoint query around them. One is begun at a time and they rotate at
+	//             R3_Present(), so a timestamp written in 'frame' belongs to disjoint_queries[frame % 4] as long
+	//             as disjoint_frames[] still says so. The last frequency seen is kept for older timestamps.
+	uint64 frame;
+	ID3D11Query* disjoint_queries[4];
+	uint64 disjoint_frames[4];
+	uint64 timestamp_frequency;
+
+	ID3DUserDefinedAnnotation* annotation; // NULL if the runtime doesn't support it
+
+	// NOTE(ljre): Views to discard at R3_EndRenderPass().
+	bool in_render_pass;
+	int32 pass_discard_count;
+	ID3D11View* pass_discards[9];
+
+	R3_PrimitiveType curr_prim;
+	R3_FrameStats stats; // frame in progress
+	R3_FrameStats last_stats;
+	R3_Timeline* timeline;
+	R3_Capture* capture;
 }
 typedef R3_Context;
 
@@ -136,6 +157,62 @@ D3d11UsageToD3dUsage_(R3_Usage usage)
 	return 0;
 }
 
+// NOTE(ljre): We don't link against d3dcompiler just for ID3D11ShaderReflection, so instead walk the
+//             SHDR/SHEX chunk of the DXBC blob until we find the dcl_thread_group declaration. Returns false
+//             if the blob doesn't look like what we expect.
+static bool
+D3d11ReflectThreadGroupSize_(Buffer bytecode, int32 out_size[3])
+{
+	enum
+	{
+		OpcodeCustomData = 35,
+		OpcodeDclThreadGroup = 155,
+	};
+
+	uint32 const* words = (uint32 const*)bytecode.data;
+	intz word_count = bytecode.size / 4;
+	if (word_count < 8 || MemoryCompare(bytecode.data, "DXBC", 4) != 0)
+		return false;
+
+	uint32 chunk_count = words[7];
+	for (uint32 i = 0; i < chunk_count && 8+i < word_count; ++i)
+	{
+		uint32 chunk_offset = words[8+i] / 4;
+		if (chunk_offset + 4 > word_count)
+			return false;
+
+		uint32 const* chunk = &words[chunk_offset];
+		if (MemoryCompare(chunk, "SHDR", 4) != 0 && MemoryCompare(chunk, "SHEX", 4) != 0)
+			continue;
+
+		// NOTE(ljre): Skip fourcc, chunk size, version token, and length token.
+		intz end = Min(word_count, (intz)(chunk_offset + 2 + chunk[1] / 4));
+		intz at = chunk_offset + 4;
+		while (at < end)
+		{
+			uint32 token = words[at];
+			uint32 opcode = token & 0x7ff;
+			intz length = (token >> 24) & 0x7f;
+			if (opcode == OpcodeCustomData && at+1 < end)
+				length = words[at+1];
+			if (length <= 0)
+				return false;
+
+			if (opcode == OpcodeDclThreadGroup && at+3 < end)
+			{
+				out_size[0] = (int32)words[at+1];
+				out_size[1] = (int32)words[at+2];
+				out_size[2] = (int32)words[at+3];
+				return true;
+			}
+			at += length;
+		}
+		return false;
+	}
+
+	return false;
+}
+
 //------------------------------------------------------------------------
 API R3_Context*
 R3_D3D11_MakeContext(Arena* output_arena, R3_ContextDesc const* desc)
@@ -156,6 +233,17 @@ R3_D3D11_MakeContext(Arena* output_arena, R3_ContextDesc const* desc)
 
 	ctx->feature_level = ID3D11Device_GetFeatureLevel(ctx->api.device);
 
+	for (intz i = 0; i < ArrayLength(ctx->disjoint_queries); ++i)
+	{
+		HRESULT hr = ID3D11Device_CreateQuery(ctx->api.device, &(D3D11_QUERY_DESC) { .Query = D3D11_QUERY_TIMESTAMP_DISJOINT }, &ctx->disjoint_queries[i]);
+		CheckHr_(ctx, hr);
+	}
+	ID3D11DeviceContext_Begin(ctx->api.context, (ID3D11Asynchronous*)ctx->disjoint_queries[0]);
+
+	HRESULT hr = ID3D11DeviceContext_QueryInterface(ctx->api.context, &IID_ID3DUserDefinedAnnotation, (void**)&ctx->annotation);
+	if (FAILED(hr))
+		ctx->annotation = NULL;
+
 	return ctx;
 }
 
@@ -230,16 +318,21 @@ R3_QueryInfo(R3_Context* ctx)
 		info.max_texture_size = 4096;
 		info.max_render_target_textures = 4;
 		info.has_instancing = true;
+		info.has_base_instance = true;
 		info.supported_texture_formats[0] |= (1 << R3_Format_F32x1);
 		info.supported_texture_formats[0] |= (1 << R3_Format_F32x3);
 		info.supported_texture_formats[0] |= (1 << R3_Format_F32x4);
 		info.supported_render_target_formats[0] |= (1 << R3_Format_F32x4);
 	}
 	
+	info.max_viewports = 1;
 	if (feature_level >= D3D_FEATURE_LEVEL_10_0)
 	{
 		info.max_texture_size = 8192;
 		info.max_render_target_textures = 8;
+		info.max_viewports = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+		info.has_layered_rendering = true;
+		info.has_timestamp_query = true;
 		info.supported_texture_formats[0] |= (1 << R3_Format_U8x2Norm);
 		info.supported_texture_formats[0] |= (1 << R3_Format_I16x4Norm);
 		info.supported_texture_formats[0] |= (1 << R3_Format_I16x4);
@@ -262,6 +355,7 @@ R3_QueryInfo(R3_Context* ctx)
 		info.max_dispatch_x = 65535u;
 		info.max_dispatch_y = 65535u;
 		info.max_dispatch_z = 65535u;
+		info.max_unordered_views = D3D11_PS_CS_UAV_REGISTER_COUNT;
 		info.has_compute_pipeline = true;
 		info.supported_texture_formats[0] |= (1ull << R3_Format_BC6);
 		info.supported_texture_formats[0] |= (1ull << R3_Format_BC7);
@@ -269,10 +363,35 @@ R3_QueryInfo(R3_Context* ctx)
 	
 	if (feature_level >= D3D_FEATURE_LEVEL_11_1)
 	{
+		info.max_unordered_views = 16;
 	}
 
 	//------------------------------------------------------------------------
 	// Check optional features
+	D3D11_FEATURE_DATA_D3D11_OPTIONS3 options3 = { 0 };
+	if (info.has_layered_rendering && SUCCEEDED(ID3D11Device_CheckFeatureSupport(
+		ctx->api.device, D3D11_FEATURE_D3D11_OPTIONS3, &options3, sizeof(options3))))
+	{
+		info.has_vertex_layer_output = options3.VPAndRTArrayIndexFromAnyShaderFeedingRasterizer;
+	}
+	info.has_debug_groups = (ctx->annotation != NULL);
+	// NOTE(ljre): 9_1 has no occlusion queries at all, and 9_x only answers pipeline statistics queries with
+	//             zeroes. Predication is there from 10_0 onwards.
+	info.has_occlusion_query = (feature_level >= D3D_FEATURE_LEVEL_9_2);
+	info.has_pipeline_statistics_query = (feature_level >= D3D_FEATURE_LEVEL_10_0);
+	info.has_conditional_render = (feature_level >= D3D_FEATURE_LEVEL_10_0);
+
+	info.supported_sample_counts = 1;
+	for (UINT count = 2; count <= D3D11_MAX_MULTISAMPLE_SAMPLE_COUNT; count *= 2)
+	{
+		UINT color_levels = 0;
+		UINT depth_levels = 0;
+		ID3D11Device_CheckMultisampleQualityLevels(ctx->api.device, DXGI_FORMAT_R8G8B8A8_UNORM, count, &color_levels);
+		ID3D11Device_CheckMultisampleQualityLevels(ctx->api.device, DXGI_FORMAT_D24_UNORM_S8_UINT, count, &depth_levels);
+		if (color_levels && depth_levels)
+			info.supported_sample_counts |= count;
+	}
+
 	if (!info.has_compute_pipeline)
 	{
 		D3D11_FEATURE_DATA_D3D10_X_HARDWARE_OPTIONS options = { 0 };
@@ -280,6 +399,7 @@ R3_QueryInfo(R3_Context* ctx)
 			ctx->api.device, D3D11_FEATURE_D3D10_X_HARDWARE_OPTIONS, &options, sizeof(options))))
 		{
 			info.has_compute_pipeline = options.ComputeShaders_Plus_RawAndStructuredBuffers_Via_Shader_4_x;
+			info.max_unordered_views = D3D11_CS_4_X_UAV_REGISTER_COUNT;
 			info.max_dispatch_x = 65535u;
 			info.max_dispatch_y = 65535u;
 			info.max_dispatch_z = 65535u;
@@ -293,13 +413,32 @@ API void
 R3_Present(R3_Context* ctx)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_Present });
+	uint64 timeline_begin = R3_TimelineBegin(ctx->timeline);
 	ctx->api.present(&ctx->api);
+	R3_TimelineEnd(ctx->timeline, R3_TimelineKind_Present, Str("R3_Present"), timeline_begin, 0);
+
+	intz slot = ctx->frame % ArrayLength(ctx->disjoint_queries);
+	ID3D11DeviceContext_End(ctx->api.context, (ID3D11Asynchronous*)ctx->disjoint_queries[slot]);
+	++ctx->frame;
+	slot = ctx->frame % ArrayLength(ctx->disjoint_queries);
+	ctx->disjoint_frames[slot] = ctx->frame;
+	ID3D11DeviceContext_Begin(ctx->api.context, (ID3D11Asynchronous*)ctx->disjoint_queries[slot]);
+
+	ctx->last_stats = ctx->stats;
+	ctx->stats = (R3_FrameStats) {
+		.frame = ctx->stats.frame + 1,
+		.live = ctx->stats.live,
+	};
 }
 
 API void
 R3_ResizeBuffers(R3_Context* ctx)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_ResizeBuffers });
 	ctx->api.resize_buffers(&ctx->api);
 }
 
@@ -315,6 +454,13 @@ API void
 R3_FreeContext(R3_Context* ctx)
 {
 	Trace();
+	for (intz i = 0; i < ArrayLength(ctx->disjoint_queries); ++i)
+	{
+		if (ctx->disjoint_queries[i])
+			ID3D11Query_Release(ctx->disjoint_queries[i]);
+	}
+	if (ctx->annotation)
+		ID3DUserDefinedAnnotation_Release(ctx->annotation);
 	OS_FreeD3D11Api(&ctx->api);
 }
 
@@ -337,6 +483,7 @@ R3_MakeTexture(R3_Context* ctx, R3_TextureDesc const* desc)
 	D3D11_USAGE usage = D3d11UsageToD3dUsage_(desc->usage);
 	uint32 pixel_size;
 	DXGI_FORMAT format = D3d11FormatToDxgi_(desc->format, &pixel_size, NULL);
+	DXGI_FORMAT format_dsv = format;
 	DXGI_FORMAT format_srv, format_uav;
 	switch (format)
 	{
@@ -348,6 +495,13 @@ R3_MakeTexture(R3_Context* ctx, R3_TextureDesc const* desc)
 			format_srv = format_uav = DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
 			format = DXGI_FORMAT_R24G8_TYPELESS;
 			break;
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+			// NOTE(ljre): UAVs can't be sRGB. Shaders writing to it are expected to encode it themselves.
+			format_srv = format;
+			format_uav = DXGI_FORMAT_R8G8B8A8_UNORM;
+			if (desc->binding_flags & R3_BindingFlag_UnorderedAccess)
+				format = DXGI_FORMAT_R8G8B8A8_TYPELESS;
+			break;
 		default:
 			format_srv = format_uav = format;
 			break;
@@ -374,6 +528,23 @@ R3_MakeTexture(R3_Context* ctx, R3_TextureDesc const* desc)
 	if (desc->binding_flags & R3_BindingFlag_Indirect)
 		SafeAssert(false);
 
+	UINT sample_count = (UINT)ClampMin(desc->sample_count, 1);
+	if (sample_count > 1)
+	{
+		SafeAssert(!(bind_flags & (D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS)));
+		SafeAssert(!desc->initial_data && desc->mipmap_count >= 0 && desc->mipmap_count <= 1);
+	}
+
+	// NOTE(ljre): Array and cube textures get views over all of their slices.
+	UINT array_size = depth ? depth : 1;
+	bool is_array = (array_size > 1);
+	if (desc->flag_cubemap)
+	{
+		SafeAssert(array_size == 6 && !desc->initial_data);
+		misc_flags |= D3D11_RESOURCE_MISC_TEXTURECUBE;
+	}
+	SafeAssert(!is_array || sample_count == 1);
+
 	UINT miplevels = 1;
 	if (desc->mipmap_count)
 	{
@@ -388,10 +559,10 @@ R3_MakeTexture(R3_Context* ctx, R3_TextureDesc const* desc)
 		.Width = width,
 		.Height = height,
 		.MipLevels = miplevels,
-		.ArraySize = depth ? depth : 1,
+		.ArraySize = array_size,
 		.Format = format,
 		.SampleDesc = {
-			.Count = 1,
+			.Count = sample_count,
 		},
 		.Usage = usage,
 		.BindFlags = bind_flags,
@@ -419,6 +590,20 @@ R3_MakeTexture(R3_Context* ctx, R3_TextureDesc const* desc)
 				.MipLevels = (UINT)-1,
 			},
 		};
+		if (desc->flag_cubemap)
+		{
+			srv_desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+			srv_desc.TextureCube.MostDetailedMip = 0;
+			srv_desc.TextureCube.MipLevels = (UINT)-1;
+		}
+		else if (is_array)
+		{
+			srv_desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+			srv_desc.Texture2DArray.MostDetailedMip = 0;
+			srv_desc.Texture2DArray.MipLevels = (UINT)-1;
+			srv_desc.Texture2DArray.FirstArraySlice = 0;
+			srv_desc.Texture2DArray.ArraySize = array_size;
+		}
 		hr = ID3D11Device_CreateShaderResourceView(ctx->api.device, (ID3D11Resource*)out.d3d11_tex2d, &srv_desc, &out.d3d11_srv);
 		CheckHr_(ctx, hr);
 	}
@@ -426,20 +611,81 @@ R3_MakeTexture(R3_Context* ctx, R3_TextureDesc const* desc)
 	{
 		D3D11_UNORDERED_ACCESS_VIEW_DESC uav_desc = {
 			.Format = format_uav,
-			.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D,
-			.Texture2D = {
+			.ViewDimension = is_array ? D3D11_UAV_DIMENSION_TEXTURE2DARRAY : D3D11_UAV_DIMENSION_TEXTURE2D,
+			.Texture2DArray = {
 				.MipSlice = 0,
+				.FirstArraySlice = 0,
+				.ArraySize = array_size,
 			},
 		};
 		hr = ID3D11Device_CreateUnorderedAccessView(ctx->api.device, (ID3D11Resource*)out.d3d11_tex2d, &uav_desc, &out.d3d11_uav);
 		CheckHr_(ctx, hr);
+
+		// NOTE(ljre): UAVs only ever see a single mip, so make one for each of them.
+		uint32 total_mips = (miplevels == 0) ? 1 + Bsr(Max(width, height)) : miplevels;
+		for (uint32 i = 1; i < total_mips && i-1 < ArrayLength(out.d3d11_mip_uavs); ++i)
+		{
+			uav_desc.Texture2DArray.MipSlice = i;
+			hr = ID3D11Device_CreateUnorderedAccessView(ctx->api.device, (ID3D11Resource*)out.d3d11_tex2d, &uav_desc, &out.d3d11_mip_uavs[i-1]);
+			CheckHr_(ctx, hr);
+		}
+	}
+	if (bind_flags & D3D11_BIND_RENDER_TARGET)
+	{
+		D3D11_RENDER_TARGET_VIEW_DESC rtv_desc = {
+			.Format = format_srv,
+			.ViewDimension = (sample_count > 1) ? D3D11_RTV_DIMENSION_TEXTURE2DMS : D3D11_RTV_DIMENSION_TEXTURE2D,
+			.Texture2D = {
+				.MipSlice = 0,
+			},
+		};
+		if (is_array)
+		{
+			rtv_desc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
+			rtv_desc.Texture2DArray.MipSlice = 0;
+			rtv_desc.Texture2DArray.FirstArraySlice = 0;
+			rtv_desc.Texture2DArray.ArraySize = array_size;
+		}
+		hr = ID3D11Device_CreateRenderTargetView(ctx->api.device, (ID3D11Resource*)out.d3d11_tex2d, &rtv_desc, &out.d3d11_rtv);
+		CheckHr_(ctx, hr);
+	}
+	if (bind_flags & D3D11_BIND_DEPTH_STENCIL)
+	{
+		D3D11_DEPTH_STENCIL_VIEW_DESC dsv_desc = {
+			.Format = format_dsv,
+			.ViewDimension = (sample_count > 1) ? D3D11_DSV_DIMENSION_TEXTURE2DMS : D3D11_DSV_DIMENSION_TEXTURE2D,
+			.Flags = 0,
+			.Texture2D = {
+				.MipSlice = 0,
+			},
+		};
+		if (is_array)
+		{
+			dsv_desc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2DARRAY;
+			dsv_desc.Texture2DArray.MipSlice = 0;
+			dsv_desc.Texture2DArray.FirstArraySlice = 0;
+			dsv_desc.Texture2DArray.ArraySize = array_size;
+		}
+		hr = ID3D11Device_CreateDepthStencilView(ctx->api.device, (ID3D11Resource*)out.d3d11_tex2d, &dsv_desc, &out.d3d11_dsv);
+		CheckHr_(ctx, hr);
 	}
 
 	out.width = desc->width;
 	out.height = desc->height;
 	out.depth = desc->depth;
 	out.format = desc->format;
+	out.sample_count = (int32)sample_count;
+	out.memory_size = R3_EstimateTextureSize(desc);
 
+	if (out.d3d11_tex2d || out.d3d11_tex3d)
+	{
+		++ctx->stats.resources_created;
+		++ctx->stats.live.textures;
+		ctx->stats.live.texture_bytes += out.memory_size;
+	}
+
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_MakeTexture, .desc = desc, .object = &out });
 	return out;
 }
 
@@ -471,14 +717,24 @@ R3_MakeBuffer(R3_Context* ctx, R3_BufferDesc const* desc)
 	if (desc->binding_flags & R3_BindingFlag_DepthStencil)
 		SafeAssert(false);
 	if (desc->binding_flags & R3_BindingFlag_Indirect)
+	{
+		// NOTE(ljre): Indirect args can't be structured, so they're viewed as a typed uint buffer instead
 		misc_flags |= D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS;
+		misc_flags &= ~D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	}
+
+	// NOTE(ljre): Views of non-structured buffers (e.g. a vertex buffer that is also written by a compute
+	//             shader) are typed R32_UINT views.
+	bool is_structured = (misc_flags & D3D11_RESOURCE_MISC_BUFFER_STRUCTURED);
+	DXGI_FORMAT view_format = is_structured ? DXGI_FORMAT_UNKNOWN : DXGI_FORMAT_R32_UINT;
+	uint32 view_element_size = is_structured ? desc->struct_size : 4;
 
 	D3D11_BUFFER_DESC buffer_desc = {
 		.Usage = usage,
 		.ByteWidth = desc->size,
 		.BindFlags = bind_flags,
 		.MiscFlags = misc_flags,
-		.StructureByteStride = desc->struct_size,
+		.StructureByteStride = is_structured ? desc->struct_size : 0,
 		.CPUAccessFlags = (usage == D3D11_USAGE_DYNAMIC) ? D3D11_CPU_ACCESS_WRITE : 0,
 	};
 
@@ -492,13 +748,13 @@ R3_MakeBuffer(R3_Context* ctx, R3_BufferDesc const* desc)
 	CheckHr_(ctx, hr);
 	if (bind_flags & D3D11_BIND_SHADER_RESOURCE)
 	{
-		SafeAssert(desc->struct_size != 0 && desc->size % desc->struct_size == 0);
+		SafeAssert(view_element_size != 0 && desc->size % view_element_size == 0);
 		D3D11_SHADER_RESOURCE_VIEW_DESC srv_desc = {
-			.Format = DXGI_FORMAT_UNKNOWN,
+			.Format = view_format,
 			.ViewDimension = D3D11_SRV_DIMENSION_BUFFER,
 			.Buffer = {
 				.FirstElement = 0,
-				.NumElements = desc->size / desc->struct_size,
+				.NumElements = desc->size / view_element_size,
 			},
 		};
 		hr = ID3D11Device_CreateShaderResourceView(ctx->api.device, (ID3D11Resource*)out.d3d11_buffer, &srv_desc, &out.d3d11_srv);
@@ -506,13 +762,13 @@ R3_MakeBuffer(R3_Context* ctx, R3_BufferDesc const* desc)
 	}
 	if (bind_flags & D3D11_BIND_UNORDERED_ACCESS)
 	{
-		SafeAssert(desc->struct_size != 0 && desc->size % desc->struct_size == 0);
+		SafeAssert(view_element_size != 0 && desc->size % view_element_size == 0);
 		const D3D11_UNORDERED_ACCESS_VIEW_DESC uav_desc = {
-			.Format = DXGI_FORMAT_UNKNOWN,
+			.Format = view_format,
 			.ViewDimension = D3D11_UAV_DIMENSION_BUFFER,
 			.Buffer = {
 				.FirstElement = 0,
-				.NumElements = desc->size / desc->struct_size,
+				.NumElements = desc->size / view_element_size,
 				.Flags = 0,
 			},
 		};
@@ -520,6 +776,16 @@ R3_MakeBuffer(R3_Context* ctx, R3_BufferDesc const* desc)
 		CheckHr_(ctx, hr);
 	}
 
+	out.size = desc->size;
+	if (out.d3d11_buffer)
+	{
+		++ctx->stats.resources_created;
+		++ctx->stats.live.buffers;
+		ctx->stats.live.buffer_bytes += out.size;
+	}
+
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_MakeBuffer, .desc = desc, .object = &out });
 	return out;
 }
 
@@ -540,7 +806,7 @@ R3_MakeRenderTarget(R3_Context* ctx, R3_RenderTargetDesc const* desc)
 		ID3D11Resource* resource = (ID3D11Resource*)texture->d3d11_tex2d;
 		D3D11_RENDER_TARGET_VIEW_DESC rtv_desc = {
 			.Format = format,
-			.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D,
+			.ViewDimension = (texture->sample_count > 1) ? D3D11_RTV_DIMENSION_TEXTURE2DMS : D3D11_RTV_DIMENSION_TEXTURE2D,
 			.Texture2D = {
 				.MipSlice = 0,
 			},
@@ -557,7 +823,7 @@ R3_MakeRenderTarget(R3_Context* ctx, R3_RenderTargetDesc const* desc)
 		DXGI_FORMAT format = D3d11FormatToDxgi_(texture->format, NULL, NULL);
 		D3D11_DEPTH_STENCIL_VIEW_DESC dsv_desc = {
 			.Format = format,
-			.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D,
+			.ViewDimension = (texture->sample_count > 1) ? D3D11_DSV_DIMENSION_TEXTURE2DMS : D3D11_DSV_DIMENSION_TEXTURE2D,
 			.Flags = 0,
 			.Texture2D = {
 				.MipSlice = 0,
@@ -568,6 +834,9 @@ R3_MakeRenderTarget(R3_Context* ctx, R3_RenderTargetDesc const* desc)
 		CheckHr_(ctx, hr);
 	}
 
+	++ctx->stats.resources_created;
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_MakeRenderTarget, .desc = desc, .object = &out });
 	return out;
 }
 
@@ -577,6 +846,7 @@ R3_MakePipeline(R3_Context* ctx, R3_PipelineDesc const* desc)
 	Trace();
 	R3_Pipeline out = {};
 	HRESULT hr;
+	uint64 timeline_begin = R3_TimelineBegin(ctx->timeline);
 
 	//------------------------------------------------------------------------
 	Buffer vs;
@@ -701,7 +971,7 @@ R3_MakePipeline(R3_Context* ctx, R3_PipelineDesc const* desc)
 		.SlopeScaledDepthBias = 0.0f,
 		.DepthBiasClamp = 0.0f,
 		.DepthClipEnable = true,
-		.ScissorEnable = false, //desc->flag_scissor,
+		.ScissorEnable = desc->flag_scissor,
 		.MultisampleEnable = false,
 		.AntialiasedLineEnable = false,
 	};
@@ -724,6 +994,15 @@ R3_MakePipeline(R3_Context* ctx, R3_PipelineDesc const* desc)
 	hr = ID3D11Device_CreateDepthStencilState(ctx->api.device, &depth_stencil_desc, &out.d3d11_depth_stencil);
 	CheckHr_(ctx, hr);
 
+	if (out.d3d11_vs)
+	{
+		++ctx->stats.resources_created;
+		++ctx->stats.live.pipelines;
+		R3_TimelineEnd(ctx->timeline, R3_TimelineKind_Cpu, Str("R3_MakePipeline"), timeline_begin, 0);
+	}
+
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_MakePipeline, .desc = desc, .object = &out });
 	return out;
 }
 
@@ -733,14 +1012,30 @@ R3_MakeComputePipeline(R3_Context* ctx, R3_ComputePipelineDesc const* desc)
 	Trace();
 	R3_ComputePipeline out = {};
 	HRESULT hr;
+	uint64 timeline_begin = R3_TimelineBegin(ctx->timeline);
 
 	Buffer cs = desc->dx40;
 	if (desc->dx50.size && ctx->feature_level >= D3D_FEATURE_LEVEL_11_0)
 		cs = desc->dx50;
 
 	hr = ID3D11Device_CreateComputeShader(ctx->api.device, cs.data, cs.size, NULL, &out.d3d11_cs);
-	CheckHr_(ctx, hr);
+	if (CheckHr_(ctx, hr))
+		return out;
+
+	int32 group_size[3] = {};
+	if (D3d11ReflectThreadGroupSize_(cs, group_size))
+	{
+		out.group_size_x = group_size[0];
+		out.group_size_y = group_size[1];
+		out.group_size_z = group_size[2];
+	}
+
+	++ctx->stats.resources_created;
+	++ctx->stats.live.pipelines;
+	R3_TimelineEnd(ctx->timeline, R3_TimelineKind_Cpu, Str("R3_MakeComputePipeline"), timeline_begin, 0);
 
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_MakeComputePipeline, .desc = desc, .object = &out });
 	return out;
 }
 
@@ -772,6 +1067,14 @@ R3_MakeSampler(R3_Context* ctx, R3_SamplerDesc const* desc)
 	hr = ID3D11Device_CreateSamplerState(ctx->api.device, &sampler_desc, &out.d3d11_sampler);
 	CheckHr_(ctx, hr);
 
+	if (out.d3d11_sampler)
+	{
+		++ctx->stats.resources_created;
+		++ctx->stats.live.samplers;
+	}
+
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_MakeSampler, .desc = desc, .object = &out });
 	return out;
 }
 
@@ -779,11 +1082,28 @@ API void
 R3_FreeTexture(R3_Context* ctx, R3_Texture* texture)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_FreeTexture, .object = texture });
 
 	if (texture->d3d11_srv)
 		ID3D11ShaderResourceView_Release(texture->d3d11_srv);
 	if (texture->d3d11_uav)
-		ID3D11ShaderResourceView_Release(texture->d3d11_uav);
+		ID3D11UnorderedAccessView_Release(texture->d3d11_uav);
+	for (intz i = 0; i < ArrayLength(texture->d3d11_mip_uavs); ++i)
+	{
+		if (texture->d3d11_mip_uavs[i])
+			ID3D11UnorderedAccessView_Release(texture->d3d11_mip_uavs[i]);
+	}
+	if (texture->d3d11_rtv)
+		ID3D11RenderTargetView_Release(texture->d3d11_rtv);
+	if (texture->d3d11_dsv)
+		ID3D11DepthStencilView_Release(texture->d3d11_dsv);
+	if (texture->d3d11_tex2d || texture->d3d11_tex3d)
+	{
+		++ctx->stats.resources_destroyed;
+		--ctx->stats.live.textures;
+		ctx->stats.live.texture_bytes -= texture->memory_size;
+	}
 	if (texture->d3d11_tex2d)
 		ID3D11Texture2D_Release(texture->d3d11_tex2d);
 	if (texture->d3d11_tex3d)
@@ -796,13 +1116,20 @@ API void
 R3_FreeBuffer(R3_Context* ctx, R3_Buffer* buffer)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_FreeBuffer, .object = buffer });
 
 	if (buffer->d3d11_srv)
 		ID3D11ShaderResourceView_Release(buffer->d3d11_srv);
 	if (buffer->d3d11_uav)
 		ID3D11ShaderResourceView_Release(buffer->d3d11_uav);
 	if (buffer->d3d11_buffer)
+	{
 		ID3D11Buffer_Release(buffer->d3d11_buffer);
+		++ctx->stats.resources_destroyed;
+		--ctx->stats.live.buffers;
+		ctx->stats.live.buffer_bytes -= buffer->size;
+	}
 
 	*buffer = (R3_Buffer) {};
 }
@@ -811,6 +1138,8 @@ API void
 R3_FreeRenderTarget(R3_Context* ctx, R3_RenderTarget* rendertarget)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_FreeRenderTarget, .object = rendertarget });
 
 	for (intz i = 0; i < ArrayLength(rendertarget->d3d11_rtvs); ++i)
 	{
@@ -819,6 +1148,7 @@ R3_FreeRenderTarget(R3_Context* ctx, R3_RenderTarget* rendertarget)
 	}
 	if (rendertarget->d3d11_dsv)
 		ID3D11DepthStencilView_Release(rendertarget->d3d11_dsv);
+	++ctx->stats.resources_destroyed;
 
 	*rendertarget = (R3_RenderTarget) {};
 }
@@ -827,6 +1157,8 @@ API void
 R3_FreePipeline(R3_Context* ctx, R3_Pipeline* pipeline)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_FreePipeline, .object = pipeline });
 
 	if (pipeline->d3d11_blend)
 		ID3D11BlendState_Release(pipeline->d3d11_blend);
@@ -837,7 +1169,11 @@ R3_FreePipeline(R3_Context* ctx, R3_Pipeline* pipeline)
 	if (pipeline->d3d11_input_layout)
 		ID3D11InputLayout_Release(pipeline->d3d11_input_layout);
 	if (pipeline->d3d11_vs)
+	{
 		ID3D11VertexShader_Release(pipeline->d3d11_vs);
+		++ctx->stats.resources_destroyed;
+		--ctx->stats.live.pipelines;
+	}
 	if (pipeline->d3d11_ps)
 		ID3D11PixelShader_Release(pipeline->d3d11_ps);
 
@@ -848,9 +1184,15 @@ API void
 R3_FreeComputePipeline(R3_Context* ctx, R3_ComputePipeline* pipeline)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_FreeComputePipeline, .object = pipeline });
 
 	if (pipeline->d3d11_cs)
+	{
 		ID3D11ComputeShader_Release(pipeline->d3d11_cs);
+		++ctx->stats.resources_destroyed;
+		--ctx->stats.live.pipelines;
+	}
 
 	*pipeline = (R3_ComputePipeline) {};
 }
@@ -859,9 +1201,15 @@ API void
 R3_FreeSampler(R3_Context* ctx, R3_Sampler* sampler)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_FreeSampler, .object = sampler });
 
 	if (sampler->d3d11_sampler)
+	{
 		ID3D11SamplerState_Release(sampler->d3d11_sampler);
+		++ctx->stats.resources_destroyed;
+		--ctx->stats.live.samplers;
+	}
 
 	*sampler = (R3_Sampler) {};
 }
@@ -870,6 +1218,9 @@ API void
 R3_UpdateBuffer(R3_Context* ctx, R3_Buffer* buffer, void const* memory, uint32 size)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_UpdateBuffer, .object = buffer, .memory = memory, .size = size });
+	uint64 timeline_begin = R3_TimelineBegin(ctx->timeline);
 	HRESULT hr;
 
 	D3D11_BUFFER_DESC desc;
@@ -882,12 +1233,19 @@ R3_UpdateBuffer(R3_Context* ctx, R3_Buffer* buffer, void const* memory, uint32 s
 		return;
 	MemoryCopy(map.pData, memory, size);
 	ID3D11DeviceContext_Unmap(ctx->api.context, (ID3D11Resource*)buffer->d3d11_buffer, 0);
+
+	++ctx->stats.buffer_updates;
+	ctx->stats.buffer_update_bytes += size;
+	R3_TimelineEnd(ctx->timeline, R3_TimelineKind_Upload, Str("R3_UpdateBuffer"), timeline_begin, size);
 }
 
 API void
 R3_UpdateTexture(R3_Context* ctx, R3_Texture* texture, void const* memory, uint32 size, uint32 slice)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_UpdateTexture, .object = texture, .memory = memory, .size = size, .args = { slice } });
+	uint64 timeline_begin = R3_TimelineBegin(ctx->timeline);
 
 	D3D11_TEXTURE2D_DESC desc;
 	ID3D11Texture2D_GetDesc(texture->d3d11_tex2d, &desc);
@@ -900,23 +1258,46 @@ R3_UpdateTexture(R3_Context* ctx, R3_Texture* texture, void const* memory, uint3
 	uint32 row = (uint32)texture->width * pixel_size;
 	uint32 depth = (uint32)texture->width * (uint32)texture->height * pixel_size;
 	ID3D11DeviceContext_UpdateSubresource(ctx->api.context, (ID3D11Resource*)texture->d3d11_tex2d, slice, NULL, memory, row, depth);
+
+	++ctx->stats.texture_updates;
+	ctx->stats.texture_update_bytes += size;
+	R3_TimelineEnd(ctx->timeline, R3_TimelineKind_Upload, Str("R3_UpdateTexture"), timeline_begin, size);
 }
 
 API void
 R3_CopyBuffer(R3_Context* ctx, R3_Buffer* src, uint32 src_offset, R3_Buffer* dst, uint32 dst_offset, uint32 size)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_CopyBuffer, .object = src, .other = dst, .args = { src_offset, dst_offset, size } });
 
 	ID3D11DeviceContext_CopySubresourceRegion(ctx->api.context, (ID3D11Resource*)dst->d3d11_buffer, 0, dst_offset, 0, 0, (ID3D11Resource*)src->d3d11_buffer, 0, (&(D3D11_BOX) {
 		.left = src_offset,
 		.right = src_offset + size,
 	}));
+	ctx->stats.copy_bytes += size;
+}
+
+API void
+R3_ResolveTexture(R3_Context* ctx, R3_Texture* src, R3_Texture* dst)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_ResolveTexture, .object = src, .other = dst });
+	SafeAssert(src->sample_count > 1 && dst->sample_count <= 1);
+	SafeAssert(src->format == dst->format && src->width == dst->width && src->height == dst->height);
+	SafeAssert(src->format != R3_Format_D16 && src->format != R3_Format_D24S8);
+
+	DXGI_FORMAT format = D3d11FormatToDxgi_(src->format, NULL, NULL);
+	ID3D11DeviceContext_ResolveSubresource(ctx->api.context, (ID3D11Resource*)dst->d3d11_tex2d, 0, (ID3D11Resource*)src->d3d11_tex2d, 0, format);
 }
 
 API void
 R3_CopyTexture2D(R3_Context* ctx, R3_Texture* src, uint32 src_x, uint32 src_y, R3_Texture* dst, uint32 dst_x, uint32 dst_y, uint32 width, uint32 height)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_CopyTexture2D, .object = src, .other = dst, .args = { src_x, src_y, dst_x, dst_y, width, height } });
 
 	ID3D11DeviceContext_CopySubresourceRegion(ctx->api.context, (ID3D11Resource*)dst->d3d11_tex2d, 0, dst_x, dst_y, 0, (ID3D11Resource*)src->d3d11_tex2d, 0, (&(D3D11_BOX) {
 		.left = src_x,
@@ -924,15 +1305,23 @@ R3_CopyTexture2D(R3_Context* ctx, R3_Texture* src, uint32 src_x, uint32 src_y, R
 		.right = src_x + width,
 		.bottom = src_y + height,
 	}));
+	ctx->stats.copy_bytes += R3_EstimateTextureSize(&(R3_TextureDesc) {
+		.width = (int32)width,
+		.height = (int32)height,
+		.format = src->format,
+	});
 }
 
 API void
 R3_SetViewports(R3_Context* ctx, intz count, R3_Viewport viewports[])
 {
 	Trace();
-	Assert((uintz)count <= 8);
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetViewports, .array = viewports, .count = count });
+	++ctx->stats.fixed_function_changes;
+	Assert((uintz)count <= D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE);
 
-	D3D11_VIEWPORT d3d11_viewports[8] = {};
+	D3D11_VIEWPORT d3d11_viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE] = {};
 	for (intz i = 0; i < count; ++i)
 	{
 		d3d11_viewports[i] = (D3D11_VIEWPORT) {
@@ -948,10 +1337,43 @@ R3_SetViewports(R3_Context* ctx, intz count, R3_Viewport viewports[])
 	ID3D11DeviceContext_RSSetViewports(ctx->api.context, count, d3d11_viewports);
 }
 
+API void
+R3_SetScissorRects(R3_Context* ctx, intz count, R3_ScissorRect rects[])
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetScissorRects, .array = rects, .count = count });
+	++ctx->stats.fixed_function_changes;
+	Assert((uintz)count <= D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE);
+
+	D3D11_RECT d3d11_rects[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE] = {};
+	for (intz i = 0; i < count; ++i)
+	{
+		d3d11_rects[i] = (D3D11_RECT) {
+			.left = rects[i].x,
+			.top = rects[i].y,
+			.right = rects[i].x + rects[i].width,
+			.bottom = rects[i].y + rects[i].height,
+		};
+	}
+
+	ID3D11DeviceContext_RSSetScissorRects(ctx->api.context, (UINT)count, d3d11_rects);
+}
+
+API bool
+R3_IsPipelineReady(R3_Context* ctx, R3_Pipeline* pipeline)
+{
+	Trace();
+	return true;
+}
+
 API void
 R3_SetPipeline(R3_Context* ctx, R3_Pipeline* pipeline)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetPipeline, .object = pipeline });
+	++ctx->stats.pipeline_changes;
 
 	ID3D11DeviceContext_OMSetBlendState(ctx->api.context, pipeline->d3d11_blend, NULL, 0xFFFFFFFF);
 	ID3D11DeviceContext_RSSetState(ctx->api.context, pipeline->d3d11_rasterizer);
@@ -965,6 +1387,9 @@ API void
 R3_SetRenderTarget(R3_Context* ctx, R3_RenderTarget* rendertarget)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetRenderTarget, .object = rendertarget });
+	++ctx->stats.render_target_changes;
 
 	intz color_count = 1;
 	ID3D11RenderTargetView* rtvs[8] = { ctx->api.target };
@@ -989,6 +1414,9 @@ API void
 R3_SetVertexInputs(R3_Context *ctx, const R3_VertexInputs* desc)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetVertexInputs, .desc = desc });
+	++ctx->stats.vertex_input_changes;
 	
 	ID3D11Buffer* vbuffers[ArrayLength(desc->vbuffers)] = {};
 	UINT offsets[ArrayLength(vbuffers)] = {};
@@ -1015,6 +1443,9 @@ API void
 R3_SetUniformBuffers(R3_Context* ctx, intz count, R3_UniformBuffer buffers[])
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetUniformBuffers, .array = buffers, .count = count });
+	++ctx->stats.uniform_buffer_changes;
 	Assert((uintz)count <= 16);
 
 	ID3D11Buffer* cbuffers[8] = {};
@@ -1038,6 +1469,9 @@ API void
 R3_SetResourceViews(R3_Context* ctx, intz count, R3_ResourceView views[])
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetResourceViews, .array = views, .count = count });
+	++ctx->stats.resource_view_changes;
 	Assert((uintz)count <= 16);
 
 	ID3D11ShaderResourceView* srvs[16] = {};
@@ -1057,6 +1491,9 @@ API void
 R3_SetSamplers(R3_Context* ctx, intz count, R3_Sampler* samplers[])
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetSamplers, .array = samplers, .count = count });
+	++ctx->stats.sampler_changes;
 	Assert((uintz)count <= 16);
 
 	ID3D11SamplerState* states[16] = {};
@@ -1070,6 +1507,10 @@ API void
 R3_SetPrimitiveType(R3_Context* ctx, R3_PrimitiveType type)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetPrimitiveType, .args = { type } });
+	++ctx->stats.fixed_function_changes;
+	ctx->curr_prim = type;
 
 	static D3D11_PRIMITIVE_TOPOLOGY const topologytable[] = {
 		[R3_PrimitiveType_TriangleList] = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST,
@@ -1087,6 +1528,9 @@ API void
 R3_Clear(R3_Context* ctx, R3_ClearDesc const* desc)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_Clear, .desc = desc });
+	++ctx->stats.clears;
 
 	ID3D11RenderTargetView* rtvs[8] = {};
 	ID3D11DepthStencilView* dsv = NULL;
@@ -1118,10 +1562,108 @@ R3_Clear(R3_Context* ctx, R3_ClearDesc const* desc)
 	}
 }
 
+API void
+R3_BeginRenderPass(R3_Context* ctx, R3_RenderPassDesc const* desc)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_BeginRenderPass, .desc = desc });
+	SafeAssert(!ctx->in_render_pass);
+	ctx->in_render_pass = true;
+	ctx->pass_discard_count = 0;
+	++ctx->stats.render_target_changes;
+
+	intz color_count = 0;
+	ID3D11RenderTargetView* rtvs[8] = {};
+	ID3D11DepthStencilView* dsv = NULL;
+	for (intz i = 0; i < ArrayLength(rtvs); ++i)
+	{
+		if (desc->color_textures[i])
+		{
+			SafeAssert(desc->color_textures[i]->d3d11_rtv);
+			rtvs[i] = desc->color_textures[i]->d3d11_rtv;
+			color_count = i+1;
+		}
+	}
+	if (desc->depth_stencil_texture)
+	{
+		SafeAssert(desc->depth_stencil_texture->d3d11_dsv);
+		dsv = desc->depth_stencil_texture->d3d11_dsv;
+	}
+	if (!color_count && !dsv)
+	{
+		color_count = 1;
+		rtvs[0] = ctx->api.target;
+		dsv = ctx->api.depth_stencil;
+	}
+	ID3D11DeviceContext_OMSetRenderTargets(ctx->api.context, (UINT)color_count, rtvs, dsv);
+
+	// NOTE(ljre): DiscardView() is the D3D11.1 way of saying we don't care about the contents of a view.
+	for (intz i = 0; i < color_count; ++i)
+	{
+		if (!rtvs[i])
+			continue;
+		if (desc->colors[i].load == R3_LoadAction_Clear)
+		{
+			ID3D11DeviceContext_ClearRenderTargetView(ctx->api.context, rtvs[i], desc->colors[i].clear_color);
+			++ctx->stats.clears;
+		}
+		else if (desc->colors[i].load == R3_LoadAction_DontCare)
+			ID3D11DeviceContext1_DiscardView(ctx->api.context1, (ID3D11View*)rtvs[i]);
+		if (desc->colors[i].store == R3_StoreAction_Discard)
+			ctx->pass_discards[ctx->pass_discard_count++] = (ID3D11View*)rtvs[i];
+	}
+	if (dsv)
+	{
+		SafeAssert(desc->depth_stencil.clear_stencil <= UINT8_MAX);
+		if (desc->depth_stencil.load == R3_LoadAction_Clear)
+		{
+			ID3D11DeviceContext_ClearDepthStencilView(ctx->api.context, dsv, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, desc->depth_stencil.clear_depth, (UINT8)desc->depth_stencil.clear_stencil);
+			++ctx->stats.clears;
+		}
+		else if (desc->depth_stencil.load == R3_LoadAction_DontCare)
+			ID3D11DeviceContext1_DiscardView(ctx->api.context1, (ID3D11View*)dsv);
+		if (desc->depth_stencil.store == R3_StoreAction_Discard)
+			ctx->pass_discards[ctx->pass_discard_count++] = (ID3D11View*)dsv;
+	}
+}
+
+API void
+R3_EndRenderPass(R3_Context* ctx)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_EndRenderPass });
+	SafeAssert(ctx->in_render_pass);
+	ctx->in_render_pass = false;
+
+	for (int32 i = 0; i < ctx->pass_discard_count; ++i)
+		ID3D11DeviceContext1_DiscardView(ctx->api.context1, ctx->pass_discards[i]);
+	ctx->pass_discard_count = 0;
+}
+
+static void
+D3d11CountDraw_(R3_Context* ctx, uint32 count, uint32 instance_count)
+{
+	uint64 instances = ClampMin(instance_count, 1);
+	uint64 triangles = 0;
+	if (ctx->curr_prim == R3_PrimitiveType_TriangleList)
+		triangles = count / 3;
+	else if (ctx->curr_prim == R3_PrimitiveType_TriangleStrip && count >= 3)
+		triangles = count - 2;
+
+	++ctx->stats.draws;
+	ctx->stats.instances += instances;
+	ctx->stats.triangles += triangles * instances;
+}
+
 API void
 R3_Draw(R3_Context* ctx, uint32 start_vertex, uint32 vertex_count, uint32 start_instance, uint32 instance_count)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_Draw, .args = { start_vertex, vertex_count, start_instance, instance_count } });
+	D3d11CountDraw_(ctx, vertex_count, instance_count);
 	if (instance_count)
 		ID3D11DeviceContext_DrawInstanced(ctx->api.context, vertex_count, instance_count, start_vertex, start_instance);
 	else
@@ -1132,16 +1674,44 @@ API void
 R3_DrawIndexed(R3_Context* ctx, uint32 start_index, uint32 index_count, uint32 start_instance, uint32 instance_count, int32 base_vertex)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_DrawIndexed, .args = { start_index, index_count, start_instance, instance_count, (uint32)base_vertex } });
+	D3d11CountDraw_(ctx, index_count, instance_count);
 	if (instance_count)
 		ID3D11DeviceContext_DrawIndexedInstanced(ctx->api.context, index_count, instance_count, start_index, base_vertex, start_instance);
 	else
 		ID3D11DeviceContext_DrawIndexed(ctx->api.context, index_count, start_index, base_vertex);
 }
 
+API void
+R3_DrawIndirect(R3_Context* ctx, R3_Buffer* buffer, uint32 offset)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_DrawIndirect, .object = buffer, .args = { offset } });
+	++ctx->stats.draws;
+	++ctx->stats.indirect_draws;
+	ID3D11DeviceContext_DrawInstancedIndirect(ctx->api.context, buffer->d3d11_buffer, offset);
+}
+
+API void
+R3_DrawIndexedIndirect(R3_Context* ctx, R3_Buffer* buffer, uint32 offset)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_DrawIndexedIndirect, .object = buffer, .args = { offset } });
+	++ctx->stats.draws;
+	++ctx->stats.indirect_draws;
+	ID3D11DeviceContext_DrawIndexedInstancedIndirect(ctx->api.context, buffer->d3d11_buffer, offset);
+}
+
 API void
 R3_SetComputePipeline(R3_Context* ctx, R3_ComputePipeline* pipeline)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetComputePipeline, .object = pipeline });
+	++ctx->stats.pipeline_changes;
 	ID3D11DeviceContext_CSSetShader(ctx->api.context, pipeline->d3d11_cs, NULL, 0);
 }
 
@@ -1149,6 +1719,9 @@ API void
 R3_SetComputeUniformBuffers(R3_Context* ctx, intz count, R3_UniformBuffer buffers[])
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetComputeUniformBuffers, .array = buffers, .count = count });
+	++ctx->stats.uniform_buffer_changes;
 	Assert((uintz)count <= 8);
 
 	ID3D11Buffer* cbuffers[8] = {};
@@ -1171,6 +1744,9 @@ API void
 R3_SetComputeResourceViews(R3_Context* ctx, intz count, R3_ResourceView views[])
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetComputeResourceViews, .array = views, .count = count });
+	++ctx->stats.resource_view_changes;
 	Assert((uintz)count <= 16);
 
 	ID3D11ShaderResourceView* srvs[16] = {};
@@ -1189,6 +1765,9 @@ API void
 R3_SetComputeUnorderedViews(R3_Context* ctx, intz count, R3_UnorderedView views[])
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetComputeUnorderedViews, .array = views, .count = count });
+	++ctx->stats.resource_view_changes;
 	Assert((uintz)count <= 16);
 
 	ID3D11UnorderedAccessView* uavs[16] = {};
@@ -1196,8 +1775,13 @@ R3_SetComputeUnorderedViews(R3_Context* ctx, intz count, R3_UnorderedView views[
 	{
 		if (views[i].buffer)
 			uavs[i] = views[i].buffer->d3d11_uav;
-		else if (views[i].texture)
+		else if (views[i].texture && views[i].mip == 0)
 			uavs[i] = views[i].texture->d3d11_uav;
+		else if (views[i].texture)
+		{
+			SafeAssert(views[i].mip > 0 && views[i].mip <= ArrayLength(views[i].texture->d3d11_mip_uavs));
+			uavs[i] = views[i].texture->d3d11_mip_uavs[views[i].mip-1];
+		}
 	}
 
 	ID3D11DeviceContext_CSSetUnorderedAccessViews(ctx->api.context, 0, ArrayLength(uavs), uavs, NULL);
@@ -1207,9 +1791,23 @@ API void
 R3_Dispatch(R3_Context* ctx, uint32 x, uint32 y, uint32 z)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_Dispatch, .args = { x, y, z } });
+	++ctx->stats.dispatches;
 	ID3D11DeviceContext_Dispatch(ctx->api.context, x, y, z);
 }
 
+API void
+R3_DispatchIndirect(R3_Context* ctx, R3_Buffer* buffer, uint32 offset)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_DispatchIndirect, .object = buffer, .args = { offset } });
+	++ctx->stats.dispatches;
+	SafeAssert(offset % 4 == 0);
+	ID3D11DeviceContext_DispatchIndirect(ctx->api.context, buffer->d3d11_buffer, offset);
+}
+
 //------------------------------------------------------------------------
 // // TODO(ljre): Proper error handling
 // API R3_VideoDecoder
@@ -1610,3 +2208,212 @@ R3_Dispatch(R3_Context* ctx, uint32 x, uint32 y, uint32 z)
 // 	hr = ID2D1RenderTarget_EndDraw(text_ctx->d2d_rendertarget, NULL, NULL);
 // 	SafeAssert(SUCCEEDED(hr));
 // }
+
+//------------------------------------------------------------------------
+// NOTE(ljre): Returns false while the disjoint query of 'frame' isn't done yet.
+static bool
+D3d11ResolveDisjoint_(R3_Context* ctx, uint64 frame, bool* out_disjoint)
+{
+	intz slot = frame % ArrayLength(ctx->disjoint_queries);
+	*out_disjoint = false;
+	if (frame == ctx->frame)
+		return false;
+	if (ctx->disjoint_frames[slot] != frame)
+		return (ctx->timestamp_frequency != 0);
+
+	D3D11_QUERY_DATA_TIMESTAMP_DISJOINT data;
+	HRESULT hr = ID3D11DeviceContext_GetData(ctx->api.context, (ID3D11Asynchronous*)ctx->disjoint_queries[slot], &data, sizeof(data), D3D11_ASYNC_GETDATA_DONOTFLUSH);
+	if (hr != S_OK)
+		return false;
+
+	*out_disjoint = data.Disjoint;
+	if (!data.Disjoint)
+		ctx->timestamp_frequency = data.Frequency;
+	return (ctx->timestamp_frequency != 0);
+}
+
+API R3_Query
+R3_MakeQuery(R3_Context* ctx, R3_QueryKind kind)
+{
+	Trace();
+	R3_Query out = { .kind = kind };
+
+	D3D11_QUERY_DESC query_desc = {};
+	switch (kind)
+	{
+		case R3_QueryKind_Timestamp: query_desc.Query = D3D11_QUERY_TIMESTAMP; break;
+		case R3_QueryKind_Occlusion: query_desc.Query = D3D11_QUERY_OCCLUSION_PREDICATE; break;
+		case R3_QueryKind_PipelineStatistics: query_desc.Query = D3D11_QUERY_PIPELINE_STATISTICS; break;
+		default: SafeAssert(false);
+	}
+
+	HRESULT hr;
+	if (kind == R3_QueryKind_Occlusion)
+		hr = ID3D11Device_CreatePredicate(ctx->api.device, &query_desc, (ID3D11Predicate**)&out.d3d11_query);
+	else
+		hr = ID3D11Device_CreateQuery(ctx->api.device, &query_desc, &out.d3d11_query);
+	if (!CheckHr_(ctx, hr))
+		++ctx->stats.resources_created;
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_MakeQuery, .object = &out, .args = { kind } });
+	return out;
+}
+
+API void
+R3_FreeQuery(R3_Context* ctx, R3_Query* query)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_FreeQuery, .object = query });
+	if (query->d3d11_query)
+	{
+		ID3D11Query_Release(query->d3d11_query);
+		++ctx->stats.resources_destroyed;
+	}
+
+	*query = (R3_Query) {};
+}
+
+API void
+R3_WriteTimestamp(R3_Context* ctx, R3_Query* query)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_WriteTimestamp, .object = query });
+	SafeAssert(query->kind == R3_QueryKind_Timestamp);
+	ID3D11DeviceContext_End(ctx->api.context, (ID3D11Asynchronous*)query->d3d11_query);
+	query->d3d11_frame = ctx->frame;
+}
+
+API void
+R3_BeginQuery(R3_Context* ctx, R3_Query* query)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_BeginQuery, .object = query });
+	SafeAssert(query->kind == R3_QueryKind_Occlusion || query->kind == R3_QueryKind_PipelineStatistics);
+	ID3D11DeviceContext_Begin(ctx->api.context, (ID3D11Asynchronous*)query->d3d11_query);
+}
+
+API void
+R3_EndQuery(R3_Context* ctx, R3_Query* query)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_EndQuery, .object = query });
+	SafeAssert(query->kind == R3_QueryKind_Occlusion || query->kind == R3_QueryKind_PipelineStatistics);
+	ID3D11DeviceContext_End(ctx->api.context, (ID3D11Asynchronous*)query->d3d11_query);
+}
+
+API bool
+R3_GetQueryResult(R3_Context* ctx, R3_Query* query, R3_QueryResult* out_result)
+{
+	Trace();
+	R3_QueryResult result = {};
+
+	if (query->kind == R3_QueryKind_Timestamp)
+	{
+		UINT64 ticks = 0;
+		HRESULT hr = ID3D11DeviceContext_GetData(ctx->api.context, (ID3D11Asynchronous*)query->d3d11_query, &ticks, sizeof(ticks), D3D11_ASYNC_GETDATA_DONOTFLUSH);
+		if (hr != S_OK || !D3d11ResolveDisjoint_(ctx, query->d3d11_frame, &result.disjoint))
+			return false;
+
+		uint64 freq = ctx->timestamp_frequency;
+		result.timestamp_ns = ticks / freq * 1000000000ull + ticks % freq * 1000000000ull / freq;
+	}
+	else if (query->kind == R3_QueryKind_Occlusion)
+	{
+		BOOL passed = FALSE;
+		HRESULT hr = ID3D11DeviceContext_GetData(ctx->api.context, (ID3D11Asynchronous*)query->d3d11_query, &passed, sizeof(passed), D3D11_ASYNC_GETDATA_DONOTFLUSH);
+		if (hr != S_OK)
+			return false;
+		result.any_samples_passed = (passed != FALSE);
+	}
+	else if (query->kind == R3_QueryKind_PipelineStatistics)
+	{
+		D3D11_QUERY_DATA_PIPELINE_STATISTICS data = {};
+		HRESULT hr = ID3D11DeviceContext_GetData(ctx->api.context, (ID3D11Asynchronous*)query->d3d11_query, &data, sizeof(data), D3D11_ASYNC_GETDATA_DONOTFLUSH);
+		if (hr != S_OK)
+			return false;
+		result.statistics = (R3_PipelineStatistics) {
+			.input_vertices = data.IAVertices,
+			.input_primitives = data.IAPrimitives,
+			.vertex_invocations = data.VSInvocations,
+			.clipping_input_primitives = data.CInvocations,
+			.clipping_output_primitives = data.CPrimitives,
+			.fragment_invocations = data.PSInvocations,
+			.compute_invocations = data.CSInvocations,
+		};
+	}
+
+	*out_result = result;
+	return true;
+}
+
+API void
+R3_BeginConditionalRender(R3_Context* ctx, R3_Query* query)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_BeginConditionalRender, .object = query });
+	SafeAssert(ctx->feature_level >= D3D_FEATURE_LEVEL_10_0 && query->kind == R3_QueryKind_Occlusion);
+	// NOTE(ljre): Draws are skipped when the predicate is FALSE, i.e. when no samples passed. If the result
+	//             isn't ready yet, the driver is free to just draw.
+	ID3D11DeviceContext_SetPredication(ctx->api.context, (ID3D11Predicate*)query->d3d11_query, FALSE);
+}
+
+API void
+R3_EndConditionalRender(R3_Context* ctx)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_EndConditionalRender });
+	ID3D11DeviceContext_SetPredication(ctx->api.context, NULL, FALSE);
+}
+
+API void
+R3_PushDebugGroup(R3_Context* ctx, String name)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_PushDebugGroup, .name = name });
+	if (!ctx->annotation)
+		return;
+
+	WCHAR wname[128];
+	int32 length = MultiByteToWideChar(CP_UTF8, 0, (char const*)name.data, (int32)Min(name.size, 127), wname, ArrayLength(wname) - 1);
+	wname[ClampMin(length, 0)] = 0;
+	ID3DUserDefinedAnnotation_BeginEvent(ctx->annotation, wname);
+}
+
+API void
+R3_PopDebugGroup(R3_Context* ctx)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_PopDebugGroup });
+	if (ctx->annotation)
+		ID3DUserDefinedAnnotation_EndEvent(ctx->annotation);
+}
+
+//------------------------------------------------------------------------
+API R3_FrameStats
+R3_GetFrameStats(R3_Context* ctx)
+{
+	Trace();
+	return ctx->last_stats;
+}
+
+API void
+R3_SetTimeline(R3_Context* ctx, R3_Timeline* timeline)
+{
+	Trace();
+	ctx->timeline = timeline;
+}
+
+API void
+R3_SetCapture(R3_Context* ctx, R3_Capture* capture)
+{
+	Trace();
+	ctx->capture = capture;
+}
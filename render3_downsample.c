@@ -0,0 +1,329 @@
+#include <base/base.h>
+#include <base/base_intrinsics.h>
+#include <base/base_assert.h>
+#include <base/base_string.h>
+#include <base/base_arena.h>
+#include <layer_os/api.h>
+#include "api.h"
+
+// NOTE(ljre): std140 layout of type_UniformBuffer0.
+struct DownsampleUniforms_
+{
+	int32 src_size[2];
+	int32 group_count[2];
+	int32 src_mip;
+	int32 group_mip_count;
+	int32 tail_mip_count;
+	uint32 mode;
+	uint32 padding_[4];
+}
+typedef DownsampleUniforms_;
+
+#define DOWNSAMPLE_TILE_SIZE_ 64 // source texels covered by a workgroup along each axis
+#define DOWNSAMPLE_GROUP_MIPS_ 6 // log2(DOWNSAMPLE_TILE_SIZE_)
+#define DOWNSAMPLE_MAX_MIPS_ 12 // group mips + tail mips
+#define DOWNSAMPLE_MAX_TAIL_GROUPS_ (DOWNSAMPLE_TILE_SIZE_ * DOWNSAMPLE_TILE_SIZE_)
+
+#define DOWNSAMPLE_GLSL_IMAGE_(i, binding) \
+	"#if DS_MIP_IMAGE_COUNT > " #i "\n" \
+	"layout(DS_FORMAT, binding = " #binding ") uniform writeonly highp image2D uMip" #i ";\n" \
+	"#endif\n"
+#define DOWNSAMPLE_GLSL_STORE_(i) \
+	"#if DS_MIP_IMAGE_COUNT > " #i "\n" \
+	"	if (mip == " #i ") imageStore(uMip" #i ", p, v);\n" \
+	"#endif\n"
+
+// NOTE(ljre): Unordered view 0 is the scratch buffer (SSBO binding 16), views 1 to DS_MIP_IMAGE_COUNT are the
+//             mips written by this dispatch (image units 1 and up). Expects DS_MIP_IMAGE_COUNT and DS_FORMAT to
+//             be defined before it.
+static char const g_downsample_glsl[] =
+	"layout(local_size_x = 256) in;\n"
+	"layout(std140) uniform type_UniformBuffer0\n"
+	"{\n"
+	"	ivec2 uSrcSize;\n"
+	"	ivec2 uGroupCount;\n"
+	"	int uSrcMip;\n"
+	"	int uGroupMipCount;\n"
+	"	int uTailMipCount;\n"
+	"	uint uMode;\n"
+	"};\n"
+	"uniform highp sampler2D uTexture0;\n"
+	"layout(std430, binding = 16) coherent buffer Scratch { uint bCounter; uint bPadding[3]; vec4 bMid[]; };\n"
+	DOWNSAMPLE_GLSL_IMAGE_(0, 1)
+	DOWNSAMPLE_GLSL_IMAGE_(1, 2)
+	DOWNSAMPLE_GLSL_IMAGE_(2, 3)
+	DOWNSAMPLE_GLSL_IMAGE_(3, 4)
+	DOWNSAMPLE_GLSL_IMAGE_(4, 5)
+	DOWNSAMPLE_GLSL_IMAGE_(5, 6)
+	DOWNSAMPLE_GLSL_IMAGE_(6, 7)
+	DOWNSAMPLE_GLSL_IMAGE_(7, 8)
+	DOWNSAMPLE_GLSL_IMAGE_(8, 9)
+	DOWNSAMPLE_GLSL_IMAGE_(9, 10)
+	DOWNSAMPLE_GLSL_IMAGE_(10, 11)
+	DOWNSAMPLE_GLSL_IMAGE_(11, 12)
+	"\n"
+	"shared vec4 sTile[32][32];\n"
+	"\n"
+	"vec4 Reduce(vec4 a, vec4 b, vec4 c, vec4 d)\n"
+	"{\n"
+	"	if (uMode == 1u)\n"
+	"		return min(min(a, b), min(c, d));\n"
+	"	if (uMode == 2u)\n"
+	"		return max(max(a, b), max(c, d));\n"
+	"	return (a + b + c + d) * 0.25;\n"
+	"}\n"
+	"\n"
+	"void StoreMip(int mip, ivec2 p, vec4 v)\n"
+	"{\n"
+	DOWNSAMPLE_GLSL_STORE_(0)
+	DOWNSAMPLE_GLSL_STORE_(1)
+	DOWNSAMPLE_GLSL_STORE_(2)
+	DOWNSAMPLE_GLSL_STORE_(3)
+	DOWNSAMPLE_GLSL_STORE_(4)
+	DOWNSAMPLE_GLSL_STORE_(5)
+	DOWNSAMPLE_GLSL_STORE_(6)
+	DOWNSAMPLE_GLSL_STORE_(7)
+	DOWNSAMPLE_GLSL_STORE_(8)
+	DOWNSAMPLE_GLSL_STORE_(9)
+	DOWNSAMPLE_GLSL_STORE_(10)
+	DOWNSAMPLE_GLSL_STORE_(11)
+	"}\n"
+	"\n"
+	// sRGB sources are decoded by texelFetch
+	"vec4 Fetch(ivec2 p, bool tail)\n"
+	"{\n"
+	"	if (tail)\n"
+	"	{\n"
+	"		p = min(p, uGroupCount - 1);\n"
+	"		return bMid[p.y * uGroupCount.x + p.x];\n"
+	"	}\n"
+	"	return texelFetch(uTexture0, min(p, uSrcSize - 1), uSrcMip);\n"
+	"}\n"
+	"\n"
+	// Reduces the 64x64 block 'group' of the source into 'mip_count' mips. The last one ends up in sTile[0][0]
+	"void Downsample(ivec2 group, int first_mip, int mip_count, bool tail)\n"
+	"{\n"
+	"	ivec2 local = ivec2(gl_LocalInvocationID.x % 16u, gl_LocalInvocationID.x / 16u);\n"
+	"	for (int i = 0; i < 4; ++i)\n"
+	"	{\n"
+	"		ivec2 p = local + ivec2(i & 1, i >> 1) * 16;\n"
+	"		ivec2 src = (group * 32 + p) * 2;\n"
+	"		vec4 v = Reduce(Fetch(src, tail), Fetch(src + ivec2(1, 0), tail), Fetch(src + ivec2(0, 1), tail), Fetch(src + ivec2(1, 1), tail));\n"
+	"		StoreMip(first_mip, group * 32 + p, v);\n"
+	"		sTile[p.y][p.x] = v;\n"
+	"	}\n"
+	"\n"
+	"	for (int m = 1; m < mip_count; ++m)\n"
+	"	{\n"
+	"		memoryBarrierShared();\n"
+	"		barrier();\n"
+	"		int size = 32 >> m;\n"
+	"		bool active = all(lessThan(local, ivec2(size)));\n"
+	"		vec4 v = vec4(0.0);\n"
+	"		if (active)\n"
+	"		{\n"
+	"			ivec2 s = local * 2;\n"
+	"			v = Reduce(sTile[s.y][s.x], sTile[s.y][s.x+1], sTile[s.y+1][s.x], sTile[s.y+1][s.x+1]);\n"
+	"			StoreMip(first_mip + m, group * size + local, v);\n"
+	"		}\n"
+	"		memoryBarrierShared();\n"
+	"		barrier();\n"
+	"		if (active)\n"
+	"			sTile[local.y][local.x] = v;\n"
+	"	}\n"
+	"	memoryBarrierShared();\n"
+	"	barrier();\n"
+	"}\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"	ivec2 group = ivec2(gl_WorkGroupID.xy);\n"
+	"	Downsample(group, 0, uGroupMipCount, false);\n"
+	"	if (uTailMipCount == 0)\n"
+	"		return;\n"
+	"\n"
+	// The last workgroup to get here reduces everyone's 1x1 results. It also resets the counter for the next
+	// dispatch, so the scratch buffer never needs to be cleared.
+	"	if (gl_LocalInvocationIndex == 0u)\n"
+	"	{\n"
+	"		bMid[group.y * uGroupCount.x + group.x] = sTile[0][0];\n"
+	"		memoryBarrierBuffer();\n"
+	"		uint done = atomicAdd(bCounter, 1u);\n"
+	"		sTile[0][0].x = (done == uint(uGroupCount.x * uGroupCount.y) - 1u) ? 1.0 : 0.0;\n"
+	"	}\n"
+	"	memoryBarrierShared();\n"
+	"	barrier();\n"
+	"	bool is_last = (sTile[0][0].x != 0.0);\n"
+	"	barrier();\n"
+	"	if (!is_last)\n"
+	"		return;\n"
+	"\n"
+	"	if (gl_LocalInvocationIndex == 0u)\n"
+	"		bCounter = 0u;\n"
+	"	Downsample(ivec2(0), uGroupMipCount, uTailMipCount, true);\n"
+	"}\n";
+
+static String
+DownsampleGlslImageFormat_(R3_Format format)
+{
+	switch (format)
+	{
+		default: SafeAssert(!"R3_Format not supported by the downsampler"); return Str("");
+
+		case R3_Format_U8x1Norm: return Str("r8");
+		case R3_Format_U8x2Norm: return Str("rg8");
+		case R3_Format_U8x4Norm: return Str("rgba8");
+		case R3_Format_F16x2: return Str("rg16f");
+		case R3_Format_F16x4: return Str("rgba16f");
+		case R3_Format_F32x1: return Str("r32f");
+		case R3_Format_F32x2: return Str("rg32f");
+		case R3_Format_F32x4: return Str("rgba32f");
+	}
+}
+
+//------------------------------------------------------------------------
+API R3_Downsampler
+R3_MakeDownsampler(R3_Context* ctx, R3_DownsamplerDesc const* desc)
+{
+	Trace();
+	R3_Downsampler out = {};
+	R3_ContextInfo info = R3_QueryInfo(ctx);
+	SafeAssert(info.has_compute_pipeline);
+	// NOTE(ljre): GLES 3.1 has no image load/store on sRGB formats.
+	SafeAssert(desc->format != R3_Format_U8x4Norm_Srgb);
+
+	// NOTE(ljre): One unordered view is taken by the scratch buffer.
+	out.max_mips_per_dispatch = Min(info.max_unordered_views - 1, DOWNSAMPLE_MAX_MIPS_);
+	out.format = desc->format;
+	SafeAssert(out.max_mips_per_dispatch > 0);
+
+	// NOTE(ljre): Image declarations need both the count and the format at compile time.
+	ArenaSavepoint scratch = ArenaSave(OS_ScratchArena(NULL, 0));
+	String image_format = DownsampleGlslImageFormat_(desc->format);
+	String body = Str(g_downsample_glsl);
+	String count_prefix = Str("#define DS_MIP_IMAGE_COUNT ");
+	String format_prefix = Str("\n#define DS_FORMAT ");
+	intz size = count_prefix.size + 2 + format_prefix.size + image_format.size + 1 + body.size;
+	uint8* source = ArenaPushArray(scratch.arena, uint8, size);
+	intz len = 0;
+
+	MemoryCopy(source + len, count_prefix.data, count_prefix.size);
+	len += count_prefix.size;
+	if (out.max_mips_per_dispatch >= 10)
+		source[len++] = '0' + out.max_mips_per_dispatch / 10;
+	source[len++] = '0' + out.max_mips_per_dispatch % 10;
+	MemoryCopy(source + len, format_prefix.data, format_prefix.size);
+	len += format_prefix.size;
+	MemoryCopy(source + len, image_format.data, image_format.size);
+	len += image_format.size;
+	source[len++] = '\n';
+	MemoryCopy(source + len, body.data, body.size);
+	len += body.size;
+
+	out.pipeline = R3_MakeComputePipeline(ctx, &(R3_ComputePipelineDesc) {
+		.glsl = { .data = source, .size = len },
+		.dx50 = desc->dx50_cs,
+	});
+	ArenaRestore(scratch);
+
+	out.uniforms = R3_MakeBuffer(ctx, &(R3_BufferDesc) {
+		.size = sizeof(DownsampleUniforms_),
+		.binding_flags = R3_BindingFlag_UniformBuffer,
+		.usage = R3_Usage_Dynamic,
+	});
+
+	// NOTE(ljre): The counter must start at 0. After that, the shader resets it by itself.
+	uint32 scratch_size = sizeof(float32[4]) + sizeof(float32[4]) * DOWNSAMPLE_MAX_TAIL_GROUPS_;
+	scratch = ArenaSave(OS_ScratchArena(NULL, 0));
+	void* zeroes = ArenaPushAligned(scratch.arena, scratch_size, 16);
+	MemoryZero(zeroes, scratch_size);
+	out.scratch = R3_MakeBuffer(ctx, &(R3_BufferDesc) {
+		.size = scratch_size,
+		.binding_flags = R3_BindingFlag_UnorderedAccess,
+		.usage = R3_Usage_GpuReadWrite,
+		.initial_data = zeroes,
+	});
+	ArenaRestore(scratch);
+
+	return out;
+}
+
+API void
+R3_FreeDownsampler(R3_Context* ctx, R3_Downsampler* downsampler)
+{
+	Trace();
+
+	R3_FreeComputePipeline(ctx, &downsampler->pipeline);
+	R3_FreeBuffer(ctx, &downsampler->uniforms);
+	R3_FreeBuffer(ctx, &downsampler->scratch);
+
+	*downsampler = (R3_Downsampler) {};
+}
+
+API void
+R3_Downsample(R3_Context* ctx, R3_Downsampler* downsampler, R3_DownsampleParams const* params)
+{
+	Trace();
+	SafeAssert(params->src && params->dst);
+	SafeAssert(params->dst->format == downsampler->format);
+	SafeAssert(params->mode >= R3_DownsampleMode_Average && params->mode <= R3_DownsampleMode_Max);
+
+	R3_Texture* src = params->src;
+	int32 src_mip = params->src_mip;
+	int32 dst_mip = params->dst_mip;
+	int32 src_width = ClampMin(src->width >> src_mip, 1);
+	int32 src_height = ClampMin(src->height >> src_mip, 1);
+	int32 remaining = params->mip_count;
+	if (!remaining)
+		remaining = Bsr((uint32)Max(src_width, src_height));
+
+	while (remaining > 0)
+	{
+		int32 group_count_x = (src_width + DOWNSAMPLE_TILE_SIZE_-1) / DOWNSAMPLE_TILE_SIZE_;
+		int32 group_count_y = (src_height + DOWNSAMPLE_TILE_SIZE_-1) / DOWNSAMPLE_TILE_SIZE_;
+		int32 group_mips = Min(Min(remaining, DOWNSAMPLE_GROUP_MIPS_), downsampler->max_mips_per_dispatch);
+		int32 tail_mips = 0;
+		// NOTE(ljre): The tail is a single workgroup, so it can only take what fits in one 64x64 block.
+		if (group_mips == DOWNSAMPLE_GROUP_MIPS_ && group_count_x <= DOWNSAMPLE_TILE_SIZE_ && group_count_y <= DOWNSAMPLE_TILE_SIZE_)
+			tail_mips = Min(Min(remaining - group_mips, DOWNSAMPLE_GROUP_MIPS_), downsampler->max_mips_per_dispatch - group_mips);
+		int32 written = group_mips + tail_mips;
+
+		DownsampleUniforms_ uniforms = {
+			.src_size = { src_width, src_height },
+			.group_count = { group_count_x, group_count_y },
+			.src_mip = src_mip,
+			.group_mip_count = group_mips,
+			.tail_mip_count = tail_mips,
+			.mode = (uint32)params->mode,
+		};
+		R3_UpdateBuffer(ctx, &downsampler->uniforms, &uniforms, sizeof(uniforms));
+
+		R3_UniformBuffer ubuffers[] = {
+			{ .buffer = &downsampler->uniforms },
+		};
+		R3_ResourceView srvs[] = {
+			{ .texture = src },
+		};
+		R3_UnorderedView uavs[1 + DOWNSAMPLE_MAX_MIPS_] = {
+			{ .buffer = &downsampler->scratch },
+		};
+		for (int32 i = 0; i < written; ++i)
+			uavs[1+i] = (R3_UnorderedView) { .texture = params->dst, .mip = dst_mip + i };
+
+		R3_SetComputePipeline(ctx, &downsampler->pipeline);
+		R3_SetComputeUniformBuffers(ctx, ArrayLength(ubuffers), ubuffers);
+		R3_SetComputeResourceViews(ctx, ArrayLength(srvs), srvs);
+		R3_SetComputeUnorderedViews(ctx, 1 + written, uavs);
+		R3_Dispatch(ctx, (uint32)group_count_x, (uint32)group_count_y, 1);
+
+		// NOTE(ljre): Keep going from the last mip we wrote
+		src = params->dst;
+		src_mip = dst_mip + written - 1;
+		dst_mip += written;
+		remaining -= written;
+		src_width = ClampMin(src_width >> written, 1);
+		src_height = ClampMin(src_height >> written, 1);
+	}
+
+	R3_SetComputeUnorderedViews(ctx, 0, NULL);
+}
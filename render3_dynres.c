@@ -0,0 +1,274 @@
+#include <base/base.h>
+#include <base/base_intrinsics.h>
+#include <base/base_assert.h>
+#include <base/base_arena.h>
+#include <layer_os/api.h>
+#include "api.h"
+
+// NOTE(ljre): std140 layout of type_UniformBuffer0 in both shaders.
+struct DynResUniforms_
+{
+	float32 uv_scale[2];
+	float32 uv_max[2];
+	float32 texel_size[2];
+	float32 sharpness;
+	float32 padding_;
+}
+typedef DynResUniforms_;
+
+#define DYNRES_GLSL_UNIFORMS_ \
+	"layout(std140) uniform type_UniformBuffer0\n" \
+	"{\n" \
+	"	vec2 uUvScale;\n" \
+	"	vec2 uUvMax;\n" \
+	"	vec2 uTexelSize;\n" \
+	"	float uSharpness;\n" \
+	"};\n"
+
+// NOTE(ljre): A single triangle covering the viewport, no vertex buffers needed.
+static char const g_dynres_vs_glsl[] =
+	DYNRES_GLSL_UNIFORMS_
+	"out vec2 vTexcoord;\n"
+	"void main()\n"
+	"{\n"
+	"	vec2 pos = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));\n"
+	"	vTexcoord = pos * uUvScale;\n"
+	"	gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);\n"
+	"}\n";
+
+static char const g_dynres_bilinear_fs_glsl[] =
+	DYNRES_GLSL_UNIFORMS_
+	"uniform sampler2D uTexture0;\n"
+	"in vec2 vTexcoord;\n"
+	"layout(location = 0) out vec4 oColor;\n"
+	"void main()\n"
+	"{\n"
+	"	vec2 uv = min(vTexcoord, uUvMax);\n"
+	"	oColor = texture(uTexture0, uv);\n"
+	"}\n";
+
+// NOTE(ljre): Unsharp mask over the bilinear result, clamped to the neighbourhood so edges don't ring.
+static char const g_dynres_sharpen_fs_glsl[] =
+	DYNRES_GLSL_UNIFORMS_
+	"uniform sampler2D uTexture0;\n"
+	"in vec2 vTexcoord;\n"
+	"layout(location = 0) out vec4 oColor;\n"
+	"void main()\n"
+	"{\n"
+	"	vec2 uv = min(vTexcoord, uUvMax);\n"
+	"	vec2 lo = 0.5 * uTexelSize;\n"
+	"	vec2 hi = uUvMax;\n"
+	"	vec4 c = texture(uTexture0, uv);\n"
+	"	vec4 n = texture(uTexture0, clamp(uv + vec2(0.0, uTexelSize.y), lo, hi));\n"
+	"	vec4 s = texture(uTexture0, clamp(uv - vec2(0.0, uTexelSize.y), lo, hi));\n"
+	"	vec4 e = texture(uTexture0, clamp(uv + vec2(uTexelSize.x, 0.0), lo, hi));\n"
+	"	vec4 w = texture(uTexture0, clamp(uv - vec2(uTexelSize.x, 0.0), lo, hi));\n"
+	"	vec4 mn = min(c, min(min(n, s), min(e, w)));\n"
+	"	vec4 mx = max(c, max(max(n, s), max(e, w)));\n"
+	"	vec4 sharp = c + uSharpness * (4.0 * c - n - s - e - w) * 0.25;\n"
+	"	oColor = clamp(sharp, mn, mx);\n"
+	"}\n";
+
+static float32
+DynResClamp_(float32 x, float32 lo, float32 hi)
+{
+	return (x < lo) ? lo : (x > hi) ? hi : x;
+}
+
+// NOTE(ljre): GPU cost is roughly proportional to the pixel count, i.e. to scale squared. Over budget we drop
+//             straight to the scale that should fit, to kill spikes within a frame or two. We only go back up
+//             after 'upscale_delay_frames' consecutive frames under the hysteresis band, and by a bounded step,
+//             so the resolution doesn't oscillate around the budget.
+static void
+DynResUpdateScale_(R3_DynamicResolution* dynres, float32 gpu_ms)
+{
+	dynres->gpu_ms = gpu_ms;
+	float32 budget = dynres->frame_budget_ms;
+	float32 scale = dynres->scale;
+
+	if (gpu_ms > budget)
+	{
+		scale *= __builtin_sqrtf(budget / gpu_ms);
+		dynres->frames_under_budget = 0;
+	}
+	else if (gpu_ms < budget * (1.0f - dynres->hysteresis))
+	{
+		if (++dynres->frames_under_budget >= dynres->upscale_delay_frames)
+		{
+			float32 target = budget * (1.0f - 0.5f * dynres->hysteresis);
+			float32 factor = __builtin_sqrtf(target / ClampMin(gpu_ms, 0.001f));
+			scale *= DynResClamp_(factor, 1.0f, 1.0f + dynres->max_scale_step);
+			dynres->frames_under_budget = 0;
+		}
+	}
+	else
+		dynres->frames_under_budget = 0;
+
+	dynres->scale = DynResClamp_(scale, dynres->min_scale, dynres->max_scale);
+
+	// NOTE(ljre): Round to multiples of 8 pixels, which keeps tiles and compute groups aligned and the size
+	//             from jittering by a pixel every frame.
+	int32 max_width = dynres->color_texture->width;
+	int32 max_height = dynres->color_texture->height;
+	dynres->width = Min(max_width, ClampMin(((int32)(max_width * dynres->scale) + 7) & ~7, 8));
+	dynres->height = Min(max_height, ClampMin(((int32)(max_height * dynres->scale) + 7) & ~7, 8));
+}
+
+//------------------------------------------------------------------------
+API R3_DynamicResolution
+R3_MakeDynamicResolution(R3_Context* ctx, R3_DynamicResolutionDesc const* desc)
+{
+	Trace();
+	R3_DynamicResolution out = {};
+	SafeAssert(desc->color_texture && desc->frame_budget_ms > 0.0f);
+
+	out.color_texture = desc->color_texture;
+	out.frame_budget_ms = desc->frame_budget_ms;
+	out.min_scale = (desc->min_scale > 0.0f) ? desc->min_scale : 0.5f;
+	out.max_scale = (desc->max_scale > 0.0f) ? desc->max_scale : 1.0f;
+	out.hysteresis = (desc->hysteresis > 0.0f) ? desc->hysteresis : 0.1f;
+	out.upscale_delay_frames = (desc->upscale_delay_frames > 0) ? desc->upscale_delay_frames : 30;
+	out.max_scale_step = (desc->max_scale_step > 0.0f) ? desc->max_scale_step : 0.05f;
+	out.filter = desc->filter;
+	out.sharpness = desc->sharpness;
+	SafeAssert(out.min_scale <= out.max_scale && out.max_scale <= 1.0f);
+
+	out.scale = out.max_scale;
+	out.width = out.color_texture->width;
+	out.height = out.color_texture->height;
+
+	R3_ContextInfo info = R3_QueryInfo(ctx);
+	out.has_timer = info.has_timestamp_query;
+	if (out.has_timer)
+	{
+		for (intz i = 0; i < ArrayLength(out.timestamps); ++i)
+		{
+			out.timestamps[i][0] = R3_MakeQuery(ctx, R3_QueryKind_Timestamp);
+			out.timestamps[i][1] = R3_MakeQuery(ctx, R3_QueryKind_Timestamp);
+		}
+	}
+
+	Buffer vs = { .data = (uint8 const*)g_dynres_vs_glsl, .size = sizeof(g_dynres_vs_glsl) };
+	Buffer fs = { .data = (uint8 const*)g_dynres_bilinear_fs_glsl, .size = sizeof(g_dynres_bilinear_fs_glsl) };
+	if (desc->filter == R3_UpscaleFilter_Sharpened)
+		fs = (Buffer) { .data = (uint8 const*)g_dynres_sharpen_fs_glsl, .size = sizeof(g_dynres_sharpen_fs_glsl) };
+	out.pipeline = R3_MakePipeline(ctx, &(R3_PipelineDesc) {
+		.glsl = { .vs = vs, .fs = fs },
+		.dx50 = { .vs = desc->dx50_vs, .ps = desc->dx50_ps },
+	});
+	out.sampler = R3_MakeSampler(ctx, &(R3_SamplerDesc) {
+		.filtering = R3_TextureFiltering_Linear,
+	});
+	out.uniforms = R3_MakeBuffer(ctx, &(R3_BufferDesc) {
+		.size = sizeof(DynResUniforms_),
+		.binding_flags = R3_BindingFlag_UniformBuffer,
+		.usage = R3_Usage_Dynamic,
+	});
+
+	return out;
+}
+
+API void
+R3_FreeDynamicResolution(R3_Context* ctx, R3_DynamicResolution* dynres)
+{
+	Trace();
+
+	if (dynres->has_timer)
+	{
+		for (intz i = 0; i < ArrayLength(dynres->timestamps); ++i)
+		{
+			R3_FreeQuery(ctx, &dynres->timestamps[i][0]);
+			R3_FreeQuery(ctx, &dynres->timestamps[i][1]);
+		}
+	}
+	R3_FreePipeline(ctx, &dynres->pipeline);
+	R3_FreeSampler(ctx, &dynres->sampler);
+	R3_FreeBuffer(ctx, &dynres->uniforms);
+
+	*dynres = (R3_DynamicResolution) {};
+}
+
+API R3_Viewport
+R3_BeginDynamicResolutionFrame(R3_Context* ctx, R3_DynamicResolution* dynres)
+{
+	Trace();
+
+	if (dynres->has_timer)
+	{
+		// NOTE(ljre): Read every frame that finished, oldest first; the newest one drives the scale.
+		while (dynres->read_frame < dynres->frame)
+		{
+			intz slot = dynres->read_frame % ArrayLength(dynres->timestamps);
+			R3_QueryResult begin, end;
+			if (!R3_GetQueryResult(ctx, &dynres->timestamps[slot][0], &begin) ||
+				!R3_GetQueryResult(ctx, &dynres->timestamps[slot][1], &end))
+			{
+				break;
+			}
+			++dynres->read_frame;
+			if (!begin.disjoint && !end.disjoint && end.timestamp_ns > begin.timestamp_ns)
+				DynResUpdateScale_(dynres, (float32)(end.timestamp_ns - begin.timestamp_ns) / 1000000.0f);
+		}
+
+		// NOTE(ljre): Every slot is in flight, so reusing one would mean blocking. Skip timing this frame.
+		dynres->timing_frame = (dynres->frame - dynres->read_frame < ArrayLength(dynres->timestamps));
+		if (dynres->timing_frame)
+			R3_WriteTimestamp(ctx, &dynres->timestamps[dynres->frame % ArrayLength(dynres->timestamps)][0]);
+	}
+
+	return (R3_Viewport) {
+		.width = (float32)dynres->width,
+		.height = (float32)dynres->height,
+		.max_depth = 1.0f,
+	};
+}
+
+API void
+R3_DynamicResolutionUpscale(R3_Context* ctx, R3_DynamicResolution* dynres)
+{
+	Trace();
+	R3_Texture* texture = dynres->color_texture;
+
+	DynResUniforms_ uniforms = {
+		.uv_scale = {
+			(float32)dynres->width / (float32)texture->width,
+			(float32)dynres->height / (float32)texture->height,
+		},
+		.texel_size = {
+			1.0f / (float32)texture->width,
+			1.0f / (float32)texture->height,
+		},
+		.sharpness = dynres->sharpness,
+	};
+	// NOTE(ljre): Stop half a texel short of the rendered area so bilinear filtering never reads past it.
+	uniforms.uv_max[0] = uniforms.uv_scale[0] - 0.5f * uniforms.texel_size[0];
+	uniforms.uv_max[1] = uniforms.uv_scale[1] - 0.5f * uniforms.texel_size[1];
+	R3_UpdateBuffer(ctx, &dynres->uniforms, &uniforms, sizeof(uniforms));
+
+	R3_UniformBuffer ubuffers[] = {
+		{ .buffer = &dynres->uniforms, .size = sizeof(uniforms) },
+	};
+	R3_ResourceView views[] = {
+		{ .texture = texture },
+	};
+	R3_Sampler* samplers[] = { &dynres->sampler };
+
+	R3_SetPipeline(ctx, &dynres->pipeline);
+	R3_SetUniformBuffers(ctx, ArrayLength(ubuffers), ubuffers);
+	R3_SetResourceViews(ctx, ArrayLength(views), views);
+	R3_SetSamplers(ctx, ArrayLength(samplers), samplers);
+	R3_SetPrimitiveType(ctx, R3_PrimitiveType_TriangleList);
+	R3_Draw(ctx, 0, 3, 0, 1);
+}
+
+API void
+R3_EndDynamicResolutionFrame(R3_Context* ctx, R3_DynamicResolution* dynres)
+{
+	Trace();
+
+	if (dynres->has_timer && dynres->timing_frame)
+	{
+		R3_WriteTimestamp(ctx, &dynres->timestamps[dynres->frame % ArrayLength(dynres->timestamps)][1]);
+		++dynres->frame;
+	}
+}
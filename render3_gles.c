@@ -20,6 +20,76 @@ struct VertexAttrib_
 }
 typedef VertexAttrib_;
 
+// NOTE(ljre): Ways a resource can be consumed after being written by a shader, one per glMemoryBarrier bit
+//             we care about.
+enum OglAccess_
+{
+	OglAccess_VertexAttrib = 0,
+	OglAccess_ElementArray,
+	OglAccess_Uniform,
+	OglAccess_TextureFetch,
+	OglAccess_ShaderImage,
+	OglAccess_Command,
+	OglAccess_BufferUpdate,
+	OglAccess_TextureUpdate,
+	OglAccess_ShaderStorage,
+	OglAccess_Framebuffer,
+
+	OglAccess__Count,
+}
+typedef OglAccess_;
+
+static GLbitfield const g_ogl_access_barrier_bits[OglAccess__Count] = {
+	[OglAccess_VertexAttrib] = GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT,
+	[OglAccess_ElementArray] = GL_ELEMENT_ARRAY_BARRIER_BIT,
+	[OglAccess_Uniform] = GL_UNIFORM_BARRIER_BIT,
+	[OglAccess_TextureFetch] = GL_TEXTURE_FETCH_BARRIER_BIT,
+	[OglAccess_ShaderImage] = GL_SHADER_IMAGE_ACCESS_BARRIER_BIT,
+	[OglAccess_Command] = GL_COMMAND_BARRIER_BIT,
+	[OglAccess_BufferUpdate] = GL_BUFFER_UPDATE_BARRIER_BIT,
+	[OglAccess_TextureUpdate] = GL_TEXTURE_UPDATE_BARRIER_BIT,
+	[OglAccess_ShaderStorage] = GL_SHADER_STORAGE_BARRIER_BIT,
+	[OglAccess_Framebuffer] = GL_FRAMEBUFFER_BARRIER_BIT,
+};
+
+#define OGL_WRITTEN_CAPACITY_ 128
+
+// NOTE(ljre): Keys are the GL name, with bit 32 set for textures since they live in a different namespace.
+//             A key of 0 is an empty slot.
+struct OglWrittenResource_
+{
+	uint64 key;
+	uint64 serial;
+}
+typedef OglWrittenResource_;
+
+#define OGL_SHADER_MODULE_CAPACITY_ 512
+
+// NOTE(ljre): Compiled shader objects, shared by every pipeline made from the same stage source. Keys hash the
+//             stage kind and every line handed to glShaderSource. On a key match the source is read back from
+//             the shader object and compared, so a hash collision can't share the wrong shader. A refcount of 0
+//             is an empty slot and -1 a deleted one.
+struct OglShaderModule_
+{
+	uint64 key;
+	GLenum kind;
+	uint32 shader;
+	int32 refcount;
+}
+typedef OglShaderModule_;
+
+#define OGL_FRAMEBUFFER_CAPACITY_ 32
+
+// NOTE(ljre): FBOs made by R3_BeginRenderPass(), keyed by their attachments (see OglAttachmentKey_()). An
+//             entry with 'fbo == 0' is empty. The least recently used one is replaced when the cache is full.
+struct OglFramebuffer_
+{
+	uint64 attachments[9]; // 8 colors, then depth-stencil
+	uint32 fbo;
+	uint64 last_used;
+}
+typedef OglFramebuffer_;
+
 struct R3_Context
 {
     OS_OpenGLApi api;
@@ -30,6 +100,15 @@ struct R3_Context
 	bool has_explicit_attrib_location;
 	bool has_uniformbuffer;
 	bool has_anisotropy;
+	bool has_program_binary;
+	bool has_parallel_compile;
+	bool has_invalidate_framebuffer;
+	bool has_viewport_array;
+	char const* vertex_layer_extension; // "#extension" lines enabling gl_Layer/gl_ViewportIndex in vertex shaders
+	GLenum occlusion_target; // the best of GL_ANY_SAMPLES_PASSED_CONSERVATIVE, GL_ANY_SAMPLES_PASSED and GL_SAMPLES_PASSED
+	bool skip_draws; // the bound pipeline isn't ready or failed to build
+	bool scissor_test; // GL_SCISSOR_TEST as set by the bound pipeline
+	R3_ProgramCache program_cache; // only set if has_program_binary
 
 	uint32 global_vao;
 	uint32 curr_program;
@@ -39,6 +118,37 @@ struct R3_Context
 	GLenum curr_prim;
 	GLenum curr_index_type;
 	VertexAttrib_ curr_attribs[16];
+
+	// NOTE(ljre): Hazard tracking. Every dispatch bumps 'hazard_serial' and stamps the resources bound as
+	//             unordered views with it. A barrier bit covers everything written before it was emitted, so a
+	//             resource needs that bit only if its stamp is newer than 'barrier_serials' for that access.
+	//             Barriers are only emitted right before a command that consumes the resource in that way.
+	uint64 hazard_serial;
+	uint64 last_write_serial;
+	uint64 barrier_serials[OglAccess__Count];
+	int32 written_count;
+	OglWrittenResource_ written[OGL_WRITTEN_CAPACITY_];
+
+	uint64 bound_views[16];
+	uint64 bound_uavs[16];
+	uint64 bound_ubos[16];
+	uint64 bound_vbuffers[16];
+	uint64 bound_ibuffer;
+
+	OglShaderModule_ shader_modules[OGL_SHADER_MODULE_CAPACITY_];
+
+	uint64 framebuffer_serial;
+	OglFramebuffer_ framebuffers[OGL_FRAMEBUFFER_CAPACITY_];
+
+	// NOTE(ljre): Attachments to invalidate at R3_EndRenderPass().
+	bool in_render_pass;
+	int32 pass_discard_count;
+	GLenum pass_discards[10];
+
+	R3_FrameStats stats; // frame in progress
+	R3_FrameStats last_stats;
+	R3_Timeline* timeline;
+	R3_Capture* capture;
 };
 
 #ifdef CONFIG_DEBUG
@@ -141,11 +251,652 @@ OglRebindTextures_(R3_Context* ctx)
 		}
 
 		int32 location = ctx->api.glGetUniformLocation(ctx->curr_program, name);
-		if (location)
+		if (location != -1)
 			ctx->api.glUniform1i(location, i);
 	}
 }
 
+// NOTE(ljre): Querying the status blocks until the driver is done with the shader or program. Both log the
+//             info log on failure.
+static bool
+OglCheckShader_(R3_Context* ctx, uint32 shader, GLenum kind)
+{
+	int32 success;
+	ctx->api.glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		char const* kind_name = "compute";
+		if (kind == GL_VERTEX_SHADER)
+			kind_name = "vertex";
+		else if (kind == GL_FRAGMENT_SHADER)
+			kind_name = "fragment";
+
+		ArenaSavepoint scratch = ArenaSave(OS_ScratchArena(NULL, 0));
+		int32 log_size = 0;
+		ctx->api.glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &log_size);
+		char* info_log = ArenaPushArray(scratch.arena, char, ClampMin(log_size, 1));
+		int32 log_length = 0;
+		ctx->api.glGetShaderInfoLog(shader, ClampMin(log_size, 1), &log_length, info_log);
+		Log(LOG_ERROR, "render3: failed to compile %s shader:\n%.*s", kind_name, (int)log_length, info_log);
+		ArenaRestore(scratch);
+	}
+
+	return success;
+}
+
+static bool
+OglCheckProgram_(R3_Context* ctx, uint32 program)
+{
+	int32 success;
+	ctx->api.glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		ArenaSavepoint scratch = ArenaSave(OS_ScratchArena(NULL, 0));
+		int32 log_size = 0;
+		ctx->api.glGetProgramiv(program, GL_INFO_LOG_LENGTH, &log_size);
+		char* info_log = ArenaPushArray(scratch.arena, char, ClampMin(log_size, 1));
+		int32 log_length = 0;
+		ctx->api.glGetProgramInfoLog(program, ClampMin(log_size, 1), &log_length, info_log);
+		Log(LOG_ERROR, "render3: failed to link program:\n%.*s", (int)log_length, info_log);
+		ArenaRestore(scratch);
+	}
+
+	return success;
+}
+
+// NOTE(ljre): These don't check for errors, see OglCompileShader_ and OglLinkProgram_.
+static uint32
+OglStartCompileShader_(R3_Context* ctx, GLenum kind, intz line_count, char const* const lines[], int32 const lengths[])
+{
+	uint32 shader = ctx->api.glCreateShader(kind);
+	ctx->api.glShaderSource(shader, line_count, lines, lengths);
+	ctx->api.glCompileShader(shader);
+	return shader;
+}
+
+static uint32
+OglStartLinkProgram_(R3_Context* ctx, intz shader_count, uint32 const shaders[])
+{
+	uint32 program = ctx->api.glCreateProgram();
+	if (ctx->program_cache.store)
+		ctx->api.glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	for (intz i = 0; i < shader_count; ++i)
+		ctx->api.glAttachShader(program, shaders[i]);
+	ctx->api.glLinkProgram(program);
+	return program;
+}
+
+// NOTE(ljre): Both return 0 on failure.
+static uint32
+OglCompileShader_(R3_Context* ctx, GLenum kind, intz line_count, char const* const lines[], int32 const lengths[])
+{
+	uint32 shader = OglStartCompileShader_(ctx, kind, line_count, lines, lengths);
+	if (!OglCheckShader_(ctx, shader, kind))
+	{
+		ctx->api.glDeleteShader(shader);
+		shader = 0;
+	}
+
+	return shader;
+}
+
+static uint32
+OglLinkProgram_(R3_Context* ctx, intz shader_count, uint32 const shaders[])
+{
+	uint32 program = OglStartLinkProgram_(ctx, shader_count, shaders);
+	for (intz i = 0; i < shader_count; ++i)
+		ctx->api.glDetachShader(program, shaders[i]);
+	if (!OglCheckProgram_(ctx, program))
+	{
+		ctx->api.glDeleteProgram(program);
+		program = 0;
+	}
+
+	return program;
+}
+
+// NOTE(ljre): Header of the blobs handed to R3_ProgramCache. The key is stored again so that a truncated or
+//             misplaced file is caught before reaching the driver.
+struct OglProgramBlobHeader_
+{
+	uint32 magic;
+	uint32 binary_format;
+	uint64 key;
+	uint32 binary_size;
+	uint32 padding_;
+}
+typedef OglProgramBlobHeader_;
+
+#define OGL_PROGRAM_BLOB_MAGIC_ 0x42503352u // "R3PB"
+
+static uint64
+OglHashBytes_(uint64 hash, void const* data, intz size)
+{
+	uint8 const* bytes = (uint8 const*)data;
+	for (intz i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+// NOTE(ljre): FNV-1a over every source string handed to glShaderSource, in order. Sizes are hashed too, so
+//             moving bytes from one string to the next changes the key.
+static uint64
+OglProgramCacheKey_(R3_Context* ctx, intz part_count, String const parts[])
+{
+	uint64 hash = 0xcbf29ce484222325ull;
+	for (intz i = 0; i < part_count; ++i)
+	{
+		hash = OglHashBytes_(hash, &parts[i].size, sizeof(parts[i].size));
+		hash = OglHashBytes_(hash, parts[i].data, parts[i].size);
+	}
+	hash = OglHashBytes_(hash, ctx->info.driver_renderer.data, ctx->info.driver_renderer.size);
+	hash = OglHashBytes_(hash, ctx->info.driver_version.data, ctx->info.driver_version.size);
+	return hash;
+}
+
+// NOTE(ljre): Returns 0 on a miss or if the driver rejects the binary, in which case the caller just compiles.
+static uint32
+OglLoadCachedProgram_(R3_Context* ctx, uint64 key)
+{
+	ArenaSavepoint scratch = ArenaSave(OS_ScratchArena(NULL, 0));
+	Buffer blob = ctx->program_cache.load(ctx->program_cache.user_data, key, scratch.arena);
+	uint32 program = 0;
+
+	OglProgramBlobHeader_ header = {};
+	if (blob.size >= (intz)sizeof(header))
+		MemoryCopy(&header, blob.data, sizeof(header));
+	if (header.magic == OGL_PROGRAM_BLOB_MAGIC_ && header.key == key && header.binary_size == blob.size - sizeof(header))
+	{
+		program = ctx->api.glCreateProgram();
+		ctx->api.glProgramBinary(program, header.binary_format, blob.data + sizeof(header), (int32)header.binary_size);
+
+		int32 success = 0;
+		ctx->api.glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success)
+		{
+			Log(LOG_INFO, "render3: cached program %016llx was rejected by the driver, recompiling", (unsigned long long)key);
+			ctx->api.glDeleteProgram(program);
+			program = 0;
+		}
+	}
+	else if (blob.size)
+		Log(LOG_WARN, "render3: cached program %016llx is corrupted, recompiling", (unsigned long long)key);
+
+	ArenaRestore(scratch);
+	return program;
+}
+
+static void
+OglStoreCachedProgram_(R3_Context* ctx, uint64 key, uint32 program)
+{
+	int32 binary_size = 0;
+	ctx->api.glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binary_size);
+	if (binary_size <= 0)
+		return;
+
+	ArenaSavepoint scratch = ArenaSave(OS_ScratchArena(NULL, 0));
+	uint8* blob = ArenaPushArray(scratch.arena, uint8, sizeof(OglProgramBlobHeader_) + binary_size);
+	int32 written = 0;
+	GLenum binary_format = 0;
+	ctx->api.glGetProgramBinary(program, binary_size, &written, &binary_format, blob + sizeof(OglProgramBlobHeader_));
+
+	if (written > 0)
+	{
+		OglProgramBlobHeader_ header = {
+			.magic = OGL_PROGRAM_BLOB_MAGIC_,
+			.binary_format = binary_format,
+			.key = key,
+			.binary_size = (uint32)written,
+		};
+		MemoryCopy(blob, &header, sizeof(header));
+		ctx->program_cache.store(ctx->program_cache.user_data, key, (Buffer) {
+			.data = blob,
+			.size = sizeof(header) + written,
+		});
+	}
+	ArenaRestore(scratch);
+}
+
+static bool
+OglShaderSourceEquals_(R3_Context* ctx, uint32 shader, intz line_count, char const* const lines[])
+{
+	intz total = 0;
+	for (intz i = 0; i < line_count; ++i)
+		total += StringFromCString(lines[i]).size;
+
+	// NOTE(ljre): GL_SHADER_SOURCE_LENGTH counts the null terminator.
+	int32 length = 0;
+	ctx->api.glGetShaderiv(shader, GL_SHADER_SOURCE_LENGTH, &length);
+	if (length != total + 1)
+		return false;
+
+	ArenaSavepoint scratch = ArenaSave(OS_ScratchArena(NULL, 0));
+	char* source = ArenaPushArray(scratch.arena, char, length);
+	ctx->api.glGetShaderSource(shader, length, NULL, source);
+	bool equals = true;
+	intz offset = 0;
+	for (intz i = 0; i < line_count && equals; ++i)
+	{
+		String line = StringFromCString(lines[i]);
+		equals = (MemoryCompare(source + offset, line.data, line.size) == 0);
+		offset += line.size;
+	}
+	ArenaRestore(scratch);
+
+	return equals;
+}
+
+// NOTE(ljre): Returns a shader object compiling (or already compiled) from these lines, with its status not yet
+//             checked. If the cache is full, the shader is simply not shared.
+static uint32
+OglAcquireShader_(R3_Context* ctx, GLenum kind, intz line_count, char const* const lines[])
+{
+	uint64 key = OglHashBytes_(0xcbf29ce484222325ull, &kind, sizeof(kind));
+	for (intz i = 0; i < line_count; ++i)
+	{
+		String line = StringFromCString(lines[i]);
+		key = OglHashBytes_(key, &line.size, sizeof(line.size));
+		key = OglHashBytes_(key, line.data, line.size);
+	}
+
+	uint32 mask = OGL_SHADER_MODULE_CAPACITY_ - 1;
+	intz free_index = -1;
+	for (uint32 i = 0, at = (uint32)key & mask; i < OGL_SHADER_MODULE_CAPACITY_; ++i, at = (at+1) & mask)
+	{
+		OglShaderModule_* module = &ctx->shader_modules[at];
+		if (module->refcount <= 0)
+		{
+			if (free_index == -1)
+				free_index = at;
+			if (module->refcount == 0)
+				break;
+		}
+		else if (module->key == key && module->kind == kind && OglShaderSourceEquals_(ctx, module->shader, line_count, lines))
+		{
+			++module->refcount;
+			return module->shader;
+		}
+	}
+
+	uint32 shader = OglStartCompileShader_(ctx, kind, line_count, lines, NULL);
+	if (free_index != -1)
+	{
+		ctx->shader_modules[free_index] = (OglShaderModule_) {
+			.key = key,
+			.kind = kind,
+			.shader = shader,
+			.refcount = 1,
+		};
+	}
+	return shader;
+}
+
+static void
+OglReleaseShader_(R3_Context* ctx, uint32 shader)
+{
+	for (intz i = 0; i < ArrayLength(ctx->shader_modules); ++i)
+	{
+		OglShaderModule_* module = &ctx->shader_modules[i];
+		if (module->refcount > 0 && module->shader == shader)
+		{
+			if (--module->refcount == 0)
+			{
+				ctx->api.glDeleteShader(shader);
+				module->refcount = -1;
+			}
+			return;
+		}
+	}
+
+	ctx->api.glDeleteShader(shader);
+}
+
+// NOTE(ljre): Collects the result of a pipeline made with 'flag_async'. Blocks if the driver isn't done yet.
+//             On failure the pipeline ends up with no program, and draws with it are skipped.
+static void
+OglFinishPendingPipeline_(R3_Context* ctx, R3_Pipeline* pipeline)
+{
+	uint32 program = pipeline->gl_program;
+	uint32 vertex_shader = pipeline->gl_vs;
+	uint32 fragment_shader = pipeline->gl_fs;
+
+	bool ok = OglCheckShader_(ctx, vertex_shader, GL_VERTEX_SHADER);
+	ok = OglCheckShader_(ctx, fragment_shader, GL_FRAGMENT_SHADER) && ok;
+	ok = ok && OglCheckProgram_(ctx, program);
+
+	ctx->api.glDetachShader(program, vertex_shader);
+	ctx->api.glDetachShader(program, fragment_shader);
+
+	if (!ok)
+	{
+		ctx->api.glDeleteProgram(program);
+		OglReleaseShader_(ctx, vertex_shader);
+		OglReleaseShader_(ctx, fragment_shader);
+		pipeline->gl_program = 0;
+		pipeline->gl_vs = 0;
+		pipeline->gl_fs = 0;
+		// NOTE(ljre): R3_FreePipeline() won't see a program anymore, so undo what R3_MakePipeline() counted.
+		++ctx->stats.resources_destroyed;
+		--ctx->stats.live.pipelines;
+	}
+	else if (ctx->program_cache.store)
+		OglStoreCachedProgram_(ctx, pipeline->gl_cache_key, program);
+
+	pipeline->gl_pending = false;
+}
+
+static inline uint64
+OglBufferKey_(R3_Buffer const* buffer)
+{
+	return (buffer) ? buffer->gl_id : 0;
+}
+
+static inline uint64
+OglTextureKey_(R3_Texture const* texture)
+{
+	return (texture && texture->gl_id) ? (uint64)texture->gl_id | (1ull << 32) : 0;
+}
+
+static inline uint64
+OglViewKey_(R3_Buffer const* buffer, R3_Texture const* texture)
+{
+	return (buffer) ? OglBufferKey_(buffer) : OglTextureKey_(texture);
+}
+
+static inline intz
+OglWrittenSlot_(uint64 key)
+{
+	return (intz)((key * 0x9E3779B97F4A7C15ull) >> 32) & (OGL_WRITTEN_CAPACITY_-1);
+}
+
+static OglWrittenResource_*
+OglFindWritten_(R3_Context* ctx, uint64 key)
+{
+	intz mask = OGL_WRITTEN_CAPACITY_-1;
+	for (intz i = OglWrittenSlot_(key), probes = 0; probes <= mask; i = (i+1) & mask, ++probes)
+	{
+		if (ctx->written[i].key == key)
+			return &ctx->written[i];
+		if (!ctx->written[i].key)
+			break;
+	}
+	return NULL;
+}
+
+static void
+OglEmitBarrier_(R3_Context* ctx, GLbitfield bits)
+{
+	if (!bits)
+		return;
+	ctx->api.glMemoryBarrier(bits);
+	for (intz i = 0; i < OglAccess__Count; ++i)
+	{
+		if (bits & g_ogl_access_barrier_bits[i])
+			ctx->barrier_serials[i] = ctx->hazard_serial;
+	}
+}
+
+static void
+OglMarkWritten_(R3_Context* ctx, uint64 key)
+{
+	if (!key)
+		return;
+
+	OglWrittenResource_* entry = OglFindWritten_(ctx, key);
+	if (!entry)
+	{
+		if (ctx->written_count*2 >= OGL_WRITTEN_CAPACITY_)
+		{
+			// NOTE(ljre): Drop whatever has already been made visible to every kind of access.
+			uint64 min_serial = UINT64_MAX;
+			for (intz i = 0; i < OglAccess__Count; ++i)
+				min_serial = Min(min_serial, ctx->barrier_serials[i]);
+
+			OglWrittenResource_ old[OGL_WRITTEN_CAPACITY_];
+			MemoryCopy(old, ctx->written, sizeof(old));
+			MemoryZero(ctx->written, sizeof(ctx->written));
+			ctx->written_count = 0;
+			for (intz i = 0; i < OGL_WRITTEN_CAPACITY_; ++i)
+			{
+				if (old[i].key && old[i].serial > min_serial)
+				{
+					intz mask = OGL_WRITTEN_CAPACITY_-1;
+					intz slot = OglWrittenSlot_(old[i].key);
+					while (ctx->written[slot].key)
+						slot = (slot+1) & mask;
+					ctx->written[slot] = old[i];
+					++ctx->written_count;
+				}
+			}
+
+			// NOTE(ljre): Still too many things in flight. Just flush everything.
+			if (ctx->written_count*2 >= OGL_WRITTEN_CAPACITY_)
+			{
+				OglEmitBarrier_(ctx, GL_ALL_BARRIER_BITS);
+				MemoryZero(ctx->written, sizeof(ctx->written));
+				ctx->written_count = 0;
+			}
+		}
+
+		intz mask = OGL_WRITTEN_CAPACITY_-1;
+		intz slot = OglWrittenSlot_(key);
+		while (ctx->written[slot].key)
+			slot = (slot+1) & mask;
+		entry = &ctx->written[slot];
+		entry->key = key;
+		++ctx->written_count;
+	}
+
+	entry->serial = ctx->hazard_serial;
+	ctx->last_write_serial = ctx->hazard_serial;
+}
+
+static inline GLbitfield
+OglRequireAccess_(R3_Context* ctx, uint64 key, OglAccess_ access)
+{
+	if (!key || ctx->barrier_serials[access] >= ctx->last_write_serial)
+		return 0;
+
+	OglWrittenResource_ const* entry = OglFindWritten_(ctx, key);
+	if (entry && entry->serial > ctx->barrier_serials[access])
+		return g_ogl_access_barrier_bits[access];
+	return 0;
+}
+
+static GLbitfield
+OglRequireBoundShaderAccess_(R3_Context* ctx)
+{
+	GLbitfield bits = 0;
+	for (intz i = 0; i < ArrayLength(ctx->bound_views); ++i)
+	{
+		uint64 key = ctx->bound_views[i];
+		bits |= OglRequireAccess_(ctx, key, (key >> 32) ? OglAccess_TextureFetch : OglAccess_ShaderStorage);
+	}
+	for (intz i = 0; i < ArrayLength(ctx->bound_ubos); ++i)
+		bits |= OglRequireAccess_(ctx, ctx->bound_ubos[i], OglAccess_Uniform);
+	return bits;
+}
+
+// NOTE(ljre): Attachments of render passes and render targets, and both sides of a resolve. Multisampled
+//             textures are renderbuffers that can't be written by a shader, so they never need it.
+static void
+OglFlushFramebufferHazards_(R3_Context* ctx, uint32 const texture_ids[], intz count)
+{
+	if (ctx->last_write_serial == 0)
+		return;
+
+	GLbitfield bits = 0;
+	for (intz i = 0; i < count; ++i)
+	{
+		if (texture_ids[i])
+			bits |= OglRequireAccess_(ctx, (uint64)texture_ids[i] | (1ull << 32), OglAccess_Framebuffer);
+	}
+	OglEmitBarrier_(ctx, bits);
+}
+
+static void
+OglFlushDrawHazards_(R3_Context* ctx, bool indexed, R3_Buffer const* indirect)
+{
+	if (ctx->last_write_serial == 0)
+		return;
+
+	GLbitfield bits = OglRequireBoundShaderAccess_(ctx);
+	for (intz i = 0; i < ArrayLength(ctx->bound_vbuffers); ++i)
+		bits |= OglRequireAccess_(ctx, ctx->bound_vbuffers[i], OglAccess_VertexAttrib);
+	if (indexed)
+		bits |= OglRequireAccess_(ctx, ctx->bound_ibuffer, OglAccess_ElementArray);
+	if (indirect)
+		bits |= OglRequireAccess_(ctx, OglBufferKey_(indirect), OglAccess_Command);
+	OglEmitBarrier_(ctx, bits);
+}
+
+static void
+OglFlushDispatchHazards_(R3_Context* ctx, R3_Buffer const* indirect)
+{
+	if (ctx->last_write_serial == 0)
+		return;
+
+	GLbitfield bits = OglRequireBoundShaderAccess_(ctx);
+	for (intz i = 0; i < ArrayLength(ctx->bound_uavs); ++i)
+	{
+		uint64 key = ctx->bound_uavs[i];
+		bits |= OglRequireAccess_(ctx, key, (key >> 32) ? OglAccess_ShaderImage : OglAccess_ShaderStorage);
+	}
+	if (indirect)
+		bits |= OglRequireAccess_(ctx, OglBufferKey_(indirect), OglAccess_Command);
+	OglEmitBarrier_(ctx, bits);
+}
+
+static void
+OglMarkDispatchWrites_(R3_Context* ctx)
+{
+	++ctx->hazard_serial;
+	for (intz i = 0; i < ArrayLength(ctx->bound_uavs); ++i)
+		OglMarkWritten_(ctx, ctx->bound_uavs[i]);
+}
+
+//------------------------------------------------------------------------
+// NOTE(ljre): Textures and renderbuffers live in different namespaces, so tag them apart.
+static inline uint64
+OglAttachmentKey_(R3_Texture const* texture)
+{
+	if (!texture)
+		return 0;
+	if (texture->gl_id)
+		return (uint64)texture->gl_id | (1ull << 32);
+	return (uint64)texture->gl_renderbuffer_id | (1ull << 33);
+}
+
+static GLenum
+OglDepthAttachment_(R3_Format format)
+{
+	return (format == R3_Format_D24S8) ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+}
+
+static void
+OglAttachTexture_(R3_Context* ctx, GLenum attachment, R3_Texture const* texture)
+{
+	if (texture->gl_id && texture->gl_target != GL_TEXTURE_2D)
+	{
+		SafeAssert(ctx->info.has_layered_rendering);
+		ctx->api.glFramebufferTexture(GL_FRAMEBUFFER, attachment, texture->gl_id, 0);
+	}
+	else if (texture->gl_id)
+		ctx->api.glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture->gl_id, 0);
+	else if (texture->gl_renderbuffer_id)
+		ctx->api.glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, texture->gl_renderbuffer_id);
+}
+
+// NOTE(ljre): Returns the FBO for the attachments in 'desc', making one if needed. The FBO is left bound.
+static uint32
+OglFindFramebuffer_(R3_Context* ctx, R3_RenderPassDesc const* desc)
+{
+	uint64 attachments[9] = {};
+	bool any = false;
+	for (intz i = 0; i < 8; ++i)
+	{
+		attachments[i] = OglAttachmentKey_(desc->color_textures[i]);
+		any |= (attachments[i] != 0);
+	}
+	attachments[8] = OglAttachmentKey_(desc->depth_stencil_texture);
+	any |= (attachments[8] != 0);
+	if (!any)
+	{
+		ctx->api.glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		return 0;
+	}
+
+	OglFramebuffer_* victim = &ctx->framebuffers[0];
+	for (intz i = 0; i < ArrayLength(ctx->framebuffers); ++i)
+	{
+		OglFramebuffer_* entry = &ctx->framebuffers[i];
+		if (entry->fbo && MemoryCompare(entry->attachments, attachments, sizeof(attachments)) == 0)
+		{
+			entry->last_used = ++ctx->framebuffer_serial;
+			ctx->api.glBindFramebuffer(GL_FRAMEBUFFER, entry->fbo);
+			return entry->fbo;
+		}
+		if (victim->fbo && (!entry->fbo || entry->last_used < victim->last_used))
+			victim = entry;
+	}
+
+	if (victim->fbo)
+		ctx->api.glDeleteFramebuffers(1, &victim->fbo);
+	MemoryCopy(victim->attachments, attachments, sizeof(attachments));
+	victim->last_used = ++ctx->framebuffer_serial;
+	ctx->api.glGenFramebuffers(1, &victim->fbo);
+	ctx->api.glBindFramebuffer(GL_FRAMEBUFFER, victim->fbo);
+
+	GLenum draw_buffers[8];
+	intz draw_buffer_count = 0;
+	for (intz i = 0; i < 8; ++i)
+	{
+		draw_buffers[i] = GL_NONE;
+		if (desc->color_textures[i])
+		{
+			OglAttachTexture_(ctx, GL_COLOR_ATTACHMENT0+i, desc->color_textures[i]);
+			draw_buffers[i] = GL_COLOR_ATTACHMENT0+i;
+			draw_buffer_count = i+1;
+		}
+	}
+	if (desc->depth_stencil_texture)
+		OglAttachTexture_(ctx, OglDepthAttachment_(desc->depth_stencil_texture->format), desc->depth_stencil_texture);
+	ctx->api.glDrawBuffers(draw_buffer_count, draw_buffers);
+
+	GLenum status = ctx->api.glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+		Log(LOG_ERROR, "render3: render pass framebuffer is incomplete (status 0x%x)", status);
+
+	return victim->fbo;
+}
+
+// NOTE(ljre): GL names are reused, so drop every cached FBO that refers to a texture being freed.
+static void
+OglForgetFramebuffers_(R3_Context* ctx, R3_Texture const* texture)
+{
+	uint64 key = OglAttachmentKey_(texture);
+	if (!key)
+		return;
+	for (intz i = 0; i < ArrayLength(ctx->framebuffers); ++i)
+	{
+		OglFramebuffer_* entry = &ctx->framebuffers[i];
+		if (!entry->fbo)
+			continue;
+		for (intz j = 0; j < ArrayLength(entry->attachments); ++j)
+		{
+			if (entry->attachments[j] == key)
+			{
+				ctx->api.glDeleteFramebuffers(1, &entry->fbo);
+				*entry = (OglFramebuffer_) {};
+				break;
+			}
+		}
+	}
+}
+
 //------------------------------------------------------------------------
 API R3_Context*
 R3_GL_MakeContext(Arena* arena, R3_ContextDesc const* desc)
@@ -239,20 +990,30 @@ R3_GL_MakeContext(Arena* arena, R3_ContextDesc const* desc)
 		if (ctx->glversion >= 32)
 		{
 			info.has_base_vertex = true;
+			info.has_layered_rendering = true;
 		}
 
 		if (ctx->glversion >= 33)
 		{
 			ctx->has_explicit_attrib_location = true;
+			info.has_timestamp_query = true;
 		}
 		
+		if (ctx->glversion >= 41)
+		{
+			ctx->has_program_binary = true;
+			ctx->has_viewport_array = true;
+		}
+
 		if (ctx->glversion >= 42)
 		{
 			ctx->has_texstorage = true;
+			info.has_base_instance = true;
 		}
 
 		if (ctx->glversion >= 43)
 		{
+			ctx->has_invalidate_framebuffer = true;
 			info.has_compute_pipeline = true;
 			GLint data_x = 0;
 			GLint data_y = 0;
@@ -263,6 +1024,12 @@ R3_GL_MakeContext(Arena* arena, R3_ContextDesc const* desc)
 			info.max_dispatch_x = data_x;
 			info.max_dispatch_y = data_y;
 			info.max_dispatch_z = data_z;
+
+			GLint image_units = 0;
+			GLint compute_images = 0;
+			ctx->api.glGetIntegerv(GL_MAX_IMAGE_UNITS, &image_units);
+			ctx->api.glGetIntegerv(GL_MAX_COMPUTE_IMAGE_UNIFORMS, &compute_images);
+			info.max_unordered_views = Min(Min(image_units, compute_images), 16);
 		}
 	}
 	else
@@ -287,6 +1054,8 @@ R3_GL_MakeContext(Arena* arena, R3_ContextDesc const* desc)
 			ctx->has_texstorage = true;
 			ctx->has_uniformbuffer = true; // This is why our baseline is 3.0
 			ctx->has_explicit_attrib_location = true;
+			ctx->has_program_binary = true;
+			ctx->has_invalidate_framebuffer = true;
 		}
 		
 		if (ctx->glversion >= 31)
@@ -301,18 +1070,28 @@ R3_GL_MakeContext(Arena* arena, R3_ContextDesc const* desc)
 			info.max_dispatch_x = data_x;
 			info.max_dispatch_y = data_y;
 			info.max_dispatch_z = data_z;
+
+			GLint image_units = 0;
+			GLint compute_images = 0;
+			ctx->api.glGetIntegerv(GL_MAX_IMAGE_UNITS, &image_units);
+			ctx->api.glGetIntegerv(GL_MAX_COMPUTE_IMAGE_UNIFORMS, &compute_images);
+			info.max_unordered_views = Min(Min(image_units, compute_images), 16);
 		}
 		
 		if (ctx->glversion >= 32)
 		{
 			// NOTE(ljre): glDrawXXXBaseVertex came after compute shaders?????
 			info.has_base_vertex = true;
+			info.has_layered_rendering = true;
 		}
 	}
 
 	//------------------------------------------------------------------------
 	// Checking for extensions
 	int32 extension_count = 0;
+	bool has_amd_vertex_layer = false;
+	bool has_amd_vertex_viewport = false;
+	bool has_es3_compatibility = false;
 	ctx->api.glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
 	for (int32 i = 0; i < extension_count; ++i)
 	{
@@ -334,6 +1113,105 @@ R3_GL_MakeContext(Arena* arena, R3_ContextDesc const* desc)
 		}
 		else if (StringEquals(name, Str("GL_ARB_explicit_attrib_location")))
 			ctx->has_explicit_attrib_location = true;
+		else if (StringEquals(name, Str("GL_ARB_base_instance")))
+			info.has_base_instance = true;
+		else if (StringEquals(name, Str("GL_ARB_get_program_binary")))
+			ctx->has_program_binary = true;
+		else if (StringEquals(name, Str("GL_ARB_invalidate_subdata")))
+			ctx->has_invalidate_framebuffer = true;
+		else if (StringEquals(name, Str("GL_ARB_viewport_array")))
+			ctx->has_viewport_array = true;
+		else if (StringEquals(name, Str("GL_ARB_timer_query")) || StringEquals(name, Str("GL_EXT_disjoint_timer_query")))
+			info.has_timestamp_query = true;
+		else if (StringEquals(name, Str("GL_KHR_debug")))
+			info.has_debug_groups = true;
+		else if (StringEquals(name, Str("GL_ARB_pipeline_statistics_query")))
+			info.has_pipeline_statistics_query = true;
+		else if (StringEquals(name, Str("GL_ARB_ES3_compatibility")))
+			has_es3_compatibility = true;
+		else if (StringEquals(name, Str("GL_ARB_shader_viewport_layer_array")))
+			ctx->vertex_layer_extension = "#extension GL_ARB_shader_viewport_layer_array : enable\n";
+		else if (StringEquals(name, Str("GL_AMD_vertex_shader_layer")))
+			has_amd_vertex_layer = true;
+		else if (StringEquals(name, Str("GL_AMD_vertex_shader_viewport_index")))
+			has_amd_vertex_viewport = true;
+		else if (StringEquals(name, Str("GL_KHR_parallel_shader_compile")) && ctx->api.glMaxShaderCompilerThreadsKHR)
+		{
+			ctx->has_parallel_compile = true;
+			ctx->api.glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+		}
+		else if (StringEquals(name, Str("GL_ARB_parallel_shader_compile")) && ctx->api.glMaxShaderCompilerThreadsARB && !ctx->has_parallel_compile)
+		{
+			ctx->has_parallel_compile = true;
+			ctx->api.glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+		}
+	}
+
+	// NOTE(ljre): Some drivers expose the API without supporting a single binary format.
+	if (ctx->has_program_binary)
+	{
+		GLint format_count = 0;
+		ctx->api.glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+		ctx->has_program_binary = (format_count > 0);
+	}
+	if (ctx->has_program_binary && desc->program_cache.load && desc->program_cache.store)
+		ctx->program_cache = desc->program_cache;
+	if (!ctx->api.glInvalidateFramebuffer)
+		ctx->has_invalidate_framebuffer = false;
+	if (!ctx->api.glFramebufferTexture)
+		info.has_layered_rendering = false;
+	if (!ctx->api.glQueryCounter || !ctx->api.glGetQueryObjectui64v)
+		info.has_timestamp_query = false;
+	if (ctx->glversion >= (ctx->api.is_es ? 32 : 43))
+		info.has_debug_groups = true;
+	if (!ctx->api.glPushDebugGroup || !ctx->api.glPopDebugGroup)
+		info.has_debug_groups = false;
+
+	// NOTE(ljre): Occlusion queries are core since forever, but the boolean and conservative targets came later.
+	if (ctx->api.glBeginQuery && ctx->api.glEndQuery && ctx->api.glGetQueryObjectuiv)
+	{
+		info.has_occlusion_query = true;
+		if (ctx->api.is_es || ctx->glversion >= 43 || has_es3_compatibility)
+			ctx->occlusion_target = GL_ANY_SAMPLES_PASSED_CONSERVATIVE;
+		else if (ctx->glversion >= 33)
+			ctx->occlusion_target = GL_ANY_SAMPLES_PASSED;
+		else
+			ctx->occlusion_target = GL_SAMPLES_PASSED;
+	}
+	if (!ctx->api.is_es && ctx->glversion >= 46)
+		info.has_pipeline_statistics_query = true;
+	if (!info.has_occlusion_query || !ctx->api.glGetQueryObjectui64v)
+		info.has_pipeline_statistics_query = false;
+	if (!ctx->api.is_es && ctx->glversion >= 30 && ctx->api.glBeginConditionalRender && ctx->api.glEndConditionalRender)
+		info.has_conditional_render = info.has_occlusion_query;
+
+	info.max_viewports = 1;
+	if (ctx->has_viewport_array && ctx->api.glViewportArrayv && ctx->api.glDepthRangeArrayv)
+	{
+		GLint max_viewports = 0;
+		ctx->api.glGetIntegerv(GL_MAX_VIEWPORTS, &max_viewports);
+		info.max_viewports = Min(ClampMin(max_viewports, 1), 16);
+	}
+	else
+		ctx->has_viewport_array = false;
+
+	if (!ctx->vertex_layer_extension && has_amd_vertex_layer && has_amd_vertex_viewport)
+		ctx->vertex_layer_extension = "#extension GL_AMD_vertex_shader_layer : enable\n#extension GL_AMD_vertex_shader_viewport_index : enable\n";
+	if (!info.has_layered_rendering || !ctx->has_viewport_array)
+		ctx->vertex_layer_extension = NULL;
+	info.has_vertex_layer_output = (ctx->vertex_layer_extension != NULL);
+
+	// NOTE(ljre): GL_MAX_SAMPLES is only guaranteed for non-integer color and depth formats, and lower counts
+	//             may be rounded up by the driver to the next one it supports (glRenderbufferStorageMultisample
+	//             gives at least what was asked for). Integer formats can support fewer samples, which this
+	//             doesn't account for. ES 2.0 has no MSAA renderbuffers at all.
+	info.supported_sample_counts = 1;
+	if (ctx->glversion >= 30)
+	{
+		GLint max_samples = 0;
+		ctx->api.glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+		for (int32 count = 2; count <= max_samples; count *= 2)
+			info.supported_sample_counts |= (uint32)count;
 	}
 	
 	//------------------------------------------------------------------------
@@ -361,6 +1239,8 @@ API void
 R3_ResizeBuffers(R3_Context *ctx)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_ResizeBuffers });
 	ctx->api.resize_buffers(&ctx->api);
 }
 
@@ -368,7 +1248,17 @@ API void
 R3_Present(R3_Context *ctx)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_Present });
+	uint64 timeline_begin = R3_TimelineBegin(ctx->timeline);
 	ctx->api.present(&ctx->api);
+	R3_TimelineEnd(ctx->timeline, R3_TimelineKind_Present, Str("R3_Present"), timeline_begin, 0);
+
+	ctx->last_stats = ctx->stats;
+	ctx->stats = (R3_FrameStats) {
+		.frame = ctx->stats.frame + 1,
+		.live = ctx->stats.live,
+	};
 }
 
 API void
@@ -392,35 +1282,101 @@ R3_MakeTexture(R3_Context* ctx, R3_TextureDesc const* desc)
 		 (unsized_format == GL_DEPTH_COMPONENT || unsized_format == GL_DEPTH_STENCIL) &&
 		!(desc->binding_flags & R3_BindingFlag_ShaderResource) &&
 		 (desc->binding_flags & R3_BindingFlag_DepthStencil) &&
-		!desc->initial_data;
+		!desc->initial_data &&
+		 desc->depth <= 1 && !desc->flag_cubemap;
+	int32 sample_count = ClampMin(desc->sample_count, 1);
+	if (sample_count > 1)
+	{
+		SafeAssert(desc->depth <= 1 && !desc->flag_cubemap);
+		SafeAssert((sample_count & (sample_count - 1)) == 0);
+		SafeAssert(ctx->info.supported_sample_counts & (uint32)sample_count);
+		SafeAssert(!(desc->binding_flags & (R3_BindingFlag_ShaderResource | R3_BindingFlag_UnorderedAccess)));
+		SafeAssert(!desc->initial_data && desc->mipmap_count >= 0 && desc->mipmap_count <= 1);
+		can_be_renderbuffer = true;
+	}
 
 	if (can_be_renderbuffer)
 	{
 		ctx->api.glGenRenderbuffers(1, &out.gl_renderbuffer_id);
 		ctx->api.glBindRenderbuffer(GL_RENDERBUFFER, out.gl_renderbuffer_id);
-		ctx->api.glRenderbufferStorage(GL_RENDERBUFFER, format, desc->width, desc->height);
+		if (sample_count > 1)
+			ctx->api.glRenderbufferStorageMultisample(GL_RENDERBUFFER, sample_count, format, desc->width, desc->height);
+		else
+			ctx->api.glRenderbufferStorage(GL_RENDERBUFFER, format, desc->width, desc->height);
 		ctx->api.glBindRenderbuffer(GL_RENDERBUFFER, 0);
 	}
 	else
 	{
+		int32 levels = 1;
+		if (desc->mipmap_count)
+		{
+			SafeAssert(desc->mipmap_count >= 0 || desc->mipmap_count == -1);
+			if (desc->mipmap_count == -1)
+				levels = 1 + Bsr((uint32)Max(desc->width, desc->height));
+			else
+				levels = desc->mipmap_count;
+		}
+
+		GLenum target = GL_TEXTURE_2D;
+		if (desc->flag_cubemap)
+		{
+			SafeAssert(desc->depth == 6 && !desc->initial_data);
+			target = GL_TEXTURE_CUBE_MAP;
+		}
+		else if (desc->depth > 1)
+			target = GL_TEXTURE_2D_ARRAY;
+		out.gl_target = target;
+
 		ctx->api.glGenTextures(1, &out.gl_id);
-		ctx->api.glBindTexture(GL_TEXTURE_2D, out.gl_id);
-		if (ctx->has_texstorage)
+		ctx->api.glBindTexture(target, out.gl_id);
+		if (target == GL_TEXTURE_2D_ARRAY)
+		{
+			// NOTE(ljre): Both GL 3.0 and ES 3.0 have array textures, so glTexImage3D is always there.
+			if (ctx->has_texstorage)
+				ctx->api.glTexStorage3D(target, levels, format, desc->width, desc->height, desc->depth);
+			else
+			{
+				for (int32 i = 0; i < levels; ++i)
+					ctx->api.glTexImage3D(target, i, (int32)format, ClampMin(desc->width >> i, 1), ClampMin(desc->height >> i, 1), desc->depth, 0, unsized_format, datatype, NULL);
+			}
+			if (desc->initial_data)
+				ctx->api.glTexSubImage3D(target, 0, 0, 0, 0, desc->width, desc->height, desc->depth, unsized_format, datatype, desc->initial_data);
+		}
+		else if (ctx->has_texstorage)
 		{
-			ctx->api.glTexStorage2D(GL_TEXTURE_2D, 1, format, desc->width, desc->height);
+			ctx->api.glTexStorage2D(target, levels, format, desc->width, desc->height);
 			if (desc->initial_data)
-				ctx->api.glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, desc->width, desc->height, unsized_format, datatype, desc->initial_data);
+				ctx->api.glTexSubImage2D(target, 0, 0, 0, desc->width, desc->height, unsized_format, datatype, desc->initial_data);
 		}
 		else
-			ctx->api.glTexImage2D(GL_TEXTURE_2D, 0, (int32)format, desc->width, desc->height, 0, unsized_format, datatype, desc->initial_data);
-		ctx->api.glBindTexture(GL_TEXTURE_2D, 0);
+		{
+			int32 face_count = (target == GL_TEXTURE_CUBE_MAP) ? 6 : 1;
+			for (int32 face = 0; face < face_count; ++face)
+			{
+				GLenum face_target = (target == GL_TEXTURE_CUBE_MAP) ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+				ctx->api.glTexImage2D(face_target, 0, (int32)format, desc->width, desc->height, 0, unsized_format, datatype, desc->initial_data);
+				for (int32 i = 1; i < levels; ++i)
+					ctx->api.glTexImage2D(face_target, i, (int32)format, ClampMin(desc->width >> i, 1), ClampMin(desc->height >> i, 1), 0, unsized_format, datatype, NULL);
+			}
+		}
+		// NOTE(ljre): Without this the texture is incomplete if we didn't allocate the full mip chain
+		ctx->api.glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+		ctx->api.glBindTexture(target, 0);
 	}
 
 	out.format = desc->format;
 	out.width = desc->width;
 	out.height = desc->height;
 	out.depth = desc->depth;
+	out.sample_count = sample_count;
+	out.memory_size = R3_EstimateTextureSize(desc);
 
+	++ctx->stats.resources_created;
+	++ctx->stats.live.textures;
+	ctx->stats.live.texture_bytes += out.memory_size;
+
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_MakeTexture, .desc = desc, .object = &out });
     return out;
 }
 
@@ -430,7 +1386,7 @@ R3_MakeBuffer(R3_Context* ctx, R3_BufferDesc const* desc)
     Trace();
     R3_Buffer out = {};
 
-	GLenum kind;
+	GLenum kind = GL_ARRAY_BUFFER;
 	if (desc->binding_flags & R3_BindingFlag_VertexBuffer)
 		kind = GL_ARRAY_BUFFER;
 	if (desc->binding_flags & R3_BindingFlag_IndexBuffer)
@@ -439,6 +1395,10 @@ R3_MakeBuffer(R3_Context* ctx, R3_BufferDesc const* desc)
 		kind = GL_UNIFORM_BUFFER;
 	if (desc->binding_flags & R3_BindingFlag_StructuredBuffer)
 		kind = GL_SHADER_STORAGE_BUFFER;
+	// NOTE(ljre): The target only matters for creating the buffer. Indirect buffers are bound to
+	//             GL_DISPATCH_INDIRECT_BUFFER as well when they're used by R3_DispatchIndirect().
+	if (desc->binding_flags & R3_BindingFlag_Indirect)
+		kind = GL_DRAW_INDIRECT_BUFFER;
 	GLenum usage;
 	if (desc->usage == R3_Usage_Dynamic)
 		usage = GL_STREAM_DRAW;
@@ -449,7 +1409,14 @@ R3_MakeBuffer(R3_Context* ctx, R3_BufferDesc const* desc)
 	ctx->api.glBindBuffer(kind, out.gl_id);
 	ctx->api.glBufferData(kind, desc->size, desc->initial_data, usage);
 	ctx->api.glBindBuffer(kind, 0);
+	out.size = desc->size;
 
+	++ctx->stats.resources_created;
+	++ctx->stats.live.buffers;
+	ctx->stats.live.buffer_bytes += out.size;
+
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_MakeBuffer, .desc = desc, .object = &out });
     return out;
 }
 
@@ -463,22 +1430,22 @@ R3_MakeRenderTarget(R3_Context* ctx, R3_RenderTargetDesc const* desc)
 	ctx->api.glBindFramebuffer(GL_FRAMEBUFFER, out.gl_id);
 	for (intz i = 0; i < ArrayLength(desc->color_textures); ++i)
 	{
-		if (!desc->color_textures[i])
-			continue;
-		if (desc->color_textures[i]->gl_id)
-			ctx->api.glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0+i, GL_TEXTURE_2D, desc->color_textures[i]->gl_id, 0);
-		else if (desc->color_textures[i]->gl_renderbuffer_id)
-			ctx->api.glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0+i, GL_RENDERBUFFER, desc->color_textures[i]->gl_renderbuffer_id);
+		if (desc->color_textures[i])
+		{
+			OglAttachTexture_(ctx, GL_COLOR_ATTACHMENT0+i, desc->color_textures[i]);
+			out.gl_attachments[i] = desc->color_textures[i]->gl_id;
+		}
 	}
 	if (desc->depth_stencil_texture)
 	{
-		if (desc->depth_stencil_texture->gl_id)
-			ctx->api.glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, desc->depth_stencil_texture->gl_id, 0);
-		else if (desc->depth_stencil_texture->gl_renderbuffer_id)
-			ctx->api.glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, desc->depth_stencil_texture->gl_renderbuffer_id);
+		OglAttachTexture_(ctx, GL_DEPTH_STENCIL_ATTACHMENT, desc->depth_stencil_texture);
+		out.gl_attachments[8] = desc->depth_stencil_texture->gl_id;
 	}
 	ctx->api.glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	++ctx->stats.resources_created;
 
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_MakeRenderTarget, .desc = desc, .object = &out });
     return out;
 }
 
@@ -487,6 +1454,7 @@ R3_MakePipeline(R3_Context* ctx, R3_PipelineDesc const* desc)
 {
     Trace();
     R3_Pipeline out = {};
+	uint64 timeline_begin = R3_TimelineBegin(ctx->timeline);
 
 	String vs = desc->glsl.vs;
 	String fs = desc->glsl.fs;
@@ -498,9 +1466,8 @@ R3_MakePipeline(R3_Context* ctx, R3_PipelineDesc const* desc)
 		uint8 const* first = MemoryFindByte(vs.data, '\n', vs.size);
 		if (first)
 		{
-			uint8 const* old_data = vs.data;
+			vs.size -= first + 1 - vs.data;
 			vs.data = first + 1;
-			vs.size -= old_data - first - 1;
 		}
 	}
 	if (StringStartsWith(fs, Str("#version")))
@@ -508,22 +1475,30 @@ R3_MakePipeline(R3_Context* ctx, R3_PipelineDesc const* desc)
 		uint8 const* first = MemoryFindByte(fs.data, '\n', fs.size);
 		if (first)
 		{
-			uint8 const* old_data = fs.data;
+			fs.size -= first + 1 - fs.data;
 			fs.data = first + 1;
-			fs.size -= old_data - first - 1;
 		}
 	}
 
 	char const* vertex_shader_source = (char const*)vs.data;
 	char const* fragment_shader_source = (char const*)fs.data;
+	char const* defines = "";
+	if (desc->glsl.defines.size)
+	{
+		SafeAssert(desc->glsl.defines.data[desc->glsl.defines.size-1] == 0);
+		defines = (char const*)desc->glsl.defines.data;
+	}
 
 	char const* vertex_lines[] = {
 		"#version 140\n#extension GL_ARB_explicit_attrib_location : enable\n",
+		ctx->vertex_layer_extension ? ctx->vertex_layer_extension : "",
+		defines,
 		vertex_shader_source,
 	};
 	char const* fragment_lines[] = {
 		"#version 140\n#extension GL_ARB_explicit_attrib_location : enable\n",
 		"\n",
+		defines,
 		fragment_shader_source,
 	};
 
@@ -534,25 +1509,44 @@ R3_MakePipeline(R3_Context* ctx, R3_PipelineDesc const* desc)
 		fragment_lines[1] = "precision mediump float; precision highp int;\n";
 	}
 
-	int32 success;
-	uint32 vertex_shader = ctx->api.glCreateShader(GL_VERTEX_SHADER);
-	ctx->api.glShaderSource(vertex_shader, ArrayLength(vertex_lines), vertex_lines, NULL);
-	ctx->api.glCompileShader(vertex_shader);
-	ctx->api.glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &success);
-	SafeAssert(success);
-
-	uint32 fragment_shader = ctx->api.glCreateShader(GL_FRAGMENT_SHADER);
-	ctx->api.glShaderSource(fragment_shader, ArrayLength(fragment_lines), fragment_lines, NULL);
-	ctx->api.glCompileShader(fragment_shader);
-	ctx->api.glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &success);
-	SafeAssert(success);
+	uint64 cache_key = 0;
+	uint32 program = 0;
+	if (ctx->program_cache.load)
+	{
+		String parts[ArrayLength(vertex_lines) + ArrayLength(fragment_lines)];
+		for (intz i = 0; i < ArrayLength(vertex_lines); ++i)
+			parts[i] = StringFromCString(vertex_lines[i]);
+		for (intz i = 0; i < ArrayLength(fragment_lines); ++i)
+			parts[ArrayLength(vertex_lines) + i] = StringFromCString(fragment_lines[i]);
+		cache_key = OglProgramCacheKey_(ctx, ArrayLength(parts), parts);
+		program = OglLoadCachedProgram_(ctx, cache_key);
+	}
 
-	uint32 program = ctx->api.glCreateProgram();
-	ctx->api.glAttachShader(program, vertex_shader);
-	ctx->api.glAttachShader(program, fragment_shader);
-	ctx->api.glLinkProgram(program);
-	ctx->api.glGetProgramiv(program, GL_LINK_STATUS, &success);
-	SafeAssert(success);
+	if (!program && desc->flag_async)
+	{
+		// NOTE(ljre): Don't touch the status of anything here, that's what makes the driver wait.
+		out.gl_vs = OglAcquireShader_(ctx, GL_VERTEX_SHADER, ArrayLength(vertex_lines), vertex_lines);
+		out.gl_fs = OglAcquireShader_(ctx, GL_FRAGMENT_SHADER, ArrayLength(fragment_lines), fragment_lines);
+		program = OglStartLinkProgram_(ctx, 2, (uint32[]) { out.gl_vs, out.gl_fs });
+		out.gl_pending = true;
+		out.gl_cache_key = cache_key;
+	}
+	else if (!program)
+	{
+		// NOTE(ljre): Shaders that are shared with other pipelines were already checked, so this doesn't wait.
+		uint32 vertex_shader = OglAcquireShader_(ctx, GL_VERTEX_SHADER, ArrayLength(vertex_lines), vertex_lines);
+		SafeAssert(OglCheckShader_(ctx, vertex_shader, GL_VERTEX_SHADER));
+		uint32 fragment_shader = OglAcquireShader_(ctx, GL_FRAGMENT_SHADER, ArrayLength(fragment_lines), fragment_lines);
+		SafeAssert(OglCheckShader_(ctx, fragment_shader, GL_FRAGMENT_SHADER));
+
+		program = OglLinkProgram_(ctx, 2, (uint32[]) { vertex_shader, fragment_shader });
+		SafeAssert(program);
+		out.gl_vs = vertex_shader;
+		out.gl_fs = fragment_shader;
+
+		if (ctx->program_cache.store)
+			OglStoreCachedProgram_(ctx, cache_key, program);
+	}
 
 	static uint32 const functable[] = {
 		[R3_BlendFunc_Zero] = GL_ZERO,
@@ -596,7 +1590,7 @@ R3_MakePipeline(R3_Context* ctx, R3_PipelineDesc const* desc)
 	out.gl_cullface = (desc->cull_mode != R3_CullMode_None);
 	out.gl_polygon_mode = 0;
 	out.gl_depthtest = desc->flag_depth_test;
-	out.gl_scissor = false;
+	out.gl_scissor = desc->flag_scissor;
 	out.gl_blend = enable_blend;
 	out.gl_program = program;
 	out.gl_src = functable[src];
@@ -608,6 +1602,12 @@ R3_MakePipeline(R3_Context* ctx, R3_PipelineDesc const* desc)
 	out.gl_frontface = (desc->flag_cw_frontface) ? GL_CW : GL_CCW;
 	MemoryCopy(out.gl_layout, desc->input_layout, sizeof(R3_LayoutDesc[16]));
 
+	++ctx->stats.resources_created;
+	++ctx->stats.live.pipelines;
+	R3_TimelineEnd(ctx->timeline, R3_TimelineKind_Cpu, Str("R3_MakePipeline"), timeline_begin, 0);
+
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_MakePipeline, .desc = desc, .object = &out });
     return out;
 }
 
@@ -616,7 +1616,72 @@ R3_MakeComputePipeline(R3_Context* ctx, R3_ComputePipelineDesc const* desc)
 {
     Trace();
     R3_ComputePipeline out = {};
+	SafeAssert(ctx->info.has_compute_pipeline);
+	uint64 timeline_begin = R3_TimelineBegin(ctx->timeline);
+
+	String cs = desc->glsl;
+	if (StringStartsWith(cs, Str("#version")))
+	{
+		uint8 const* first = MemoryFindByte(cs.data, '\n', cs.size);
+		if (first)
+		{
+			cs.size -= first + 1 - cs.data;
+			cs.data = first + 1;
+		}
+	}
+
+	char const* compute_lines[] = {
+		"#version 430\n",
+		(char const*)cs.data,
+	};
+	int32 compute_lengths[] = {
+		-1,
+		(int32)cs.size,
+	};
+
+	if (ctx->api.is_es)
+		compute_lines[0] = "#version 310 es\n";
+
+	uint64 cache_key = 0;
+	uint32 program = 0;
+	if (ctx->program_cache.load)
+	{
+		String parts[] = {
+			StringFromCString(compute_lines[0]),
+			cs,
+		};
+		cache_key = OglProgramCacheKey_(ctx, ArrayLength(parts), parts);
+		program = OglLoadCachedProgram_(ctx, cache_key);
+	}
+
+	if (!program)
+	{
+		uint32 compute_shader = OglCompileShader_(ctx, GL_COMPUTE_SHADER, ArrayLength(compute_lines), compute_lines, compute_lengths);
+		if (!compute_shader)
+			return out;
+		program = OglLinkProgram_(ctx, 1, &compute_shader);
+		ctx->api.glDeleteShader(compute_shader);
+		if (!program)
+			return out;
+
+		if (ctx->program_cache.store)
+			OglStoreCachedProgram_(ctx, cache_key, program);
+	}
 
+	int32 group_size[3] = {};
+	ctx->api.glGetProgramiv(program, GL_COMPUTE_WORK_GROUP_SIZE, group_size);
+
+	out.group_size_x = group_size[0];
+	out.group_size_y = group_size[1];
+	out.group_size_z = group_size[2];
+	out.gl_program = program;
+
+	++ctx->stats.resources_created;
+	++ctx->stats.live.pipelines;
+	R3_TimelineEnd(ctx->timeline, R3_TimelineKind_Cpu, Str("R3_MakeComputePipeline"), timeline_begin, 0);
+
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_MakeComputePipeline, .desc = desc, .object = &out });
     return out;
 }
 
@@ -648,6 +1713,11 @@ R3_MakeSampler(R3_Context* ctx, R3_SamplerDesc const* desc)
 		} break;
 	}
 
+	++ctx->stats.resources_created;
+	++ctx->stats.live.samplers;
+
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_MakeSampler, .desc = desc, .object = &out });
     return out;
 }
 
@@ -655,6 +1725,15 @@ API void
 R3_FreeTexture(R3_Context* ctx, R3_Texture* texture)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_FreeTexture, .object = texture });
+	OglForgetFramebuffers_(ctx, texture);
+	if (texture->gl_id || texture->gl_renderbuffer_id)
+	{
+		++ctx->stats.resources_destroyed;
+		--ctx->stats.live.textures;
+		ctx->stats.live.texture_bytes -= texture->memory_size;
+	}
 	if (texture->gl_id)
 		ctx->api.glDeleteTextures(1, &texture->gl_id);
 	if (texture->gl_renderbuffer_id)
@@ -667,8 +1746,15 @@ API void
 R3_FreeBuffer(R3_Context* ctx, R3_Buffer* buffer)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_FreeBuffer, .object = buffer });
 	if (buffer->gl_id)
+	{
 		ctx->api.glDeleteBuffers(1, &buffer->gl_id);
+		++ctx->stats.resources_destroyed;
+		--ctx->stats.live.buffers;
+		ctx->stats.live.buffer_bytes -= buffer->size;
+	}
 
 	*buffer = (R3_Buffer) {};
 }
@@ -677,8 +1763,13 @@ API void
 R3_FreeRenderTarget(R3_Context* ctx, R3_RenderTarget* rendertarget)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_FreeRenderTarget, .object = rendertarget });
 	if (rendertarget->gl_id)
+	{
 		ctx->api.glDeleteFramebuffers(1, &rendertarget->gl_id);
+		++ctx->stats.resources_destroyed;
+	}
 
 	*rendertarget = (R3_RenderTarget) {};
 }
@@ -687,8 +1778,18 @@ API void
 R3_FreePipeline(R3_Context* ctx, R3_Pipeline* pipeline)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_FreePipeline, .object = pipeline });
+	if (pipeline->gl_vs)
+		OglReleaseShader_(ctx, pipeline->gl_vs);
+	if (pipeline->gl_fs)
+		OglReleaseShader_(ctx, pipeline->gl_fs);
 	if (pipeline->gl_program)
+	{
 		ctx->api.glDeleteProgram(pipeline->gl_program);
+		++ctx->stats.resources_destroyed;
+		--ctx->stats.live.pipelines;
+	}
 
 	*pipeline = (R3_Pipeline) {};
 }
@@ -697,8 +1798,14 @@ API void
 R3_FreeComputePipeline(R3_Context* ctx, R3_ComputePipeline* pipeline)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_FreeComputePipeline, .object = pipeline });
 	if (pipeline->gl_program)
+	{
 		ctx->api.glDeleteProgram(pipeline->gl_program);
+		++ctx->stats.resources_destroyed;
+		--ctx->stats.live.pipelines;
+	}
 
 	*pipeline = (R3_ComputePipeline) {};
 }
@@ -707,8 +1814,14 @@ API void
 R3_FreeSampler(R3_Context* ctx, R3_Sampler* sampler)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_FreeSampler, .object = sampler });
 	if (sampler->gl_sampler)
+	{
 		ctx->api.glDeleteSamplers(1, &sampler->gl_sampler);
+		++ctx->stats.resources_destroyed;
+		--ctx->stats.live.samplers;
+	}
 
 	*sampler = (R3_Sampler) {};
 }
@@ -717,48 +1830,139 @@ API void
 R3_UpdateBuffer(R3_Context* ctx, R3_Buffer* buffer, void const* memory, uint32 size)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_UpdateBuffer, .object = buffer, .memory = memory, .size = size });
+	uint64 timeline_begin = R3_TimelineBegin(ctx->timeline);
+	OglEmitBarrier_(ctx, OglRequireAccess_(ctx, OglBufferKey_(buffer), OglAccess_BufferUpdate));
 
 	ctx->api.glBindBuffer(GL_ARRAY_BUFFER, buffer->gl_id);
 	ctx->api.glBufferData(GL_ARRAY_BUFFER, size, memory, GL_STREAM_DRAW);
 	ctx->api.glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// NOTE(ljre): glBufferData() reallocates the storage with the new size.
+	++ctx->stats.buffer_updates;
+	ctx->stats.buffer_update_bytes += size;
+	ctx->stats.live.buffer_bytes += (uint64)size - buffer->size;
+	buffer->size = size;
+	R3_TimelineEnd(ctx->timeline, R3_TimelineKind_Upload, Str("R3_UpdateBuffer"), timeline_begin, size);
 }
 
 API void
 R3_UpdateTexture(R3_Context* ctx, R3_Texture* texture, void const* memory, uint32 size, uint32 slice)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_UpdateTexture, .object = texture, .memory = memory, .size = size, .args = { slice } });
+	uint64 timeline_begin = R3_TimelineBegin(ctx->timeline);
 	GLenum unsized_format;
 	GLenum type;
 	OglFormatToGLEnum_(texture->format, &unsized_format, &type);
+	OglEmitBarrier_(ctx, OglRequireAccess_(ctx, OglTextureKey_(texture), OglAccess_TextureUpdate));
+
+	ctx->api.glBindTexture(texture->gl_target, texture->gl_id);
+	if (texture->gl_target == GL_TEXTURE_2D_ARRAY)
+		ctx->api.glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (int32)slice, texture->width, texture->height, 1, unsized_format, type, memory);
+	else if (texture->gl_target == GL_TEXTURE_CUBE_MAP)
+		ctx->api.glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + slice, 0, 0, 0, texture->width, texture->height, unsized_format, type, memory);
+	else
+		ctx->api.glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture->width, texture->height, unsized_format, type, memory);
+	ctx->api.glBindTexture(texture->gl_target, 0);
 
-	ctx->api.glBindTexture(GL_TEXTURE_2D, texture->gl_id);
-	ctx->api.glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture->width, texture->height, unsized_format, type, memory);
-	ctx->api.glBindTexture(GL_TEXTURE_2D, 0);
+	++ctx->stats.texture_updates;
+	ctx->stats.texture_update_bytes += size;
+	R3_TimelineEnd(ctx->timeline, R3_TimelineKind_Upload, Str("R3_UpdateTexture"), timeline_begin, size);
 }
 
 API void
 R3_CopyBuffer(R3_Context* ctx, R3_Buffer* src, uint32 src_offset, R3_Buffer* dst, uint32 dst_offset, uint32 size)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_CopyBuffer, .object = src, .other = dst, .args = { src_offset, dst_offset, size } });
+	OglEmitBarrier_(ctx,
+		OglRequireAccess_(ctx, OglBufferKey_(src), OglAccess_BufferUpdate) |
+		OglRequireAccess_(ctx, OglBufferKey_(dst), OglAccess_BufferUpdate));
 	ctx->api.glBindBuffer(GL_COPY_READ_BUFFER, src->gl_id);
 	ctx->api.glBindBuffer(GL_COPY_WRITE_BUFFER, dst->gl_id);
 	ctx->api.glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, src_offset, dst_offset, size);
 	ctx->api.glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
 	ctx->api.glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	ctx->stats.copy_bytes += size;
+}
+
+API void
+R3_ResolveTexture(R3_Context* ctx, R3_Texture* src, R3_Texture* dst)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_ResolveTexture, .object = src, .other = dst });
+	SafeAssert(!ctx->in_render_pass);
+	SafeAssert(src->sample_count > 1 && dst->sample_count <= 1);
+	SafeAssert(src->format == dst->format && src->width == dst->width && src->height == dst->height);
+	SafeAssert(src->format != R3_Format_D16 && src->format != R3_Format_D24S8);
+	OglFlushFramebufferHazards_(ctx, (uint32[]) { src->gl_id, dst->gl_id }, 2);
+
+	// NOTE(ljre): D3D11 resolves without touching the bound render target, so put ours back when we're done.
+	GLint prev_draw_fbo = 0;
+	GLint prev_read_fbo = 0;
+	ctx->api.glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prev_draw_fbo);
+	ctx->api.glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &prev_read_fbo);
+
+	uint32 src_fbo = OglFindFramebuffer_(ctx, &(R3_RenderPassDesc) { .color_textures[0] = src });
+	uint32 dst_fbo = OglFindFramebuffer_(ctx, &(R3_RenderPassDesc) { .color_textures[0] = dst });
+	ctx->api.glBindFramebuffer(GL_READ_FRAMEBUFFER, src_fbo);
+	ctx->api.glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst_fbo);
+	if (ctx->scissor_test)
+		ctx->api.glDisable(GL_SCISSOR_TEST);
+	ctx->api.glBlitFramebuffer(0, 0, src->width, src->height, 0, 0, dst->width, dst->height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	if (ctx->scissor_test)
+		ctx->api.glEnable(GL_SCISSOR_TEST);
+	ctx->api.glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (uint32)prev_draw_fbo);
+	ctx->api.glBindFramebuffer(GL_READ_FRAMEBUFFER, (uint32)prev_read_fbo);
 }
 
 API void
 R3_CopyTexture2D(R3_Context* ctx, R3_Texture* src, uint32 src_x, uint32 src_y, R3_Texture* dst, uint32 dst_x, uint32 dst_y, uint32 width, uint32 height)
 {
 	Trace();
-	ctx->api.glCopyImageSubData(src->gl_id, GL_TEXTURE_2D, 0, (int32)src_x, (int32)src_y, 0, dst->gl_id, GL_TEXTURE_2D, 0, (int32)dst_x, (int32)dst_y, 0, (int32)width, (int32)height, 1);
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_CopyTexture2D, .object = src, .other = dst, .args = { src_x, src_y, dst_x, dst_y, width, height } });
+	OglEmitBarrier_(ctx,
+		OglRequireAccess_(ctx, OglTextureKey_(src), OglAccess_TextureUpdate) |
+		OglRequireAccess_(ctx, OglTextureKey_(dst), OglAccess_TextureUpdate));
+	ctx->api.glCopyImageSubData(src->gl_id, src->gl_target, 0, (int32)src_x, (int32)src_y, 0, dst->gl_id, dst->gl_target, 0, (int32)dst_x, (int32)dst_y, 0, (int32)width, (int32)height, 1);
+	ctx->stats.copy_bytes += R3_EstimateTextureSize(&(R3_TextureDesc) {
+		.width = (int32)width,
+		.height = (int32)height,
+		.format = src->format,
+	});
 }
 
 API void
 R3_SetViewports(R3_Context* ctx, intz count, R3_Viewport viewports[])
 {
 	Trace();
-	if (count > 0)
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetViewports, .array = viewports, .count = count });
+	++ctx->stats.fixed_function_changes;
+	SafeAssert(count <= ctx->info.max_viewports);
+	if (count > 1 && ctx->has_viewport_array)
+	{
+		float32 rects[16][4];
+		float64 ranges[16][2];
+		for (intz i = 0; i < count; ++i)
+		{
+			rects[i][0] = viewports[i].x;
+			rects[i][1] = viewports[i].y;
+			rects[i][2] = viewports[i].width;
+			rects[i][3] = viewports[i].height;
+			ranges[i][0] = viewports[i].min_depth;
+			ranges[i][1] = viewports[i].max_depth;
+		}
+		ctx->api.glViewportArrayv(0, (int32)count, rects[0]);
+		ctx->api.glDepthRangeArrayv(0, (int32)count, ranges[0]);
+	}
+	else if (count > 0)
 	{
 		int32 x = (int32)viewports[0].x;
 		int32 y = (int32)viewports[0].y;
@@ -771,9 +1975,61 @@ R3_SetViewports(R3_Context* ctx, intz count, R3_Viewport viewports[])
 	}
 }
 
+API void
+R3_SetScissorRects(R3_Context* ctx, intz count, R3_ScissorRect rects[])
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetScissorRects, .array = rects, .count = count });
+	++ctx->stats.fixed_function_changes;
+	SafeAssert(count <= ctx->info.max_viewports);
+	if (count > 1 && ctx->has_viewport_array)
+	{
+		int32 boxes[16][4];
+		for (intz i = 0; i < count; ++i)
+		{
+			boxes[i][0] = rects[i].x;
+			boxes[i][1] = rects[i].y;
+			boxes[i][2] = rects[i].width;
+			boxes[i][3] = rects[i].height;
+		}
+		ctx->api.glScissorArrayv(0, (int32)count, boxes[0]);
+	}
+	else if (count > 0)
+		ctx->api.glScissor(rects[0].x, rects[0].y, rects[0].width, rects[0].height);
+}
+
+API bool
+R3_IsPipelineReady(R3_Context* ctx, R3_Pipeline* pipeline)
+{
+	Trace();
+	if (!pipeline->gl_pending)
+		return true;
+
+	// NOTE(ljre): Without the extension there's no way to ask without blocking, so just wait for it.
+	if (ctx->has_parallel_compile)
+	{
+		int32 done = 0;
+		ctx->api.glGetProgramiv(pipeline->gl_program, 0x91B1 /*GL_COMPLETION_STATUS_KHR*/, &done);
+		if (!done)
+			return false;
+	}
+
+	OglFinishPendingPipeline_(ctx, pipeline);
+	return true;
+}
+
 API void
 R3_SetPipeline(R3_Context* ctx, R3_Pipeline* pipeline)
 {
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetPipeline, .object = pipeline });
+	++ctx->stats.pipeline_changes;
+	// NOTE(ljre): Keep the previous program bound so the state stays consistent, but skip the draws.
+	ctx->skip_draws = (!R3_IsPipelineReady(ctx, pipeline) || !pipeline->gl_program);
+	if (ctx->skip_draws)
+		return;
+
 	ctx->api.glUseProgram(pipeline->gl_program);
 	ctx->curr_program = pipeline->gl_program;
 	for (intz i = 0; i < ArrayLength(ctx->ubo_indices); ++i)
@@ -819,6 +2075,7 @@ R3_SetPipeline(R3_Context* ctx, R3_Pipeline* pipeline)
 				case R3_Format_F16x4: elem_count = 4; datatype = GL_HALF_FLOAT; is_float = true; break;
 				case R3_Format_I16x2: elem_count = 2; datatype = GL_SHORT; break;
 				case R3_Format_I16x4: elem_count = 4; datatype = GL_SHORT; break;
+				case R3_Format_U32x1: elem_count = 1; datatype = GL_UNSIGNED_INT; break;
 
 				default: SafeAssert(false);
 			}
@@ -856,15 +2113,29 @@ R3_SetPipeline(R3_Context* ctx, R3_Pipeline* pipeline)
 		ctx->api.glDisable(GL_DEPTH_TEST);
 	else
 		ctx->api.glEnable(GL_DEPTH_TEST);
+	if (pipeline->gl_scissor != ctx->scissor_test)
+	{
+		if (pipeline->gl_scissor)
+			ctx->api.glEnable(GL_SCISSOR_TEST);
+		else
+			ctx->api.glDisable(GL_SCISSOR_TEST);
+		ctx->scissor_test = pipeline->gl_scissor;
+	}
 }
 
 API void
 R3_SetRenderTarget(R3_Context* ctx, R3_RenderTarget* rendertarget)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetRenderTarget, .object = rendertarget });
+	++ctx->stats.render_target_changes;
 	uint32 fbo = 0;
 	if (rendertarget)
+	{
 		fbo = rendertarget->gl_id;
+		OglFlushFramebufferHazards_(ctx, rendertarget->gl_attachments, ArrayLength(rendertarget->gl_attachments));
+	}
 	ctx->api.glBindFramebuffer(GL_FRAMEBUFFER, fbo);
 }
 
@@ -872,6 +2143,11 @@ API void
 R3_SetVertexInputs(R3_Context* ctx, R3_VertexInputs const* desc)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetVertexInputs, .desc = desc });
+	++ctx->stats.vertex_input_changes;
+	ctx->bound_ibuffer = OglBufferKey_(desc->ibuffer);
+	MemoryZero(ctx->bound_vbuffers, sizeof(ctx->bound_vbuffers));
 	if (desc->ibuffer)
 	{
 		ctx->api.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, desc->ibuffer->gl_id);
@@ -894,6 +2170,7 @@ R3_SetVertexInputs(R3_Context* ctx, R3_VertexInputs const* desc)
 		uint32 buffer_id = (desc->vbuffers[buffer_slot].buffer) ? desc->vbuffers[buffer_slot].buffer->gl_id : 0;
 		intz stride = desc->vbuffers[buffer_slot].stride;
 		uint32 base_offset = desc->vbuffers[buffer_slot].offset;
+		ctx->bound_vbuffers[buffer_slot] = buffer_id;
 		ctx->api.glBindBuffer(GL_ARRAY_BUFFER, buffer_id);
 		ctx->api.glEnableVertexAttribArray(i);
 		ctx->api.glVertexAttribDivisor(i, attrib->divisor);
@@ -904,16 +2181,19 @@ R3_SetVertexInputs(R3_Context* ctx, R3_VertexInputs const* desc)
 	}
 }
 
-API void
-R3_SetUniformBuffers(R3_Context* ctx, intz count, R3_UniformBuffer buffers[])
+// NOTE(ljre): Shared by the graphics and compute entry points, which do the capture and stats themselves.
+static void
+OglSetUniformBuffers_(R3_Context* ctx, intz count, R3_UniformBuffer buffers[])
 {
-	Trace();
 	SafeAssert(count <= ArrayLength(ctx->ubo_indices));
+	if (ctx->skip_draws)
+		return;
 	for (intz i = 0; i < count; ++i)
 	{
 		int32 block_id = ctx->ubo_indices[i];
 		SafeAssert(block_id != -1);
 		SafeAssert(block_id >= 0);
+		ctx->bound_ubos[i] = OglBufferKey_(buffers[i].buffer);
 		if (!buffers[i].offset && !buffers[i].size)
 			ctx->api.glBindBufferBase(GL_UNIFORM_BUFFER, i, buffers[i].buffer->gl_id);
 		else
@@ -922,27 +2202,52 @@ R3_SetUniformBuffers(R3_Context* ctx, intz count, R3_UniformBuffer buffers[])
 	}
 }
 
-API void
-R3_SetResourceViews(R3_Context* ctx, intz count, R3_ResourceView views[])
+static void
+OglSetResourceViews_(R3_Context* ctx, intz count, R3_ResourceView views[])
 {
-	Trace();
+	SafeAssert(count <= ArrayLength(ctx->bound_views));
+	MemoryZero(ctx->bound_views, sizeof(ctx->bound_views));
 	for (intz i = 0; i < count; ++i)
 	{
+		ctx->bound_views[i] = OglViewKey_(views[i].buffer, views[i].texture);
 		if (views[i].buffer)
 			ctx->api.glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, views[i].buffer->gl_id);
-		else
+		else if (views[i].texture)
 		{
 			ctx->api.glActiveTexture(GL_TEXTURE0 + i);
-			ctx->api.glBindTexture(GL_TEXTURE_2D, views[i].texture->gl_id);
+			ctx->api.glBindTexture(views[i].texture->gl_target, views[i].texture->gl_id);
 		}
 	}
 	ctx->api.glActiveTexture(GL_TEXTURE0);
 }
 
+API void
+R3_SetUniformBuffers(R3_Context* ctx, intz count, R3_UniformBuffer buffers[])
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetUniformBuffers, .array = buffers, .count = count });
+	++ctx->stats.uniform_buffer_changes;
+	OglSetUniformBuffers_(ctx, count, buffers);
+}
+
+API void
+R3_SetResourceViews(R3_Context* ctx, intz count, R3_ResourceView views[])
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetResourceViews, .array = views, .count = count });
+	++ctx->stats.resource_view_changes;
+	OglSetResourceViews_(ctx, count, views);
+}
+
 API void
 R3_SetSamplers(R3_Context* ctx, intz count, R3_Sampler* samplers[])
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetSamplers, .array = samplers, .count = count });
+	++ctx->stats.sampler_changes;
 	for (intz i = 0; i < count; ++i)
 		ctx->api.glBindSampler(i, samplers[i] ? samplers[i]->gl_sampler : 0);
 }
@@ -951,6 +2256,9 @@ API void
 R3_SetPrimitiveType(R3_Context* ctx, R3_PrimitiveType type)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetPrimitiveType, .args = { type } });
+	++ctx->stats.fixed_function_changes;
 	switch (type)
 	{
 		case R3_PrimitiveType_TriangleList: ctx->curr_prim = GL_TRIANGLES; break;
@@ -967,6 +2275,8 @@ API void
 R3_Clear(R3_Context* ctx, R3_ClearDesc const* desc)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_Clear, .desc = desc });
 	GLenum flags = 0;
 	if (desc->flag_color)
 	{
@@ -985,17 +2295,140 @@ R3_Clear(R3_Context* ctx, R3_ClearDesc const* desc)
 		flags |= GL_STENCIL_BUFFER_BIT;
 	}
 
+	// NOTE(ljre): Clears are affected by the scissor test on GL, but not on D3D11.
 	if (flags)
+	{
+		++ctx->stats.clears;
+		if (ctx->scissor_test)
+			ctx->api.glDisable(GL_SCISSOR_TEST);
 		ctx->api.glClear(flags);
+		if (ctx->scissor_test)
+			ctx->api.glEnable(GL_SCISSOR_TEST);
+	}
 }
 
 API void
-R3_Draw(R3_Context* ctx, uint32 start_vertex, uint32 vertex_count, uint32 start_instance, uint32 instance_count)
+R3_BeginRenderPass(R3_Context* ctx, R3_RenderPassDesc const* desc)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_BeginRenderPass, .desc = desc });
+	SafeAssert(!ctx->in_render_pass);
+	ctx->in_render_pass = true;
+	ctx->pass_discard_count = 0;
+	++ctx->stats.render_target_changes;
+
+	uint32 attachments[9] = {};
+	for (intz i = 0; i < 8; ++i)
+		attachments[i] = desc->color_textures[i] ? desc->color_textures[i]->gl_id : 0;
+	attachments[8] = desc->depth_stencil_texture ? desc->depth_stencil_texture->gl_id : 0;
+	OglFlushFramebufferHazards_(ctx, attachments, ArrayLength(attachments));
+
+	uint32 fbo = OglFindFramebuffer_(ctx, desc);
+	GLenum dont_cares[10];
+	int32 dont_care_count = 0;
+	if (ctx->scissor_test)
+		ctx->api.glDisable(GL_SCISSOR_TEST);
+
+	// NOTE(ljre): The default framebuffer has its own attachment names, and is assumed to have depth-stencil.
+	for (intz i = 0; i < 8; ++i)
+	{
+		if (fbo ? !desc->color_textures[i] : i > 0)
+			continue;
+		GLenum attachment = fbo ? GL_COLOR_ATTACHMENT0+i : GL_COLOR;
+
+		if (desc->colors[i].load == R3_LoadAction_Clear)
+		{
+			ctx->api.glClearBufferfv(GL_COLOR, (int32)i, desc->colors[i].clear_color);
+			++ctx->stats.clears;
+		}
+		else if (desc->colors[i].load == R3_LoadAction_DontCare)
+			dont_cares[dont_care_count++] = attachment;
+		if (desc->colors[i].store == R3_StoreAction_Discard)
+			ctx->pass_discards[ctx->pass_discard_count++] = attachment;
+	}
+
+	if (!fbo || desc->depth_stencil_texture)
+	{
+		bool has_stencil = !fbo || desc->depth_stencil_texture->format == R3_Format_D24S8;
+		R3_LoadAction load = desc->depth_stencil.load;
+		R3_StoreAction store = desc->depth_stencil.store;
+		GLenum attachments[2] = { GL_DEPTH, GL_STENCIL };
+		int32 attachment_count = has_stencil ? 2 : 1;
+		if (fbo)
+		{
+			attachments[0] = OglDepthAttachment_(desc->depth_stencil_texture->format);
+			attachment_count = 1;
+		}
+
+		if (load == R3_LoadAction_Clear)
+		{
+			SafeAssert(desc->depth_stencil.clear_stencil <= INT32_MAX);
+			if (has_stencil)
+				ctx->api.glClearBufferfi(GL_DEPTH_STENCIL, 0, desc->depth_stencil.clear_depth, (int32)desc->depth_stencil.clear_stencil);
+			else
+				ctx->api.glClearBufferfv(GL_DEPTH, 0, &desc->depth_stencil.clear_depth);
+			++ctx->stats.clears;
+		}
+		for (int32 i = 0; i < attachment_count; ++i)
+		{
+			if (load == R3_LoadAction_DontCare)
+				dont_cares[dont_care_count++] = attachments[i];
+			if (store == R3_StoreAction_Discard)
+				ctx->pass_discards[ctx->pass_discard_count++] = attachments[i];
+		}
+	}
+
+	if (dont_care_count && ctx->has_invalidate_framebuffer)
+		ctx->api.glInvalidateFramebuffer(GL_FRAMEBUFFER, dont_care_count, dont_cares);
+	if (ctx->scissor_test)
+		ctx->api.glEnable(GL_SCISSOR_TEST);
+}
+
+API void
+R3_EndRenderPass(R3_Context* ctx)
 {
 	Trace();
-	SafeAssert(start_instance == 0);
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_EndRenderPass });
+	SafeAssert(ctx->in_render_pass);
+	ctx->in_render_pass = false;
+
+	if (ctx->pass_discard_count && ctx->has_invalidate_framebuffer)
+		ctx->api.glInvalidateFramebuffer(GL_FRAMEBUFFER, ctx->pass_discard_count, ctx->pass_discards);
+	ctx->pass_discard_count = 0;
+}
+
+static void
+OglCountDraw_(R3_Context* ctx, GLenum prim, uint32 count, uint32 instance_count)
+{
+	uint64 instances = ClampMin(instance_count, 1);
+	uint64 triangles = 0;
+	if (prim == GL_TRIANGLES)
+		triangles = count / 3;
+	else if ((prim == GL_TRIANGLE_STRIP || prim == GL_TRIANGLE_FAN) && count >= 3)
+		triangles = count - 2;
+
+	++ctx->stats.draws;
+	ctx->stats.instances += instances;
+	ctx->stats.triangles += triangles * instances;
+}
 
-	if (instance_count)
+API void
+R3_Draw(R3_Context* ctx, uint32 start_vertex, uint32 vertex_count, uint32 start_instance, uint32 instance_count)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_Draw, .args = { start_vertex, vertex_count, start_instance, instance_count } });
+	SafeAssert(start_instance == 0 || ctx->info.has_base_instance);
+	if (ctx->skip_draws)
+		return;
+	OglFlushDrawHazards_(ctx, false, NULL);
+	OglCountDraw_(ctx, GL_TRIANGLES, vertex_count, instance_count);
+
+	if (start_instance)
+		ctx->api.glDrawArraysInstancedBaseInstance(GL_TRIANGLES, (int32)start_vertex, (intz)vertex_count, (intz)ClampMin(instance_count, 1), start_instance);
+	else if (instance_count)
 		ctx->api.glDrawArraysInstanced(GL_TRIANGLES, (int32)start_vertex, (intz)vertex_count, (intz)instance_count);
 	else
 		ctx->api.glDrawArrays(GL_TRIANGLES, (int32)start_vertex, (intz)vertex_count);
@@ -1005,12 +2438,20 @@ API void
 R3_DrawIndexed(R3_Context* ctx, uint32 start_index, uint32 index_count, uint32 start_instance, uint32 instance_count, int32 base_vertex)
 {
 	Trace();
-	SafeAssert(start_instance == 0);
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_DrawIndexed, .args = { start_index, index_count, start_instance, instance_count, (uint32)base_vertex } });
+	SafeAssert(start_instance == 0 || ctx->info.has_base_instance);
+	if (ctx->skip_draws)
+		return;
+	OglFlushDrawHazards_(ctx, true, NULL);
 	GLenum type = ctx->curr_index_type;
 	GLenum prim = ctx->curr_prim;
+	OglCountDraw_(ctx, prim, index_count, instance_count);
 	uintptr offset = start_index * (type == GL_UNSIGNED_INT ? 4 : 2);
 
-	if (instance_count)
+	if (start_instance)
+		ctx->api.glDrawElementsInstancedBaseVertexBaseInstance(prim, (intz)index_count, type, (void*)offset, (intz)ClampMin(instance_count, 1), base_vertex, start_instance);
+	else if (instance_count)
 	{
 		if (base_vertex)
 			ctx->api.glDrawElementsInstancedBaseVertex(prim, (intz)index_count, type, (void*)offset, (intz)instance_count, base_vertex);
@@ -1026,11 +2467,47 @@ R3_DrawIndexed(R3_Context* ctx, uint32 start_index, uint32 index_count, uint32 s
 	}
 }
 
+API void
+R3_DrawIndirect(R3_Context* ctx, R3_Buffer* buffer, uint32 offset)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_DrawIndirect, .object = buffer, .args = { offset } });
+	if (ctx->skip_draws)
+		return;
+	OglFlushDrawHazards_(ctx, false, buffer);
+	++ctx->stats.draws;
+	++ctx->stats.indirect_draws;
+	ctx->api.glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer->gl_id);
+	ctx->api.glDrawArraysIndirect(ctx->curr_prim, (void*)(uintptr)offset);
+	ctx->api.glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+API void
+R3_DrawIndexedIndirect(R3_Context* ctx, R3_Buffer* buffer, uint32 offset)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_DrawIndexedIndirect, .object = buffer, .args = { offset } });
+	if (ctx->skip_draws)
+		return;
+	OglFlushDrawHazards_(ctx, true, buffer);
+	++ctx->stats.draws;
+	++ctx->stats.indirect_draws;
+	ctx->api.glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer->gl_id);
+	ctx->api.glDrawElementsIndirect(ctx->curr_prim, ctx->curr_index_type, (void*)(uintptr)offset);
+	ctx->api.glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
 // =============================================================================
 API void
 R3_SetComputePipeline(R3_Context* ctx, R3_ComputePipeline* pipeline)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetComputePipeline, .object = pipeline });
+	++ctx->stats.pipeline_changes;
+	ctx->skip_draws = false;
 	ctx->api.glUseProgram(pipeline->gl_program);
 	ctx->curr_program = pipeline->gl_program;
 	for (intz i = 0; i < ArrayLength(ctx->ubo_indices); ++i)
@@ -1061,28 +2538,49 @@ API void
 R3_SetComputeUniformBuffers(R3_Context* ctx, intz count, R3_UniformBuffer buffers[])
 {
 	Trace();
-	R3_SetUniformBuffers(ctx, count, buffers);
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetComputeUniformBuffers, .array = buffers, .count = count });
+	++ctx->stats.uniform_buffer_changes;
+	OglSetUniformBuffers_(ctx, count, buffers);
 }
 
 API void
 R3_SetComputeResourceViews(R3_Context* ctx, intz count, R3_ResourceView views[])
 {
 	Trace();
-	R3_SetResourceViews(ctx, count, views);
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetComputeResourceViews, .array = views, .count = count });
+	++ctx->stats.resource_view_changes;
+	OglSetResourceViews_(ctx, count, views);
 }
 
 API void
 R3_SetComputeUnorderedViews(R3_Context* ctx, intz count, R3_UnorderedView views[])
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_SetComputeUnorderedViews, .array = views, .count = count });
+	++ctx->stats.resource_view_changes;
 	intz max_view_count = 16;
-	SafeAssert(count < max_view_count);
+	SafeAssert(count <= max_view_count);
+	MemoryZero(ctx->bound_uavs, sizeof(ctx->bound_uavs));
 	for (intz i = 0; i < count; ++i)
 	{
+		ctx->bound_uavs[i] = OglViewKey_(views[i].buffer, views[i].texture);
+		// NOTE(ljre): SSBO bindings are shared with the resource views, so buffers go after them. Images have
+		//             their own units, and there are usually only 8 of them.
 		if (views[i].buffer)
 			ctx->api.glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i+max_view_count, views[i].buffer->gl_id);
-		else
-			ctx->api.glBindImageTexture(i+max_view_count, views[i].texture->gl_id, 0, GL_FALSE, 0, GL_READ_WRITE, OglFormatToGLEnum_(views[i].texture->format, NULL, NULL));
+		else if (views[i].texture)
+		{
+			R3_Texture* texture = views[i].texture;
+			GLboolean layered = (texture->depth > 1) ? GL_TRUE : GL_FALSE;
+			// NOTE(ljre): sRGB formats can't be used for image load/store, but they're compatible with RGBA8.
+			GLenum format = OglFormatToGLEnum_(texture->format, NULL, NULL);
+			if (format == GL_SRGB8_ALPHA8)
+				format = GL_RGBA8;
+			ctx->api.glBindImageTexture(i, texture->gl_id, views[i].mip, layered, 0, GL_READ_WRITE, format);
+		}
 	}
 }
 
@@ -1090,6 +2588,253 @@ API void
 R3_Dispatch(R3_Context* ctx, uint32 x, uint32 y, uint32 z)
 {
 	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_Dispatch, .args = { x, y, z } });
+	OglFlushDispatchHazards_(ctx, NULL);
+	++ctx->stats.dispatches;
 	ctx->api.glDispatchCompute(x, y, z);
-	ctx->api.glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	OglMarkDispatchWrites_(ctx);
+}
+
+API void
+R3_DispatchIndirect(R3_Context* ctx, R3_Buffer* buffer, uint32 offset)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_DispatchIndirect, .object = buffer, .args = { offset } });
+	SafeAssert(offset % 4 == 0);
+	OglFlushDispatchHazards_(ctx, buffer);
+	++ctx->stats.dispatches;
+	ctx->api.glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, buffer->gl_id);
+	ctx->api.glDispatchComputeIndirect((GLintptr)offset);
+	ctx->api.glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+	OglMarkDispatchWrites_(ctx);
+}
+
+//------------------------------------------------------------------------
+// NOTE(ljre): Same order as R3_Query.gl_statistics_queries. From ARB_pipeline_statistics_query, core in 4.6.
+static GLenum const g_ogl_statistics_targets[] = {
+	0x82EE, // GL_VERTICES_SUBMITTED
+	0x82EF, // GL_PRIMITIVES_SUBMITTED
+	0x82F0, // GL_VERTEX_SHADER_INVOCATIONS
+	0x82F6, // GL_CLIPPING_INPUT_PRIMITIVES
+	0x82F7, // GL_CLIPPING_OUTPUT_PRIMITIVES
+	0x82F4, // GL_FRAGMENT_SHADER_INVOCATIONS
+	0x82F5, // GL_COMPUTE_SHADER_INVOCATIONS
+};
+
+API R3_Query
+R3_MakeQuery(R3_Context* ctx, R3_QueryKind kind)
+{
+	Trace();
+	R3_Query out = { .kind = kind };
+	switch (kind)
+	{
+		case R3_QueryKind_Timestamp:
+		{
+			SafeAssert(ctx->info.has_timestamp_query);
+			ctx->api.glGenQueries(1, &out.gl_query);
+		} break;
+		case R3_QueryKind_Occlusion:
+		{
+			SafeAssert(ctx->info.has_occlusion_query);
+			ctx->api.glGenQueries(1, &out.gl_query);
+		} break;
+		case R3_QueryKind_PipelineStatistics:
+		{
+			SafeAssert(ctx->info.has_pipeline_statistics_query);
+			ctx->api.glGenQueries(ArrayLength(out.gl_statistics_queries), out.gl_statistics_queries);
+		} break;
+		default: SafeAssert(false);
+	}
+
+	++ctx->stats.resources_created;
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_MakeQuery, .object = &out, .args = { kind } });
+	return out;
+}
+
+API void
+R3_FreeQuery(R3_Context* ctx, R3_Query* query)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_FreeQuery, .object = query });
+	if (query->gl_query || query->gl_statistics_queries[0])
+		++ctx->stats.resources_destroyed;
+	if (query->gl_query)
+		ctx->api.glDeleteQueries(1, &query->gl_query);
+	if (query->gl_statistics_queries[0])
+		ctx->api.glDeleteQueries(ArrayLength(query->gl_statistics_queries), query->gl_statistics_queries);
+
+	*query = (R3_Query) {};
+}
+
+API void
+R3_WriteTimestamp(R3_Context* ctx, R3_Query* query)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_WriteTimestamp, .object = query });
+	SafeAssert(query->kind == R3_QueryKind_Timestamp);
+	ctx->api.glQueryCounter(query->gl_query, GL_TIMESTAMP);
+}
+
+API void
+R3_BeginQuery(R3_Context* ctx, R3_Query* query)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_BeginQuery, .object = query });
+	if (query->kind == R3_QueryKind_Occlusion)
+		ctx->api.glBeginQuery(ctx->occlusion_target, query->gl_query);
+	else if (query->kind == R3_QueryKind_PipelineStatistics)
+	{
+		for (intz i = 0; i < ArrayLength(g_ogl_statistics_targets); ++i)
+			ctx->api.glBeginQuery(g_ogl_statistics_targets[i], query->gl_statistics_queries[i]);
+	}
+	else
+		SafeAssert(false);
+}
+
+API void
+R3_EndQuery(R3_Context* ctx, R3_Query* query)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_EndQuery, .object = query });
+	if (query->kind == R3_QueryKind_Occlusion)
+		ctx->api.glEndQuery(ctx->occlusion_target);
+	else if (query->kind == R3_QueryKind_PipelineStatistics)
+	{
+		for (intz i = 0; i < ArrayLength(g_ogl_statistics_targets); ++i)
+			ctx->api.glEndQuery(g_ogl_statistics_targets[i]);
+	}
+	else
+		SafeAssert(false);
+}
+
+API bool
+R3_GetQueryResult(R3_Context* ctx, R3_Query* query, R3_QueryResult* out_result)
+{
+	Trace();
+	R3_QueryResult result = {};
+	GLint available = 0;
+
+	if (query->kind == R3_QueryKind_PipelineStatistics)
+	{
+		uint64 values[ArrayLength(g_ogl_statistics_targets)];
+		for (intz i = 0; i < ArrayLength(values); ++i)
+		{
+			ctx->api.glGetQueryObjectiv(query->gl_statistics_queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				return false;
+		}
+		for (intz i = 0; i < ArrayLength(values); ++i)
+		{
+			GLuint64 value = 0;
+			ctx->api.glGetQueryObjectui64v(query->gl_statistics_queries[i], GL_QUERY_RESULT, &value);
+			values[i] = value;
+		}
+
+		result.statistics = (R3_PipelineStatistics) {
+			.input_vertices = values[0],
+			.input_primitives = values[1],
+			.vertex_invocations = values[2],
+			.clipping_input_primitives = values[3],
+			.clipping_output_primitives = values[4],
+			.fragment_invocations = values[5],
+			.compute_invocations = values[6],
+		};
+		*out_result = result;
+		return true;
+	}
+
+	ctx->api.glGetQueryObjectiv(query->gl_query, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return false;
+
+	if (query->kind == R3_QueryKind_Timestamp)
+	{
+		GLuint64 value = 0;
+		ctx->api.glGetQueryObjectui64v(query->gl_query, GL_QUERY_RESULT, &value);
+		result.timestamp_ns = value;
+		if (ctx->api.is_es)
+		{
+			GLint disjoint = 0;
+			ctx->api.glGetIntegerv(0x8FBB /*GL_GPU_DISJOINT_EXT*/, &disjoint);
+			result.disjoint = (disjoint != 0);
+		}
+	}
+	else if (query->kind == R3_QueryKind_Occlusion)
+	{
+		// NOTE(ljre): A sample count with GL_SAMPLES_PASSED, a boolean otherwise.
+		GLuint value = 0;
+		ctx->api.glGetQueryObjectuiv(query->gl_query, GL_QUERY_RESULT, &value);
+		result.any_samples_passed = (value != 0);
+	}
+
+	*out_result = result;
+	return true;
+}
+
+API void
+R3_BeginConditionalRender(R3_Context* ctx, R3_Query* query)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_BeginConditionalRender, .object = query });
+	SafeAssert(ctx->info.has_conditional_render && query->kind == R3_QueryKind_Occlusion);
+	ctx->api.glBeginConditionalRender(query->gl_query, GL_QUERY_NO_WAIT);
+}
+
+API void
+R3_EndConditionalRender(R3_Context* ctx)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_EndConditionalRender });
+	ctx->api.glEndConditionalRender();
+}
+
+API void
+R3_PushDebugGroup(R3_Context* ctx, String name)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_PushDebugGroup, .name = name });
+	if (ctx->info.has_debug_groups)
+		ctx->api.glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, (GLsizei)name.size, (GLchar const*)name.data);
+}
+
+API void
+R3_PopDebugGroup(R3_Context* ctx)
+{
+	Trace();
+	if (ctx->capture)
+		R3_RecordCapture(ctx->capture, &(R3_CaptureCall) { .op = R3_CaptureOp_PopDebugGroup });
+	if (ctx->info.has_debug_groups)
+		ctx->api.glPopDebugGroup();
+}
+
+//------------------------------------------------------------------------
+API R3_FrameStats
+R3_GetFrameStats(R3_Context* ctx)
+{
+	Trace();
+	return ctx->last_stats;
+}
+
+API void
+R3_SetTimeline(R3_Context* ctx, R3_Timeline* timeline)
+{
+	Trace();
+	ctx->timeline = timeline;
+}
+
+API void
+R3_SetCapture(R3_Context* ctx, R3_Capture* capture)
+{
+	Trace();
+	ctx->capture = capture;
 }
@@ -0,0 +1,302 @@
+#include <base/base.h>
+#include <base/base_intrinsics.h>
+#include <base/base_assert.h>
+#include <base/base_string.h>
+#include <base/base_arena.h>
+#include <layer_os/api.h>
+#include "api.h"
+
+// NOTE(ljre): std140 layout of type_UniformBuffer0 in both shaders.
+struct GpuCullUniforms_
+{
+	float32 view_proj[4][4];
+	float32 prev_view_proj[4][4];
+	float32 planes[6][4];
+	float32 pyramid_size[2];
+	int32 pyramid_mip_count;
+	uint32 instance_count;
+	uint32 draw_count;
+	uint32 flags;
+	uint32 padding_[2];
+}
+typedef GpuCullUniforms_;
+
+enum
+{
+	GpuCullFlag_ZeroToOneDepth_ = 1,
+};
+
+#define GPUCULL_GROUP_SIZE_ 64
+#define GPUCULL_GLSL_COMMON_ \
+	"layout(local_size_x = 64) in;\n" \
+	"layout(std140) uniform type_UniformBuffer0\n" \
+	"{\n" \
+	"	mat4 uViewProj;\n" \
+	"	mat4 uPrevViewProj;\n" \
+	"	vec4 uPlanes[6];\n" \
+	"	vec2 uPyramidSize;\n" \
+	"	int uPyramidMipCount;\n" \
+	"	uint uInstanceCount;\n" \
+	"	uint uDrawCount;\n" \
+	"	uint uFlags;\n" \
+	"};\n" \
+	"layout(std430, binding = 16) buffer DrawArgs { uint bDrawArgs[]; };\n"
+
+static char const g_gpucull_reset_glsl[] =
+	GPUCULL_GLSL_COMMON_
+	"void main()\n"
+	"{\n"
+	"	uint draw = gl_GlobalInvocationID.x;\n"
+	"	if (draw < uDrawCount)\n"
+	"		bDrawArgs[draw*5u + 1u] = 0u;\n"
+	"}\n";
+
+static char const g_gpucull_cull_glsl[] =
+	GPUCULL_GLSL_COMMON_
+	"struct Instance { vec4 sphere; uvec4 data; };\n"
+	"layout(std430, binding = 0) readonly buffer Instances { Instance bInstances[]; };\n"
+	"layout(std430, binding = 17) writeonly buffer Visible { uint bVisible[]; };\n"
+	"uniform highp sampler2D uTexture1;\n"
+	"\n"
+	"bool IsOccluded(vec3 center, float radius)\n"
+	"{\n"
+	"	vec3 ndc_min = vec3(1e30);\n"
+	"	vec3 ndc_max = vec3(-1e30);\n"
+	"	for (int i = 0; i < 8; ++i)\n"
+	"	{\n"
+	"		vec3 corner = center + radius * vec3((i&1) != 0 ? 1.0 : -1.0, (i&2) != 0 ? 1.0 : -1.0, (i&4) != 0 ? 1.0 : -1.0);\n"
+	"		vec4 clip = uPrevViewProj * vec4(corner, 1.0);\n"
+	"		if (clip.w <= 0.0)\n"
+	"			return false;\n" // crosses the near plane, don't bother
+	"		vec3 ndc = clip.xyz / clip.w;\n"
+	"		ndc_min = min(ndc_min, ndc);\n"
+	"		ndc_max = max(ndc_max, ndc);\n"
+	"	}\n"
+	"\n"
+	"	float nearest = ndc_min.z;\n"
+	"	vec2 uv_min = ndc_min.xy * 0.5 + 0.5;\n"
+	"	vec2 uv_max = ndc_max.xy * 0.5 + 0.5;\n"
+	"	if ((uFlags & 1u) != 0u)\n"
+	"	{\n"
+	"		float top = 1.0 - uv_max.y;\n"
+	"		uv_max.y = 1.0 - uv_min.y;\n"
+	"		uv_min.y = top;\n"
+	"	}\n"
+	"	else\n"
+	"		nearest = nearest * 0.5 + 0.5;\n"
+	"	uv_min = clamp(uv_min, 0.0, 1.0);\n"
+	"	uv_max = clamp(uv_max, 0.0, 1.0);\n"
+	"\n"
+	// Pick the mip where the rect covers at most 2x2 texels
+	"	vec2 extent = (uv_max - uv_min) * uPyramidSize;\n"
+	"	int lod = int(ceil(log2(max(max(extent.x, extent.y), 1.0))));\n"
+	"	lod = clamp(lod, 0, uPyramidMipCount - 1);\n"
+	"	ivec2 mip_size = max(ivec2(uPyramidSize) >> lod, ivec2(1));\n"
+	"	ivec2 p0 = clamp(ivec2(uv_min * vec2(mip_size)), ivec2(0), mip_size - 1);\n"
+	"	ivec2 p1 = clamp(ivec2(uv_max * vec2(mip_size)), ivec2(0), mip_size - 1);\n"
+	"	float farthest = max(\n"
+	"		max(texelFetch(uTexture1, p0, lod).x, texelFetch(uTexture1, ivec2(p1.x, p0.y), lod).x),\n"
+	"		max(texelFetch(uTexture1, ivec2(p0.x, p1.y), lod).x, texelFetch(uTexture1, p1, lod).x));\n"
+	"	return nearest > farthest;\n"
+	"}\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"	uint id = gl_GlobalInvocationID.x;\n"
+	"	if (id >= uInstanceCount)\n"
+	"		return;\n"
+	"\n"
+	"	Instance inst = bInstances[id];\n"
+	"	for (int i = 0; i < 6; ++i)\n"
+	"	{\n"
+	"		if (dot(uPlanes[i].xyz, inst.sphere.xyz) + uPlanes[i].w < -inst.sphere.w)\n"
+	"			return;\n"
+	"	}\n"
+	"	if (uPyramidMipCount > 0 && IsOccluded(inst.sphere.xyz, inst.sphere.w))\n"
+	"		return;\n"
+	"\n"
+	"	uint draw = inst.data.x;\n"
+	"	if (draw >= uDrawCount)\n"
+	"		return;\n"
+	"\n"
+	// The per-draw limits are stored right after the arguments. Every thread that overflows clamps the count
+	// back after its own increment, so once all are done it's at most the limit.
+	"	uint limit = bDrawArgs[uDrawCount*5u + draw];\n"
+	"	uint slot = atomicAdd(bDrawArgs[draw*5u + 1u], 1u);\n"
+	"	if (slot >= limit)\n"
+	"	{\n"
+	"		atomicMin(bDrawArgs[draw*5u + 1u], limit);\n"
+	"		return;\n"
+	"	}\n"
+	"	bVisible[bDrawArgs[draw*5u + 4u] + slot] = id;\n"
+	"}\n";
+
+// NOTE(ljre): Gribb & Hartmann. Rows of a column-major matrix are strided by 4.
+static void
+GpuCullExtractPlanes_(float32 const m[4][4], bool zero_to_one_depth, float32 out_planes[6][4])
+{
+	for (intz i = 0; i < 4; ++i)
+	{
+		out_planes[0][i] = m[i][3] + m[i][0];
+		out_planes[1][i] = m[i][3] - m[i][0];
+		out_planes[2][i] = m[i][3] + m[i][1];
+		out_planes[3][i] = m[i][3] - m[i][1];
+		out_planes[4][i] = zero_to_one_depth ? m[i][2] : m[i][3] + m[i][2];
+		out_planes[5][i] = m[i][3] - m[i][2];
+	}
+
+	for (intz i = 0; i < 6; ++i)
+	{
+		float32* p = out_planes[i];
+		float32 len = __builtin_sqrtf(p[0]*p[0] + p[1]*p[1] + p[2]*p[2]);
+		if (len > 0.0f)
+		{
+			float32 inv_len = 1.0f / len;
+			p[0] *= inv_len;
+			p[1] *= inv_len;
+			p[2] *= inv_len;
+			p[3] *= inv_len;
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+API R3_GpuCuller
+R3_MakeGpuCuller(R3_Context* ctx, R3_GpuCullerDesc const* desc)
+{
+	Trace();
+	R3_GpuCuller out = {};
+	SafeAssert(desc->draw_count > 0 && desc->max_instance_count > 0);
+
+	out.reset_pipeline = R3_MakeComputePipeline(ctx, &(R3_ComputePipelineDesc) {
+		.glsl = StrInit(g_gpucull_reset_glsl),
+		.dx50 = desc->dx50_reset_cs,
+	});
+	out.cull_pipeline = R3_MakeComputePipeline(ctx, &(R3_ComputePipelineDesc) {
+		.glsl = StrInit(g_gpucull_cull_glsl),
+		.dx50 = desc->dx50_cull_cs,
+	});
+
+	out.uniforms = R3_MakeBuffer(ctx, &(R3_BufferDesc) {
+		.size = sizeof(GpuCullUniforms_),
+		.binding_flags = R3_BindingFlag_UniformBuffer,
+		.usage = R3_Usage_Dynamic,
+	});
+
+	// NOTE(ljre): The arguments of every draw, followed by their 'max_instance_count', which the cull shader
+	//             clamps to. Indirect draws only read the arguments at their offsets, so the tail is never seen.
+	ArenaSavepoint scratch = ArenaSave(OS_ScratchArena(NULL, 0));
+	uint32 args_size = sizeof(R3_DrawIndexedIndirectArgs) * desc->draw_count;
+	uint32 buffer_size = args_size + sizeof(uint32) * desc->draw_count;
+	R3_DrawIndexedIndirectArgs* args = ArenaPushAligned(scratch.arena, buffer_size, _Alignof(R3_DrawIndexedIndirectArgs));
+	uint32* limits = (uint32*)((uint8*)args + args_size);
+	for (intz i = 0; i < desc->draw_count; ++i)
+	{
+		R3_GpuCullDraw const* draw = &desc->draws[i];
+		SafeAssert(draw->first_instance + draw->max_instance_count <= desc->max_instance_count);
+
+		args[i] = (R3_DrawIndexedIndirectArgs) {
+			.index_count = draw->index_count,
+			.instance_count = 0,
+			.start_index = draw->start_index,
+			.base_vertex = draw->base_vertex,
+			.start_instance = draw->first_instance,
+		};
+		limits[i] = draw->max_instance_count;
+	}
+
+	out.draw_args = R3_MakeBuffer(ctx, &(R3_BufferDesc) {
+		.size = buffer_size,
+		.binding_flags = R3_BindingFlag_Indirect | R3_BindingFlag_UnorderedAccess,
+		.usage = R3_Usage_GpuReadWrite,
+		.initial_data = args,
+	});
+	ArenaRestore(scratch);
+
+	out.visible_instances = R3_MakeBuffer(ctx, &(R3_BufferDesc) {
+		.size = sizeof(uint32) * desc->max_instance_count,
+		.binding_flags = R3_BindingFlag_VertexBuffer | R3_BindingFlag_UnorderedAccess,
+		.usage = R3_Usage_GpuReadWrite,
+	});
+
+	out.draw_count = desc->draw_count;
+	out.max_instance_count = desc->max_instance_count;
+
+	return out;
+}
+
+API void
+R3_FreeGpuCuller(R3_Context* ctx, R3_GpuCuller* culler)
+{
+	Trace();
+
+	R3_FreeComputePipeline(ctx, &culler->reset_pipeline);
+	R3_FreeComputePipeline(ctx, &culler->cull_pipeline);
+	R3_FreeBuffer(ctx, &culler->uniforms);
+	R3_FreeBuffer(ctx, &culler->draw_args);
+	R3_FreeBuffer(ctx, &culler->visible_instances);
+
+	*culler = (R3_GpuCuller) {};
+}
+
+API void
+R3_GpuCull(R3_Context* ctx, R3_GpuCuller* culler, R3_GpuCullParams const* params)
+{
+	Trace();
+	SafeAssert(params->instance_count <= culler->max_instance_count);
+	bool has_pyramid = (params->depth_pyramid && params->depth_pyramid_mip_count > 0);
+
+	GpuCullUniforms_ uniforms = {
+		.instance_count = params->instance_count,
+		.draw_count = culler->draw_count,
+		.flags = (params->flag_zero_to_one_depth) ? GpuCullFlag_ZeroToOneDepth_ : 0,
+	};
+	MemoryCopy(uniforms.view_proj, params->view_proj, sizeof(uniforms.view_proj));
+	MemoryCopy(uniforms.prev_view_proj, params->prev_view_proj, sizeof(uniforms.prev_view_proj));
+	GpuCullExtractPlanes_(params->view_proj, params->flag_zero_to_one_depth, uniforms.planes);
+	if (has_pyramid)
+	{
+		uniforms.pyramid_size[0] = (float32)params->depth_pyramid->width;
+		uniforms.pyramid_size[1] = (float32)params->depth_pyramid->height;
+		uniforms.pyramid_mip_count = params->depth_pyramid_mip_count;
+	}
+	R3_UpdateBuffer(ctx, &culler->uniforms, &uniforms, sizeof(uniforms));
+
+	R3_UniformBuffer ubuffers[] = {
+		{ .buffer = &culler->uniforms },
+	};
+	R3_UnorderedView uavs[] = {
+		{ .buffer = &culler->draw_args },
+		{ .buffer = &culler->visible_instances },
+	};
+	R3_ResourceView srvs[] = {
+		{ .buffer = params->instances },
+		{ .texture = params->depth_pyramid },
+	};
+
+	// Reset the instance counts
+	R3_SetComputePipeline(ctx, &culler->reset_pipeline);
+	R3_SetComputeUniformBuffers(ctx, ArrayLength(ubuffers), ubuffers);
+	R3_SetComputeUnorderedViews(ctx, ArrayLength(uavs), uavs);
+	R3_Dispatch(ctx, (culler->draw_count + GPUCULL_GROUP_SIZE_-1) / GPUCULL_GROUP_SIZE_, 1, 1);
+
+	// Test & compact
+	if (params->instance_count)
+	{
+		R3_SetComputePipeline(ctx, &culler->cull_pipeline);
+		R3_SetComputeUniformBuffers(ctx, ArrayLength(ubuffers), ubuffers);
+		R3_SetComputeResourceViews(ctx, has_pyramid ? 2 : 1, srvs);
+		R3_Dispatch(ctx, (params->instance_count + GPUCULL_GROUP_SIZE_-1) / GPUCULL_GROUP_SIZE_, 1, 1);
+	}
+
+	// NOTE(ljre): Both buffers are going to be used by the draws, so get them out of the UAV slots
+	R3_SetComputeUnorderedViews(ctx, 0, NULL);
+}
+
+API void
+R3_GpuCullerDraw(R3_Context* ctx, R3_GpuCuller* culler)
+{
+	Trace();
+	for (uint32 i = 0; i < culler->draw_count; ++i)
+		R3_DrawIndexedIndirect(ctx, &culler->draw_args, i * sizeof(R3_DrawIndexedIndirectArgs));
+}
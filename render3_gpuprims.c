@@ -0,0 +1,562 @@
+#include <base/base.h>
+#include <base/base_intrinsics.h>
+#include <base/base_assert.h>
+#include <base/base_string.h>
+#include <base/base_arena.h>
+#include <layer_os/api.h>
+#include "api.h"
+
+// NOTE(ljre): std140 layout of type_UniformBuffer0 in all shaders.
+struct GpuPrimsUniforms_
+{
+	uint32 count;
+	uint32 partition_count;
+	uint32 shift;
+	uint32 flags;
+	uint32 key_mask; // radix sort only, clears the bits above 'key_bits' before digits are taken
+	uint32 padding_[3];
+}
+typedef GpuPrimsUniforms_;
+
+enum
+{
+	GpuPrimsFlag_Inclusive_ = 1,
+	GpuPrimsFlag_CountNonZero_ = 2,
+	GpuPrimsFlag_HasValues_ = 4,
+};
+
+#define GPUPRIMS_GROUP_SIZE_ 256
+#define GPUPRIMS_PARTITION_SIZE_ 1024 // 4 elements per invocation
+#define GPUPRIMS_RADIX_BITS_ 4
+#define GPUPRIMS_RADIX_SIZE_ (1 << GPUPRIMS_RADIX_BITS_)
+#define GPUPRIMS_MAX_PARTITIONS_ 65535 // max dispatch size guaranteed by both GL and D3D11
+
+// NOTE(ljre): BlockExclusiveScan() has to be called by every invocation of the workgroup. Every element of
+//             a partition belongs to the same invocation in groups of 4, so scanning 1024 elements is a
+//             sequential scan of 4 plus a scan of 256 in shared memory.
+#define GPUPRIMS_GLSL_COMMON_ \
+	"layout(local_size_x = 256) in;\n" \
+	"layout(std140) uniform type_UniformBuffer0\n" \
+	"{\n" \
+	"	uint uCount;\n" \
+	"	uint uPartitionCount;\n" \
+	"	uint uShift;\n" \
+	"	uint uFlags;\n" \
+	"	uint uKeyMask;\n" \
+	"};\n" \
+	"shared uint sScan[256];\n" \
+	"\n" \
+	"uint BlockExclusiveScan(uint value, out uint total)\n" \
+	"{\n" \
+	"	uint tid = gl_LocalInvocationIndex;\n" \
+	"	sScan[tid] = value;\n" \
+	"	memoryBarrierShared();\n" \
+	"	barrier();\n" \
+	"	for (uint offset = 1u; offset < 256u; offset <<= 1u)\n" \
+	"	{\n" \
+	"		uint add = (tid >= offset) ? sScan[tid - offset] : 0u;\n" \
+	"		memoryBarrierShared();\n" \
+	"		barrier();\n" \
+	"		sScan[tid] += add;\n" \
+	"		memoryBarrierShared();\n" \
+	"		barrier();\n" \
+	"	}\n" \
+	"	total = sScan[255];\n" \
+	"	uint result = sScan[tid] - value;\n" \
+	"	barrier();\n" \
+	"	return result;\n" \
+	"}\n" \
+	"\n"
+
+static char const g_gpuprims_scan_reduce_glsl[] =
+	GPUPRIMS_GLSL_COMMON_
+	"layout(std430, binding = 0) readonly buffer Input { uint bInput[]; };\n"
+	"layout(std430, binding = 16) writeonly buffer Partials { uint bPartials[]; };\n"
+	"void main()\n"
+	"{\n"
+	"	uint base = gl_WorkGroupID.x * 1024u + gl_LocalInvocationIndex * 4u;\n"
+	"	uint sum = 0u;\n"
+	"	for (uint i = 0u; i < 4u; ++i)\n"
+	"	{\n"
+	"		uint v = (base + i < uCount) ? bInput[base + i] : 0u;\n"
+	"		sum += ((uFlags & 2u) != 0u) ? uint(v != 0u) : v;\n"
+	"	}\n"
+	"	uint total;\n"
+	"	BlockExclusiveScan(sum, total);\n"
+	"	if (gl_LocalInvocationIndex == 0u)\n"
+	"		bPartials[gl_WorkGroupID.x] = total;\n"
+	"}\n";
+
+// NOTE(ljre): Dispatched as a single workgroup that walks the partition sums 1024 at a time. Also writes the
+//             grand total right after them.
+static char const g_gpuprims_scan_partials_glsl[] =
+	GPUPRIMS_GLSL_COMMON_
+	"layout(std430, binding = 16) buffer Partials { uint bPartials[]; };\n"
+	"void main()\n"
+	"{\n"
+	"	uint carry = 0u;\n"
+	"	for (uint chunk = 0u; chunk < uPartitionCount; chunk += 1024u)\n"
+	"	{\n"
+	"		uint base = chunk + gl_LocalInvocationIndex * 4u;\n"
+	"		uint v[4];\n"
+	"		uint sum = 0u;\n"
+	"		for (uint i = 0u; i < 4u; ++i)\n"
+	"		{\n"
+	"			v[i] = (base + i < uPartitionCount) ? bPartials[base + i] : 0u;\n"
+	"			sum += v[i];\n"
+	"		}\n"
+	"		uint total;\n"
+	"		uint prefix = carry + BlockExclusiveScan(sum, total);\n"
+	"		for (uint i = 0u; i < 4u; ++i)\n"
+	"		{\n"
+	"			if (base + i < uPartitionCount)\n"
+	"				bPartials[base + i] = prefix;\n"
+	"			prefix += v[i];\n"
+	"		}\n"
+	"		carry += total;\n"
+	"	}\n"
+	"	if (gl_LocalInvocationIndex == 0u)\n"
+	"		bPartials[uPartitionCount] = carry;\n"
+	"}\n";
+
+static char const g_gpuprims_scan_downsweep_glsl[] =
+	GPUPRIMS_GLSL_COMMON_
+	"layout(std430, binding = 0) readonly buffer Input { uint bInput[]; };\n"
+	"layout(std430, binding = 16) readonly buffer Partials { uint bPartials[]; };\n"
+	"layout(std430, binding = 17) writeonly buffer Output { uint bOutput[]; };\n"
+	"void main()\n"
+	"{\n"
+	"	uint base = gl_WorkGroupID.x * 1024u + gl_LocalInvocationIndex * 4u;\n"
+	"	uint v[4];\n"
+	"	uint sum = 0u;\n"
+	"	for (uint i = 0u; i < 4u; ++i)\n"
+	"	{\n"
+	"		v[i] = (base + i < uCount) ? bInput[base + i] : 0u;\n"
+	"		sum += v[i];\n"
+	"	}\n"
+	"	uint total;\n"
+	"	uint prefix = bPartials[gl_WorkGroupID.x] + BlockExclusiveScan(sum, total);\n"
+	"	for (uint i = 0u; i < 4u; ++i)\n"
+	"	{\n"
+	"		uint next = prefix + v[i];\n"
+	"		if (base + i < uCount)\n"
+	"			bOutput[base + i] = ((uFlags & 1u) != 0u) ? next : prefix;\n"
+	"		prefix = next;\n"
+	"	}\n"
+	"}\n";
+
+static char const g_gpuprims_compact_glsl[] =
+	GPUPRIMS_GLSL_COMMON_
+	"layout(std430, binding = 0) readonly buffer Input { uint bInput[]; };\n"
+	"layout(std430, binding = 1) readonly buffer Flags { uint bFlags[]; };\n"
+	"layout(std430, binding = 16) readonly buffer Partials { uint bPartials[]; };\n"
+	"layout(std430, binding = 17) writeonly buffer Output { uint bOutput[]; };\n"
+	"layout(std430, binding = 18) writeonly buffer Count { uint bCount[]; };\n"
+	"void main()\n"
+	"{\n"
+	"	uint base = gl_WorkGroupID.x * 1024u + gl_LocalInvocationIndex * 4u;\n"
+	"	bool keep[4];\n"
+	"	uint sum = 0u;\n"
+	"	for (uint i = 0u; i < 4u; ++i)\n"
+	"	{\n"
+	"		keep[i] = (base + i < uCount) && bFlags[base + i] != 0u;\n"
+	"		sum += uint(keep[i]);\n"
+	"	}\n"
+	"	uint total;\n"
+	"	uint prefix = bPartials[gl_WorkGroupID.x] + BlockExclusiveScan(sum, total);\n"
+	"	for (uint i = 0u; i < 4u; ++i)\n"
+	"	{\n"
+	"		if (keep[i])\n"
+	"			bOutput[prefix++] = bInput[base + i];\n"
+	"	}\n"
+	"	if (gl_GlobalInvocationID.x == 0u)\n"
+	"		bCount[0] = (uCount != 0u) ? bPartials[uPartitionCount] : 0u;\n"
+	"}\n";
+
+// NOTE(ljre): Histograms are stored digit-major (all partitions of digit 0, then digit 1, ...), so an
+//             exclusive scan over the whole thing gives the global offset of each (digit, partition) pair in
+//             the same order a stable sort would put them.
+static char const g_gpuprims_radix_histogram_glsl[] =
+	GPUPRIMS_GLSL_COMMON_
+	"layout(std430, binding = 0) readonly buffer Keys { uint bKeys[]; };\n"
+	"layout(std430, binding = 16) writeonly buffer Histogram { uint bHistogram[]; };\n"
+	"shared uint sHistogram[16];\n"
+	"void main()\n"
+	"{\n"
+	"	uint tid = gl_LocalInvocationIndex;\n"
+	"	if (tid < 16u)\n"
+	"		sHistogram[tid] = 0u;\n"
+	"	memoryBarrierShared();\n"
+	"	barrier();\n"
+	"	uint base = gl_WorkGroupID.x * 1024u + tid * 4u;\n"
+	"	for (uint i = 0u; i < 4u; ++i)\n"
+	"	{\n"
+	"		if (base + i < uCount)\n"
+	"			atomicAdd(sHistogram[((bKeys[base + i] & uKeyMask) >> uShift) & 15u], 1u);\n"
+	"	}\n"
+	"	memoryBarrierShared();\n"
+	"	barrier();\n"
+	"	if (tid < 16u)\n"
+	"		bHistogram[tid * uPartitionCount + gl_WorkGroupID.x] = sHistogram[tid];\n"
+	"}\n";
+
+// NOTE(ljre): Each partition is first sorted locally by the 4 digit bits using 1-bit stable splits, so
+//             elements with the same digit become contiguous and keep their order. Out of range elements get
+//             a key with every bit set. Masked, that's still the highest digit, and since they come last and the
+//             splits are stable, they end up at the very end of the tile, where they're skipped.
+static char const g_gpuprims_radix_scatter_glsl[] =
+	GPUPRIMS_GLSL_COMMON_
+	"layout(std430, binding = 0) readonly buffer Keys { uint bKeys[]; };\n"
+	"layout(std430, binding = 1) readonly buffer Values { uint bValues[]; };\n"
+	"layout(std430, binding = 16) readonly buffer Offsets { uint bOffsets[]; };\n"
+	"layout(std430, binding = 17) writeonly buffer KeysOut { uint bKeysOut[]; };\n"
+	"layout(std430, binding = 18) writeonly buffer ValuesOut { uint bValuesOut[]; };\n"
+	"shared uint sKeys[1024];\n"
+	"shared uint sValues[1024];\n"
+	"shared uint sDigitStart[16];\n"
+	"void main()\n"
+	"{\n"
+	"	uint tid = gl_LocalInvocationIndex;\n"
+	"	uint base = gl_WorkGroupID.x * 1024u + tid * 4u;\n"
+	"	bool has_values = ((uFlags & 4u) != 0u);\n"
+	"	uint k[4];\n"
+	"	uint v[4];\n"
+	"	for (uint i = 0u; i < 4u; ++i)\n"
+	"	{\n"
+	"		bool in_range = (base + i < uCount);\n"
+	"		k[i] = in_range ? bKeys[base + i] : 0xFFFFFFFFu;\n"
+	"		v[i] = (in_range && has_values) ? bValues[base + i] : 0u;\n"
+	"	}\n"
+	"\n"
+	"	for (uint bit = 0u; bit < 4u; ++bit)\n"
+	"	{\n"
+	"		uint ones = 0u;\n"
+	"		for (uint i = 0u; i < 4u; ++i)\n"
+	"			ones += ((k[i] & uKeyMask) >> (uShift + bit)) & 1u;\n"
+	"		uint total_ones;\n"
+	"		uint ones_before = BlockExclusiveScan(ones, total_ones);\n"
+	"		uint total_zeros = 1024u - total_ones;\n"
+	"		for (uint i = 0u; i < 4u; ++i)\n"
+	"		{\n"
+	"			uint b = ((k[i] & uKeyMask) >> (uShift + bit)) & 1u;\n"
+	"			uint dst = (b != 0u) ? total_zeros + ones_before : tid*4u + i - ones_before;\n"
+	"			ones_before += b;\n"
+	"			sKeys[dst] = k[i];\n"
+	"			sValues[dst] = v[i];\n"
+	"		}\n"
+	"		memoryBarrierShared();\n"
+	"		barrier();\n"
+	"		for (uint i = 0u; i < 4u; ++i)\n"
+	"		{\n"
+	"			k[i] = sKeys[tid*4u + i];\n"
+	"			v[i] = sValues[tid*4u + i];\n"
+	"		}\n"
+	"		barrier();\n"
+	"	}\n"
+	"\n"
+	// sKeys holds the sorted tile from the last iteration, find where each digit starts
+	"	for (uint i = 0u; i < 4u; ++i)\n"
+	"	{\n"
+	"		uint j = tid*4u + i;\n"
+	"		uint digit = ((k[i] & uKeyMask) >> uShift) & 15u;\n"
+	"		if (j == 0u || (((sKeys[j - 1u] & uKeyMask) >> uShift) & 15u) != digit)\n"
+	"			sDigitStart[digit] = j;\n"
+	"	}\n"
+	"	memoryBarrierShared();\n"
+	"	barrier();\n"
+	"\n"
+	"	uint valid = min(1024u, uCount - gl_WorkGroupID.x * 1024u);\n"
+	"	for (uint i = 0u; i < 4u; ++i)\n"
+	"	{\n"
+	"		uint j = tid*4u + i;\n"
+	"		if (j >= valid)\n"
+	"			break;\n"
+	"		uint digit = ((k[i] & uKeyMask) >> uShift) & 15u;\n"
+	"		uint dst = bOffsets[digit * uPartitionCount + gl_WorkGroupID.x] + j - sDigitStart[digit];\n"
+	"		bKeysOut[dst] = k[i];\n"
+	"		if (has_values)\n"
+	"			bValuesOut[dst] = v[i];\n"
+	"	}\n"
+	"}\n";
+
+static uint32
+GpuPrimsPartitionCount_(uint32 count)
+{
+	return (count + GPUPRIMS_PARTITION_SIZE_-1) / GPUPRIMS_PARTITION_SIZE_;
+}
+
+static void
+GpuPrimsSetUniforms_(R3_Context* ctx, R3_GpuPrimitives* prims, uint32 count, uint32 shift, uint32 key_mask, uint32 flags)
+{
+	GpuPrimsUniforms_ uniforms = {
+		.count = count,
+		.partition_count = GpuPrimsPartitionCount_(count),
+		.shift = shift,
+		.flags = flags,
+		.key_mask = key_mask,
+	};
+	R3_UpdateBuffer(ctx, &prims->uniforms, &uniforms, sizeof(uniforms));
+
+	R3_UniformBuffer ubuffers[] = {
+		{ .buffer = &prims->uniforms },
+	};
+	R3_SetComputeUniformBuffers(ctx, ArrayLength(ubuffers), ubuffers);
+}
+
+// NOTE(ljre): Leaves the scanned partition sums in prims->partials, followed by the total. The uniforms have
+//             to be set already.
+static void
+GpuPrimsReduceAndScanPartials_(R3_Context* ctx, R3_GpuPrimitives* prims, R3_Buffer* input, uint32 count)
+{
+	uint32 partition_count = GpuPrimsPartitionCount_(count);
+	R3_ResourceView srvs[] = {
+		{ .buffer = input },
+	};
+	R3_UnorderedView uavs[] = {
+		{ .buffer = &prims->partials },
+	};
+
+	R3_SetComputePipeline(ctx, &prims->scan_reduce_pipeline);
+	R3_SetComputeResourceViews(ctx, ArrayLength(srvs), srvs);
+	R3_SetComputeUnorderedViews(ctx, ArrayLength(uavs), uavs);
+	R3_Dispatch(ctx, partition_count, 1, 1);
+
+	R3_SetComputePipeline(ctx, &prims->scan_partials_pipeline);
+	R3_Dispatch(ctx, 1, 1, 1);
+}
+
+static void
+GpuPrimsScan_(R3_Context* ctx, R3_GpuPrimitives* prims, R3_Buffer* input, R3_Buffer* output, uint32 count, uint32 flags)
+{
+	GpuPrimsSetUniforms_(ctx, prims, count, 0, ~0u, flags);
+	GpuPrimsReduceAndScanPartials_(ctx, prims, input, count);
+
+	R3_ResourceView srvs[] = {
+		{ .buffer = input },
+	};
+	R3_UnorderedView uavs[] = {
+		{ .buffer = &prims->partials },
+		{ .buffer = output },
+	};
+	R3_SetComputePipeline(ctx, &prims->scan_downsweep_pipeline);
+	R3_SetComputeResourceViews(ctx, ArrayLength(srvs), srvs);
+	R3_SetComputeUnorderedViews(ctx, ArrayLength(uavs), uavs);
+	R3_Dispatch(ctx, GpuPrimsPartitionCount_(count), 1, 1);
+}
+
+//------------------------------------------------------------------------
+API R3_GpuPrimitives
+R3_MakeGpuPrimitives(R3_Context* ctx, R3_GpuPrimitivesDesc const* desc)
+{
+	Trace();
+	R3_GpuPrimitives out = {};
+	uint32 partition_count = GpuPrimsPartitionCount_(desc->max_count);
+	uint32 histogram_count = partition_count * GPUPRIMS_RADIX_SIZE_;
+	SafeAssert(desc->max_count > 0 && partition_count <= GPUPRIMS_MAX_PARTITIONS_);
+
+	out.scan_reduce_pipeline = R3_MakeComputePipeline(ctx, &(R3_ComputePipelineDesc) {
+		.glsl = StrInit(g_gpuprims_scan_reduce_glsl),
+		.dx50 = desc->dx50_scan_reduce_cs,
+	});
+	out.scan_partials_pipeline = R3_MakeComputePipeline(ctx, &(R3_ComputePipelineDesc) {
+		.glsl = StrInit(g_gpuprims_scan_partials_glsl),
+		.dx50 = desc->dx50_scan_partials_cs,
+	});
+	out.scan_downsweep_pipeline = R3_MakeComputePipeline(ctx, &(R3_ComputePipelineDesc) {
+		.glsl = StrInit(g_gpuprims_scan_downsweep_glsl),
+		.dx50 = desc->dx50_scan_downsweep_cs,
+	});
+	out.compact_pipeline = R3_MakeComputePipeline(ctx, &(R3_ComputePipelineDesc) {
+		.glsl = StrInit(g_gpuprims_compact_glsl),
+		.dx50 = desc->dx50_compact_cs,
+	});
+	out.radix_histogram_pipeline = R3_MakeComputePipeline(ctx, &(R3_ComputePipelineDesc) {
+		.glsl = StrInit(g_gpuprims_radix_histogram_glsl),
+		.dx50 = desc->dx50_radix_histogram_cs,
+	});
+	out.radix_scatter_pipeline = R3_MakeComputePipeline(ctx, &(R3_ComputePipelineDesc) {
+		.glsl = StrInit(g_gpuprims_radix_scatter_glsl),
+		.dx50 = desc->dx50_radix_scatter_cs,
+	});
+
+	out.uniforms = R3_MakeBuffer(ctx, &(R3_BufferDesc) {
+		.size = sizeof(GpuPrimsUniforms_),
+		.binding_flags = R3_BindingFlag_UniformBuffer,
+		.usage = R3_Usage_Dynamic,
+	});
+
+	// NOTE(ljre): The partials are shared by the element scan and by the histogram scan of the radix sort,
+	//             +1 for the total.
+	uint32 partials_count = Max(partition_count, GpuPrimsPartitionCount_(histogram_count)) + 1;
+	uint32 const flags = R3_BindingFlag_UnorderedAccess | R3_BindingFlag_ShaderResource;
+	out.partials = R3_MakeBuffer(ctx, &(R3_BufferDesc) {
+		.size = sizeof(uint32) * partials_count,
+		.binding_flags = flags,
+		.usage = R3_Usage_GpuReadWrite,
+	});
+	out.histogram = R3_MakeBuffer(ctx, &(R3_BufferDesc) {
+		.size = sizeof(uint32) * histogram_count,
+		.binding_flags = flags,
+		.usage = R3_Usage_GpuReadWrite,
+	});
+	out.digit_offsets = R3_MakeBuffer(ctx, &(R3_BufferDesc) {
+		.size = sizeof(uint32) * histogram_count,
+		.binding_flags = flags,
+		.usage = R3_Usage_GpuReadWrite,
+	});
+	out.temp_keys = R3_MakeBuffer(ctx, &(R3_BufferDesc) {
+		.size = sizeof(uint32) * desc->max_count,
+		.binding_flags = flags,
+		.usage = R3_Usage_GpuReadWrite,
+	});
+	out.temp_values = R3_MakeBuffer(ctx, &(R3_BufferDesc) {
+		.size = sizeof(uint32) * desc->max_count,
+		.binding_flags = flags,
+		.usage = R3_Usage_GpuReadWrite,
+	});
+
+	out.max_count = desc->max_count;
+
+	return out;
+}
+
+API void
+R3_FreeGpuPrimitives(R3_Context* ctx, R3_GpuPrimitives* prims)
+{
+	Trace();
+
+	R3_FreeComputePipeline(ctx, &prims->scan_reduce_pipeline);
+	R3_FreeComputePipeline(ctx, &prims->scan_partials_pipeline);
+	R3_FreeComputePipeline(ctx, &prims->scan_downsweep_pipeline);
+	R3_FreeComputePipeline(ctx, &prims->compact_pipeline);
+	R3_FreeComputePipeline(ctx, &prims->radix_histogram_pipeline);
+	R3_FreeComputePipeline(ctx, &prims->radix_scatter_pipeline);
+	R3_FreeBuffer(ctx, &prims->uniforms);
+	R3_FreeBuffer(ctx, &prims->partials);
+	R3_FreeBuffer(ctx, &prims->histogram);
+	R3_FreeBuffer(ctx, &prims->digit_offsets);
+	R3_FreeBuffer(ctx, &prims->temp_keys);
+	R3_FreeBuffer(ctx, &prims->temp_values);
+
+	*prims = (R3_GpuPrimitives) {};
+}
+
+API void
+R3_GpuScan(R3_Context* ctx, R3_GpuPrimitives* prims, R3_GpuScanParams const* params)
+{
+	Trace();
+	SafeAssert(params->input && params->output);
+	SafeAssert(params->count <= prims->max_count);
+
+	if (params->count)
+		GpuPrimsScan_(ctx, prims, params->input, params->output, params->count, params->inclusive ? GpuPrimsFlag_Inclusive_ : 0);
+
+	R3_SetComputeUnorderedViews(ctx, 0, NULL);
+}
+
+API void
+R3_GpuCompact(R3_Context* ctx, R3_GpuPrimitives* prims, R3_GpuCompactParams const* params)
+{
+	Trace();
+	SafeAssert(params->input && params->flags && params->output && params->out_count);
+	SafeAssert(params->count <= prims->max_count);
+
+	// NOTE(ljre): With nothing to compact, a single workgroup still runs just to write 0 to 'out_count'.
+	//             R3_UpdateBuffer() would respecify the whole buffer on GL.
+	GpuPrimsSetUniforms_(ctx, prims, params->count, 0, ~0u, GpuPrimsFlag_CountNonZero_);
+	if (params->count)
+		GpuPrimsReduceAndScanPartials_(ctx, prims, params->flags, params->count);
+
+	R3_ResourceView srvs[] = {
+		{ .buffer = params->input },
+		{ .buffer = params->flags },
+	};
+	R3_UnorderedView uavs[] = {
+		{ .buffer = &prims->partials },
+		{ .buffer = params->output },
+		{ .buffer = params->out_count },
+	};
+	R3_SetComputePipeline(ctx, &prims->compact_pipeline);
+	R3_SetComputeResourceViews(ctx, ArrayLength(srvs), srvs);
+	R3_SetComputeUnorderedViews(ctx, ArrayLength(uavs), uavs);
+	R3_Dispatch(ctx, ClampMin(GpuPrimsPartitionCount_(params->count), 1), 1, 1);
+
+	R3_SetComputeUnorderedViews(ctx, 0, NULL);
+}
+
+API void
+R3_GpuRadixSort(R3_Context* ctx, R3_GpuPrimitives* prims, R3_GpuRadixSortParams const* params)
+{
+	Trace();
+	SafeAssert(params->keys);
+	SafeAssert(params->count <= prims->max_count);
+	SafeAssert(params->key_bits >= 0 && params->key_bits <= 32);
+
+	if (params->count <= 1)
+		return;
+
+	// NOTE(ljre): Bits above 'key_bits' may hold anything, so the shaders mask them out before taking digits,
+	//             and we never run a pass past the last digit. An odd pass count leaves the result in the temp
+	//             buffers, and we copy it back at the end.
+	int32 key_bits = (params->key_bits) ? params->key_bits : 32;
+	int32 pass_count = (key_bits + GPUPRIMS_RADIX_BITS_-1) / GPUPRIMS_RADIX_BITS_;
+	uint32 key_mask = (key_bits == 32) ? ~0u : (1u << key_bits) - 1;
+
+	uint32 partition_count = GpuPrimsPartitionCount_(params->count);
+	uint32 histogram_count = partition_count * GPUPRIMS_RADIX_SIZE_;
+	uint32 flags = (params->values) ? GpuPrimsFlag_HasValues_ : 0;
+	R3_Buffer* keys[2] = { params->keys, &prims->temp_keys };
+	R3_Buffer* values[2] = { params->values, &prims->temp_values };
+	// NOTE(ljre): Something has to be bound to the value slots even when we don't use them.
+	if (!params->values)
+		values[0] = params->keys;
+
+	for (int32 pass = 0; pass < pass_count; ++pass)
+	{
+		int32 from = pass & 1;
+		int32 to = from ^ 1;
+		uint32 shift = (uint32)(pass * GPUPRIMS_RADIX_BITS_);
+
+		// Count digits of each partition
+		GpuPrimsSetUniforms_(ctx, prims, params->count, shift, key_mask, flags);
+		R3_ResourceView histogram_srvs[] = {
+			{ .buffer = keys[from] },
+		};
+		R3_UnorderedView histogram_uavs[] = {
+			{ .buffer = &prims->histogram },
+		};
+		R3_SetComputePipeline(ctx, &prims->radix_histogram_pipeline);
+		R3_SetComputeResourceViews(ctx, ArrayLength(histogram_srvs), histogram_srvs);
+		R3_SetComputeUnorderedViews(ctx, ArrayLength(histogram_uavs), histogram_uavs);
+		R3_Dispatch(ctx, partition_count, 1, 1);
+
+		// Turn the counts into global offsets
+		GpuPrimsScan_(ctx, prims, &prims->histogram, &prims->digit_offsets, histogram_count, 0);
+
+		// Sort each partition locally and scatter
+		GpuPrimsSetUniforms_(ctx, prims, params->count, shift, key_mask, flags);
+		R3_ResourceView scatter_srvs[] = {
+			{ .buffer = keys[from] },
+			{ .buffer = values[from] },
+		};
+		R3_UnorderedView scatter_uavs[] = {
+			{ .buffer = &prims->digit_offsets },
+			{ .buffer = keys[to] },
+			{ .buffer = values[to] },
+		};
+		R3_SetComputePipeline(ctx, &prims->radix_scatter_pipeline);
+		R3_SetComputeResourceViews(ctx, ArrayLength(scatter_srvs), scatter_srvs);
+		R3_SetComputeUnorderedViews(ctx, ArrayLength(scatter_uavs), scatter_uavs);
+		R3_Dispatch(ctx, partition_count, 1, 1);
+	}
+
+	R3_SetComputeUnorderedViews(ctx, 0, NULL);
+
+	if (pass_count & 1)
+	{
+		uint32 size = sizeof(uint32) * params->count;
+		R3_CopyBuffer(ctx, &prims->temp_keys, 0, params->keys, 0, size);
+		if (params->values)
+			R3_CopyBuffer(ctx, &prims->temp_values, 0, params->values, 0, size);
+	}
+}
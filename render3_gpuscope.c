@@ -0,0 +1,221 @@
+#include <base/base.h>
+#include <base/base_intrinsics.h>
+#include <base/base_assert.h>
+#include <base/base_string.h>
+#include <base/base_arena.h>
+#include <layer_os/api.h>
+#include "api.h"
+
+struct R3_GpuScope_
+{
+	String name;
+	int32 depth;
+	int32 parent;
+	R3_Query begin;
+	R3_Query end;
+}
+typedef R3_GpuScope_;
+
+struct R3_GpuScopesFrame_
+{
+	R3_GpuScope_* scopes;
+	int32 count;
+	int32 query_count; // scopes[i] has its queries made if i < query_count
+	uint64 frame_index;
+	uint64 cpu_tick; // when the first scope began, for the timeline
+	bool timed; // recording or waiting for results of 'frame_index'
+}
+typedef R3_GpuScopesFrame_;
+
+// NOTE(ljre): Only returns true once every timestamp of the frame has arrived, so the results are never
+//             half-updated. Calling R3_GetQueryResult() twice is fine, it doesn't consume anything.
+static bool
+GpuScopeTryRead_(R3_Context* ctx, R3_GpuScopes* scopes, R3_GpuScopesFrame_* frame, uint64 frame_index)
+{
+	R3_QueryResult begin, end;
+	for (int32 i = 0; i < frame->count; ++i)
+	{
+		if (!R3_GetQueryResult(ctx, &frame->scopes[i].begin, &begin) ||
+			!R3_GetQueryResult(ctx, &frame->scopes[i].end, &end))
+		{
+			return false;
+		}
+		// NOTE(ljre): The clock can't be trusted for any of them, drop the whole frame.
+		if (begin.disjoint || end.disjoint)
+			return true;
+	}
+
+	uint64 origin = 0;
+	for (int32 i = 0; i < frame->count; ++i)
+	{
+		R3_GpuScope_* scope = &frame->scopes[i];
+		R3_GetQueryResult(ctx, &scope->begin, &begin);
+		R3_GetQueryResult(ctx, &scope->end, &end);
+		if (i == 0)
+			origin = begin.timestamp_ns;
+
+		scopes->results[i] = (R3_GpuScopeResult) {
+			.name = scope->name,
+			.depth = scope->depth,
+			.parent = scope->parent,
+			.begin_ms = (float64)(int64)(begin.timestamp_ns - origin) / 1000000.0,
+			.duration_ms = (end.timestamp_ns > begin.timestamp_ns) ? (float64)(end.timestamp_ns - begin.timestamp_ns) / 1000000.0 : 0.0,
+		};
+	}
+	scopes->result_count = frame->count;
+	scopes->result_frame = frame_index;
+
+	// NOTE(ljre): Submit-aligned: GPU timestamps can't be calibrated against the CPU clock on every backend, so
+	//             the frame is anchored to the CPU tick of its first scope instead.
+	if (frame->cpu_tick)
+	{
+		uint64 tick_rate = OS_TickRate();
+		for (int32 i = 0; i < frame->count; ++i)
+		{
+			R3_GpuScopeResult const* result = &scopes->results[i];
+			uint64 begin = frame->cpu_tick + (uint64)(result->begin_ms * (float64)tick_rate / 1000.0);
+			uint64 end = begin + (uint64)(result->duration_ms * (float64)tick_rate / 1000.0);
+			R3_PushTimelineEvent(scopes->timeline, R3_TimelineKind_Gpu, result->name, begin, end, 0);
+		}
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------
+API R3_GpuScopes
+R3_MakeGpuScopes(R3_Context* ctx, R3_GpuScopesDesc const* desc)
+{
+	Trace();
+	R3_GpuScopes out = {};
+	SafeAssert(desc->arena);
+
+	out.max_scopes = (desc->max_scopes > 0) ? desc->max_scopes : 64;
+	out.frame_latency = (desc->frame_latency > 0) ? desc->frame_latency : 4;
+	out.timeline = desc->timeline;
+	SafeAssert(out.frame_latency <= 16);
+
+	R3_ContextInfo info = R3_QueryInfo(ctx);
+	out.has_timer = info.has_timestamp_query;
+	out.frames = ArenaPushArray(desc->arena, R3_GpuScopesFrame_, out.frame_latency);
+	out.results = ArenaPushArray(desc->arena, R3_GpuScopeResult, out.max_scopes);
+	SafeAssert(out.frames && out.results);
+	MemoryZero(out.frames, sizeof(R3_GpuScopesFrame_) * out.frame_latency);
+	for (int32 i = 0; i < out.frame_latency; ++i)
+	{
+		out.frames[i].scopes = ArenaPushArray(desc->arena, R3_GpuScope_, out.max_scopes);
+		SafeAssert(out.frames[i].scopes);
+	}
+	out.frames[0].timed = out.has_timer;
+
+	return out;
+}
+
+API void
+R3_FreeGpuScopes(R3_Context* ctx, R3_GpuScopes* scopes)
+{
+	Trace();
+
+	for (int32 i = 0; i < scopes->frame_latency; ++i)
+	{
+		R3_GpuScopesFrame_* frame = &scopes->frames[i];
+		for (int32 j = 0; j < frame->query_count; ++j)
+		{
+			R3_FreeQuery(ctx, &frame->scopes[j].begin);
+			R3_FreeQuery(ctx, &frame->scopes[j].end);
+		}
+	}
+
+	*scopes = (R3_GpuScopes) {};
+}
+
+API void
+R3_BeginGpuScope(R3_Context* ctx, R3_GpuScopes* scopes, String name)
+{
+	Trace();
+	SafeAssert(scopes->depth < ArrayLength(scopes->stack));
+	R3_PushDebugGroup(ctx, name);
+
+	R3_GpuScopesFrame_* frame = &scopes->frames[scopes->frame % scopes->frame_latency];
+	bool timed = (frame->timed && frame->frame_index == scopes->frame);
+	int32 index = -1;
+	if (timed && frame->count < scopes->max_scopes)
+	{
+		index = frame->count++;
+		R3_GpuScope_* scope = &frame->scopes[index];
+		if (index >= frame->query_count)
+		{
+			scope->begin = R3_MakeQuery(ctx, R3_QueryKind_Timestamp);
+			scope->end = R3_MakeQuery(ctx, R3_QueryKind_Timestamp);
+			frame->query_count = index + 1;
+		}
+
+		if (index == 0)
+			frame->cpu_tick = R3_TimelineBegin(scopes->timeline);
+		scope->name = name;
+		scope->depth = scopes->depth;
+		scope->parent = -1;
+		for (int32 i = scopes->depth - 1; i >= 0 && scope->parent == -1; --i)
+			scope->parent = scopes->stack[i];
+		R3_WriteTimestamp(ctx, &scope->begin);
+	}
+	else if (timed)
+		++scopes->dropped_scopes;
+
+	scopes->stack[scopes->depth++] = index;
+}
+
+API void
+R3_EndGpuScope(R3_Context* ctx, R3_GpuScopes* scopes)
+{
+	Trace();
+	SafeAssert(scopes->depth > 0);
+
+	int32 index = scopes->stack[--scopes->depth];
+	if (index != -1)
+	{
+		R3_GpuScopesFrame_* frame = &scopes->frames[scopes->frame % scopes->frame_latency];
+		R3_WriteTimestamp(ctx, &frame->scopes[index].end);
+	}
+	R3_PopDebugGroup(ctx);
+}
+
+API void
+R3_EndGpuScopesFrame(R3_Context* ctx, R3_GpuScopes* scopes)
+{
+	Trace();
+	SafeAssert(scopes->depth == 0);
+	++scopes->frame;
+
+	// NOTE(ljre): Read every finished frame, oldest first. Untimed frames have nothing to wait for.
+	while (scopes->read_frame < scopes->frame)
+	{
+		R3_GpuScopesFrame_* frame = &scopes->frames[scopes->read_frame % scopes->frame_latency];
+		if (frame->timed && frame->frame_index == scopes->read_frame)
+		{
+			if (!GpuScopeTryRead_(ctx, scopes, frame, scopes->read_frame))
+				break;
+			frame->timed = false;
+		}
+		++scopes->read_frame;
+	}
+
+	// NOTE(ljre): If the GPU is so far behind that the slot wasn't read yet, reusing its queries would stall.
+	//             The frame still gets its debug groups, just no timings.
+	R3_GpuScopesFrame_* next = &scopes->frames[scopes->frame % scopes->frame_latency];
+	if (!next->timed && scopes->has_timer)
+	{
+		next->frame_index = scopes->frame;
+		next->cpu_tick = 0;
+		next->count = 0;
+		next->timed = true;
+	}
+}
+
+API R3_GpuScopeResult const*
+R3_GetGpuScopeResults(R3_GpuScopes* scopes, int32* out_count)
+{
+	Trace();
+	*out_count = scopes->result_count;
+	return scopes->results;
+}
@@ -0,0 +1,328 @@
+#include <base/base.h>
+#include <base/base_intrinsics.h>
+#include <base/base_assert.h>
+#include <base/base_string.h>
+#include <base/base_arena.h>
+#include <layer_os/api.h>
+#include "api.h"
+
+struct R3_GraphResourceInfo_
+{
+	R3_TextureDesc desc; // transient ones only
+	R3_Texture* texture;
+	R3_Buffer* buffer;
+	bool is_transient;
+	bool is_backbuffer;
+	bool is_exported;
+
+	// NOTE(ljre): Filled by R3_ExecuteGraph().
+	bool needed; // some later pass (or the app) consumes the current contents
+	bool written; // holds defined contents
+	int32 first_pass, last_pass; // kept passes touching it
+}
+typedef R3_GraphResourceInfo_;
+
+struct R3_GraphPassInfo_
+{
+	R3_GraphPassDesc desc;
+	bool is_culled;
+	bool store_colors[8];
+	bool store_depth_stencil;
+}
+typedef R3_GraphPassInfo_;
+
+static R3_GraphResource
+GraphAddResource_(R3_Graph* graph, R3_GraphResourceInfo_ const* info)
+{
+	SafeAssert(graph->resource_count < graph->max_resources);
+	uint32 index = graph->resource_count++;
+	graph->resources[index] = *info;
+	return (R3_GraphResource) { .id = index + 1 };
+}
+
+static inline R3_GraphResourceInfo_*
+GraphResource_(R3_Graph* graph, R3_GraphResource resource)
+{
+	if (!resource.id)
+		return NULL;
+	SafeAssert(resource.id <= graph->resource_count);
+	return &graph->resources[resource.id - 1];
+}
+
+static void
+GraphTouch_(R3_Graph* graph, R3_GraphResource resource, int32 pass_index)
+{
+	R3_GraphResourceInfo_* info = GraphResource_(graph, resource);
+	if (!info)
+		return;
+	if (info->first_pass == -1)
+		info->first_pass = pass_index;
+	info->last_pass = pass_index;
+}
+
+// NOTE(ljre): Walks the passes backwards tracking which resources still have a consumer. A pass is kept if it
+//             has side effects or writes something that is needed. Cleared attachments are fully overwritten,
+//             so whatever was there before isn't needed anymore; attachments that aren't cleared are loaded and
+//             unordered views may be read, so both keep the previous writers alive. An attachment is stored only
+//             if it's still needed once the pass is done.
+static void
+GraphCullPasses_(R3_Graph* graph)
+{
+	for (uint32 i = 0; i < graph->resource_count; ++i)
+		graph->resources[i].needed = graph->resources[i].is_exported;
+
+	for (int32 i = (int32)graph->pass_count - 1; i >= 0; --i)
+	{
+		R3_GraphPassInfo_* pass = &graph->passes[i];
+		R3_GraphPassDesc const* desc = &pass->desc;
+
+		bool keep = desc->flag_side_effects;
+		for (intz j = 0; j < ArrayLength(desc->color_attachments) && !keep; ++j)
+		{
+			R3_GraphResourceInfo_* info = GraphResource_(graph, desc->color_attachments[j]);
+			keep = (info && info->needed);
+		}
+		R3_GraphResourceInfo_* depth = GraphResource_(graph, desc->depth_stencil_attachment);
+		keep = keep || (depth && depth->needed);
+		for (intz j = 0; j < ArrayLength(desc->writes) && !keep; ++j)
+		{
+			R3_GraphResourceInfo_* info = GraphResource_(graph, desc->writes[j]);
+			keep = (info && info->needed);
+		}
+
+		pass->is_culled = !keep;
+		if (!keep)
+		{
+			++graph->culled_pass_count;
+			continue;
+		}
+
+		for (intz j = 0; j < ArrayLength(desc->color_attachments); ++j)
+		{
+			R3_GraphResourceInfo_* info = GraphResource_(graph, desc->color_attachments[j]);
+			if (!info)
+				continue;
+			pass->store_colors[j] = info->needed;
+			info->needed = !desc->colors[j].flag_clear;
+		}
+		if (depth)
+		{
+			pass->store_depth_stencil = depth->needed;
+			depth->needed = !desc->depth_stencil.flag_clear;
+		}
+		for (intz j = 0; j < ArrayLength(desc->writes); ++j)
+		{
+			R3_GraphResourceInfo_* info = GraphResource_(graph, desc->writes[j]);
+			if (info)
+				info->needed = true;
+		}
+		for (intz j = 0; j < ArrayLength(desc->reads); ++j)
+		{
+			R3_GraphResourceInfo_* info = GraphResource_(graph, desc->reads[j]);
+			if (info)
+				info->needed = true;
+		}
+	}
+}
+
+static void
+GraphComputeLifetimes_(R3_Graph* graph)
+{
+	for (uint32 i = 0; i < graph->resource_count; ++i)
+	{
+		graph->resources[i].first_pass = -1;
+		graph->resources[i].last_pass = -1;
+		graph->resources[i].written = !graph->resources[i].is_transient;
+	}
+
+	for (uint32 i = 0; i < graph->pass_count; ++i)
+	{
+		R3_GraphPassInfo_ const* pass = &graph->passes[i];
+		if (pass->is_culled)
+			continue;
+		for (intz j = 0; j < ArrayLength(pass->desc.color_attachments); ++j)
+			GraphTouch_(graph, pass->desc.color_attachments[j], (int32)i);
+		GraphTouch_(graph, pass->desc.depth_stencil_attachment, (int32)i);
+		for (intz j = 0; j < ArrayLength(pass->desc.writes); ++j)
+			GraphTouch_(graph, pass->desc.writes[j], (int32)i);
+		for (intz j = 0; j < ArrayLength(pass->desc.reads); ++j)
+			GraphTouch_(graph, pass->desc.reads[j], (int32)i);
+	}
+}
+
+static R3_LoadAction
+GraphLoadAction_(R3_GraphResourceInfo_* info, bool flag_clear)
+{
+	R3_LoadAction result = R3_LoadAction_DontCare;
+	if (flag_clear)
+		result = R3_LoadAction_Clear;
+	else if (info->written)
+		result = R3_LoadAction_Load;
+	info->written = true;
+	return result;
+}
+
+static void
+GraphRunPass_(R3_Context* ctx, R3_Graph* graph, R3_GraphPassInfo_* pass)
+{
+	R3_GraphPassDesc const* desc = &pass->desc;
+	R3_RenderPassDesc rpdesc = {};
+	bool is_render_pass = false;
+
+	for (intz i = 0; i < ArrayLength(desc->color_attachments); ++i)
+	{
+		R3_GraphResourceInfo_* info = GraphResource_(graph, desc->color_attachments[i]);
+		if (!info)
+			continue;
+		// NOTE(ljre): The backbuffer can't be mixed with other attachments.
+		SafeAssert(!info->is_backbuffer || (i == 0 && !desc->depth_stencil_attachment.id));
+		is_render_pass = true;
+		rpdesc.color_textures[i] = info->texture;
+		rpdesc.colors[i].load = GraphLoadAction_(info, desc->colors[i].flag_clear);
+		rpdesc.colors[i].store = pass->store_colors[i] ? R3_StoreAction_Store : R3_StoreAction_Discard;
+		MemoryCopy(rpdesc.colors[i].clear_color, desc->colors[i].clear_color, sizeof(rpdesc.colors[i].clear_color));
+	}
+	R3_GraphResourceInfo_* depth = GraphResource_(graph, desc->depth_stencil_attachment);
+	if (depth)
+	{
+		SafeAssert(depth->texture && !depth->is_backbuffer);
+		is_render_pass = true;
+		rpdesc.depth_stencil_texture = depth->texture;
+		rpdesc.depth_stencil.load = GraphLoadAction_(depth, desc->depth_stencil.flag_clear);
+		rpdesc.depth_stencil.store = pass->store_depth_stencil ? R3_StoreAction_Store : R3_StoreAction_Discard;
+		rpdesc.depth_stencil.clear_depth = desc->depth_stencil.clear_depth;
+		rpdesc.depth_stencil.clear_stencil = desc->depth_stencil.clear_stencil;
+	}
+	for (intz i = 0; i < ArrayLength(desc->writes); ++i)
+	{
+		R3_GraphResourceInfo_* info = GraphResource_(graph, desc->writes[i]);
+		if (info)
+			info->written = true;
+	}
+
+	if (is_render_pass)
+		R3_BeginRenderPass(ctx, &rpdesc);
+	if (desc->execute)
+		desc->execute(ctx, graph, desc->user_data);
+	if (is_render_pass)
+		R3_EndRenderPass(ctx);
+}
+
+//------------------------------------------------------------------------
+API R3_Graph
+R3_MakeGraph(R3_Context* ctx, R3_GraphDesc const* desc)
+{
+	Trace();
+	R3_Graph out = {};
+	SafeAssert(desc->arena && desc->max_passes > 0 && desc->max_resources > 0);
+
+	out.pool = desc->pool;
+	out.max_passes = desc->max_passes;
+	out.max_resources = desc->max_resources;
+	out.passes = ArenaPushArray(desc->arena, R3_GraphPassInfo_, out.max_passes);
+	out.resources = ArenaPushArray(desc->arena, R3_GraphResourceInfo_, out.max_resources);
+	SafeAssert(out.passes && out.resources);
+
+	return out;
+}
+
+API R3_GraphResource
+R3_GraphImportTexture(R3_Graph* graph, R3_Texture* texture)
+{
+	Trace();
+	SafeAssert(texture);
+	return GraphAddResource_(graph, &(R3_GraphResourceInfo_) { .texture = texture });
+}
+
+API R3_GraphResource
+R3_GraphImportBuffer(R3_Graph* graph, R3_Buffer* buffer)
+{
+	Trace();
+	SafeAssert(buffer);
+	return GraphAddResource_(graph, &(R3_GraphResourceInfo_) { .buffer = buffer });
+}
+
+API R3_GraphResource
+R3_GraphImportBackbuffer(R3_Graph* graph)
+{
+	Trace();
+	return GraphAddResource_(graph, &(R3_GraphResourceInfo_) { .is_backbuffer = true, .is_exported = true });
+}
+
+API R3_GraphResource
+R3_GraphCreateTexture(R3_Graph* graph, R3_TextureDesc const* desc)
+{
+	Trace();
+	SafeAssert(graph->pool && !desc->initial_data);
+	return GraphAddResource_(graph, &(R3_GraphResourceInfo_) { .desc = *desc, .is_transient = true });
+}
+
+API void
+R3_GraphExport(R3_Graph* graph, R3_GraphResource resource)
+{
+	Trace();
+	R3_GraphResourceInfo_* info = GraphResource_(graph, resource);
+	SafeAssert(info && !info->is_transient);
+	info->is_exported = true;
+}
+
+API void
+R3_AddGraphPass(R3_Graph* graph, R3_GraphPassDesc const* desc)
+{
+	Trace();
+	SafeAssert(graph->pass_count < graph->max_passes);
+	graph->passes[graph->pass_count++] = (R3_GraphPassInfo_) { .desc = *desc };
+}
+
+API R3_Texture*
+R3_GraphGetTexture(R3_Graph* graph, R3_GraphResource resource)
+{
+	Trace();
+	R3_GraphResourceInfo_* info = GraphResource_(graph, resource);
+	SafeAssert(info);
+	return info->texture;
+}
+
+API R3_Buffer*
+R3_GraphGetBuffer(R3_Graph* graph, R3_GraphResource resource)
+{
+	Trace();
+	R3_GraphResourceInfo_* info = GraphResource_(graph, resource);
+	SafeAssert(info);
+	return info->buffer;
+}
+
+API void
+R3_ExecuteGraph(R3_Context* ctx, R3_Graph* graph)
+{
+	Trace();
+	graph->culled_pass_count = 0;
+	GraphCullPasses_(graph);
+	GraphComputeLifetimes_(graph);
+
+	for (uint32 i = 0; i < graph->pass_count; ++i)
+	{
+		R3_GraphPassInfo_* pass = &graph->passes[i];
+		if (pass->is_culled)
+			continue;
+
+		for (uint32 j = 0; j < graph->resource_count; ++j)
+		{
+			R3_GraphResourceInfo_* info = &graph->resources[j];
+			if (info->is_transient && info->first_pass == (int32)i)
+				info->texture = R3_AcquireTransientTexture(ctx, graph->pool, &info->desc);
+		}
+
+		GraphRunPass_(ctx, graph, pass);
+
+		for (uint32 j = 0; j < graph->resource_count; ++j)
+		{
+			R3_GraphResourceInfo_* info = &graph->resources[j];
+			if (info->is_transient && info->last_pass == (int32)i)
+			{
+				R3_ReleaseTransientTexture(ctx, graph->pool, info->texture);
+				info->texture = NULL;
+			}
+		}
+	}
+}
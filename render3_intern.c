@@ -0,0 +1,374 @@
+#include <base/base.h>
+#include <base/base_intrinsics.h>
+#include <base/base_assert.h>
+#include <base/base_arena.h>
+#include <layer_os/api.h>
+#include "api.h"
+
+// NOTE(ljre): Descriptors are flattened into these before hashing. They are zeroed first and then filled field
+//             by field, so padding is always zero and MemoryCompare() works. Shader sources are replaced by
+//             the hash and size of their contents, and their bytes are only compared on a key match.
+struct InternSource_
+{
+	uint64 hash;
+	uint64 size;
+}
+typedef InternSource_;
+
+struct InternPipelineKey_
+{
+	uint8 flag_cw_frontface;
+	uint8 flag_depth_test;
+	uint8 flag_async;
+	uint8 flag_scissor;
+	struct
+	{
+		uint8 enable_blend;
+		int32 src, dst, op;
+		int32 src_alpha, dst_alpha, op_alpha;
+	} rendertargets[8];
+	int32 fill_mode;
+	int32 cull_mode;
+	InternSource_ sources[11];
+	R3_LayoutDesc input_layout[16];
+}
+typedef InternPipelineKey_;
+
+struct InternSamplerKey_
+{
+	int32 filtering;
+	float32 anisotropy;
+}
+typedef InternSamplerKey_;
+
+struct R3_InternedPipeline_
+{
+	uint64 hash;
+	int32 refcount; // 0 is an empty slot, -1 a deleted one
+	InternPipelineKey_ key;
+	Buffer sources[11]; // point into 'source_storage', same order as key.sources
+	uint8* source_storage; // from the cache's arena, kept by the slot for whoever takes it next
+	intz source_capacity;
+	R3_Pipeline pipeline;
+}
+typedef R3_InternedPipeline_;
+
+struct R3_InternedSampler_
+{
+	uint64 hash;
+	int32 refcount;
+	InternSamplerKey_ key;
+	R3_Sampler sampler;
+}
+typedef R3_InternedSampler_;
+
+static uint64
+InternHash_(uint64 hash, void const* data, intz size)
+{
+	uint8 const* bytes = (uint8 const*)data;
+	for (intz i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+static InternSource_
+InternMakeSource_(Buffer source)
+{
+	return (InternSource_) {
+		.hash = InternHash_(0xcbf29ce484222325ull, source.data, source.size),
+		.size = (uint64)source.size,
+	};
+}
+
+static void
+InternGetSources_(R3_PipelineDesc const* desc, Buffer out_sources[11])
+{
+	Buffer const sources[11] = {
+		desc->glsl.vs, desc->glsl.fs, desc->glsl.defines,
+		desc->dx50.vs, desc->dx50.ps,
+		desc->dx40.vs, desc->dx40.ps,
+		desc->dx40_93.vs, desc->dx40_93.ps,
+		desc->dx40_91.vs, desc->dx40_91.ps,
+	};
+	MemoryCopy(out_sources, sources, sizeof(sources));
+}
+
+static bool
+InternSourcesEqual_(Buffer const a[11], Buffer const b[11])
+{
+	for (intz i = 0; i < 11; ++i)
+	{
+		if (a[i].size != b[i].size || (a[i].size && MemoryCompare(a[i].data, b[i].data, a[i].size) != 0))
+			return false;
+	}
+	return true;
+}
+
+static void
+InternMakePipelineKey_(InternPipelineKey_* key, R3_PipelineDesc const* desc, Buffer const sources[11])
+{
+	MemoryZero(key, sizeof(*key));
+	key->flag_cw_frontface = desc->flag_cw_frontface;
+	key->flag_depth_test = desc->flag_depth_test;
+	key->flag_async = desc->flag_async;
+	key->flag_scissor = desc->flag_scissor;
+	for (intz i = 0; i < ArrayLength(key->rendertargets); ++i)
+	{
+		key->rendertargets[i].enable_blend = desc->rendertargets[i].enable_blend;
+		key->rendertargets[i].src = desc->rendertargets[i].src;
+		key->rendertargets[i].dst = desc->rendertargets[i].dst;
+		key->rendertargets[i].op = desc->rendertargets[i].op;
+		key->rendertargets[i].src_alpha = desc->rendertargets[i].src_alpha;
+		key->rendertargets[i].dst_alpha = desc->rendertargets[i].dst_alpha;
+		key->rendertargets[i].op_alpha = desc->rendertargets[i].op_alpha;
+	}
+	key->fill_mode = desc->fill_mode;
+	key->cull_mode = desc->cull_mode;
+
+	for (intz i = 0; i < ArrayLength(key->sources); ++i)
+		key->sources[i] = InternMakeSource_(sources[i]);
+
+	for (intz i = 0; i < ArrayLength(key->input_layout); ++i)
+	{
+		key->input_layout[i].offset = desc->input_layout[i].offset;
+		key->input_layout[i].format = desc->input_layout[i].format;
+		key->input_layout[i].buffer_slot = desc->input_layout[i].buffer_slot;
+		key->input_layout[i].divisor = desc->input_layout[i].divisor;
+	}
+}
+
+// NOTE(ljre): Linear probing. Return the slot holding 'key', or the first free one passed by if there's no
+//             such slot. Deleted slots keep the probe chain going.
+static intz
+InternFindPipeline_(R3_InternCache* cache, uint64 hash, InternPipelineKey_ const* key, Buffer const sources[11])
+{
+	uint32 mask = cache->pipeline_capacity - 1;
+	intz free_index = -1;
+	for (uint32 i = 0, at = (uint32)hash & mask; i < cache->pipeline_capacity; ++i, at = (at+1) & mask)
+	{
+		R3_InternedPipeline_* entry = &cache->pipelines[at];
+		if (entry->refcount <= 0)
+		{
+			if (free_index == -1)
+				free_index = at;
+			if (entry->refcount == 0)
+				break;
+		}
+		else if (entry->hash == hash && MemoryCompare(&entry->key, key, sizeof(*key)) == 0 && InternSourcesEqual_(entry->sources, sources))
+			return at;
+	}
+	return free_index;
+}
+
+static intz
+InternFindSampler_(R3_InternCache* cache, uint64 hash, InternSamplerKey_ const* key)
+{
+	uint32 mask = cache->sampler_capacity - 1;
+	intz free_index = -1;
+	for (uint32 i = 0, at = (uint32)hash & mask; i < cache->sampler_capacity; ++i, at = (at+1) & mask)
+	{
+		R3_InternedSampler_* entry = &cache->samplers[at];
+		if (entry->refcount <= 0)
+		{
+			if (free_index == -1)
+				free_index = at;
+			if (entry->refcount == 0)
+				break;
+		}
+		else if (entry->hash == hash && MemoryCompare(&entry->key, key, sizeof(*key)) == 0)
+			return at;
+	}
+	return free_index;
+}
+
+static uint32
+InternCapacity_(uint32 max_count)
+{
+	// NOTE(ljre): Keep the load factor at 50% at most.
+	uint32 capacity = 16;
+	while (capacity < max_count*2)
+		capacity <<= 1;
+	return capacity;
+}
+
+//------------------------------------------------------------------------
+API R3_InternCache
+R3_MakeInternCache(R3_Context* ctx, R3_InternCacheDesc const* desc)
+{
+	Trace();
+	R3_InternCache out = {};
+	SafeAssert(desc->arena);
+
+	out.arena = desc->arena;
+	out.pipeline_capacity = InternCapacity_(desc->max_pipelines);
+	out.sampler_capacity = InternCapacity_(desc->max_samplers);
+	out.pipelines = ArenaPushArray(desc->arena, R3_InternedPipeline_, out.pipeline_capacity);
+	out.samplers = ArenaPushArray(desc->arena, R3_InternedSampler_, out.sampler_capacity);
+	SafeAssert(out.pipelines && out.samplers);
+	MemoryZero(out.pipelines, sizeof(R3_InternedPipeline_) * out.pipeline_capacity);
+	MemoryZero(out.samplers, sizeof(R3_InternedSampler_) * out.sampler_capacity);
+
+	return out;
+}
+
+API void
+R3_FreeInternCache(R3_Context* ctx, R3_InternCache* cache)
+{
+	Trace();
+
+	for (uint32 i = 0; i < cache->pipeline_capacity; ++i)
+	{
+		if (cache->pipelines[i].refcount > 0)
+			R3_FreePipeline(ctx, &cache->pipelines[i].pipeline);
+	}
+	for (uint32 i = 0; i < cache->sampler_capacity; ++i)
+	{
+		if (cache->samplers[i].refcount > 0)
+			R3_FreeSampler(ctx, &cache->samplers[i].sampler);
+	}
+
+	*cache = (R3_InternCache) {};
+}
+
+API R3_Pipeline*
+R3_InternPipeline(R3_Context* ctx, R3_InternCache* cache, R3_PipelineDesc const* desc)
+{
+	Trace();
+	Buffer sources[11];
+	InternGetSources_(desc, sources);
+	InternPipelineKey_ key;
+	InternMakePipelineKey_(&key, desc, sources);
+	uint64 hash = InternHash_(0xcbf29ce484222325ull, &key, sizeof(key));
+
+	intz index = InternFindPipeline_(cache, hash, &key, sources);
+	SafeAssert(index != -1);
+
+	R3_InternedPipeline_* entry = &cache->pipelines[index];
+	if (entry->refcount > 0)
+	{
+		++entry->refcount;
+		++cache->pipeline_hits;
+		return &entry->pipeline;
+	}
+
+	SafeAssert(cache->pipeline_count*2 < cache->pipeline_capacity);
+	entry->hash = hash;
+	entry->refcount = 1;
+	entry->key = key;
+
+	// NOTE(ljre): The slot's old storage is reused when it's big enough, so churning through pipelines of
+	//             similar size doesn't grow the arena.
+	intz source_size = 0;
+	for (intz i = 0; i < ArrayLength(sources); ++i)
+		source_size += sources[i].size;
+	if (source_size > entry->source_capacity)
+	{
+		entry->source_storage = ArenaPushArray(cache->arena, uint8, source_size);
+		entry->source_capacity = source_size;
+		SafeAssert(entry->source_storage);
+	}
+	intz offset = 0;
+	for (intz i = 0; i < ArrayLength(sources); ++i)
+	{
+		entry->sources[i] = (Buffer) {};
+		if (!sources[i].size)
+			continue;
+		MemoryCopy(entry->source_storage + offset, sources[i].data, sources[i].size);
+		entry->sources[i] = (Buffer) { .data = entry->source_storage + offset, .size = sources[i].size };
+		offset += sources[i].size;
+	}
+	entry->pipeline = R3_MakePipeline(ctx, desc);
+	++cache->pipeline_count;
+
+	return &entry->pipeline;
+}
+
+API void
+R3_ReleasePipeline(R3_Context* ctx, R3_InternCache* cache, R3_Pipeline* pipeline)
+{
+	Trace();
+	R3_InternedPipeline_* entry = (R3_InternedPipeline_*)((uint8*)pipeline - offsetof(R3_InternedPipeline_, pipeline));
+	SafeAssert(entry >= cache->pipelines && entry < cache->pipelines + cache->pipeline_capacity);
+	SafeAssert(entry->refcount > 0);
+
+	if (--entry->refcount == 0)
+	{
+		R3_FreePipeline(ctx, &entry->pipeline);
+		entry->refcount = -1;
+		--cache->pipeline_count;
+
+		// NOTE(ljre): Deleted slots right before an empty one don't continue any probe chain, so they can be
+		//             emptied. Without this, probe chains only ever get longer.
+		uint32 mask = cache->pipeline_capacity - 1;
+		uint32 at = (uint32)(entry - cache->pipelines);
+		if (cache->pipelines[(at+1) & mask].refcount == 0)
+		{
+			while (cache->pipelines[at].refcount == -1)
+			{
+				cache->pipelines[at].refcount = 0;
+				at = (at-1) & mask;
+			}
+		}
+	}
+}
+
+API R3_Sampler*
+R3_InternSampler(R3_Context* ctx, R3_InternCache* cache, R3_SamplerDesc const* desc)
+{
+	Trace();
+	InternSamplerKey_ key;
+	MemoryZero(&key, sizeof(key));
+	key.filtering = desc->filtering;
+	key.anisotropy = desc->anisotropy;
+	uint64 hash = InternHash_(0xcbf29ce484222325ull, &key, sizeof(key));
+
+	intz index = InternFindSampler_(cache, hash, &key);
+	SafeAssert(index != -1);
+
+	R3_InternedSampler_* entry = &cache->samplers[index];
+	if (entry->refcount > 0)
+	{
+		++entry->refcount;
+		++cache->sampler_hits;
+		return &entry->sampler;
+	}
+
+	SafeAssert(cache->sampler_count*2 < cache->sampler_capacity);
+	entry->hash = hash;
+	entry->refcount = 1;
+	entry->key = key;
+	entry->sampler = R3_MakeSampler(ctx, desc);
+	++cache->sampler_count;
+
+	return &entry->sampler;
+}
+
+API void
+R3_ReleaseSampler(R3_Context* ctx, R3_InternCache* cache, R3_Sampler* sampler)
+{
+	Trace();
+	R3_InternedSampler_* entry = (R3_InternedSampler_*)((uint8*)sampler - offsetof(R3_InternedSampler_, sampler));
+	SafeAssert(entry >= cache->samplers && entry < cache->samplers + cache->sampler_capacity);
+	SafeAssert(entry->refcount > 0);
+
+	if (--entry->refcount == 0)
+	{
+		R3_FreeSampler(ctx, &entry->sampler);
+		entry->refcount = -1;
+		--cache->sampler_count;
+
+		uint32 mask = cache->sampler_capacity - 1;
+		uint32 at = (uint32)(entry - cache->samplers);
+		if (cache->samplers[(at+1) & mask].refcount == 0)
+		{
+			while (cache->samplers[at].refcount == -1)
+			{
+				cache->samplers[at].refcount = 0;
+				at = (at-1) & mask;
+			}
+		}
+	}
+}
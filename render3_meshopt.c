@@ -0,0 +1,503 @@
+#include <base/base.h>
+#include <base/base_intrinsics.h>
+#include <base/base_assert.h>
+#include <base/base_arena.h>
+#include <layer_os/api.h>
+#include "api.h"
+
+struct MeshoptAdjacency_
+{
+	uint32* offsets; // vertex_count+1 entries
+	uint32* triangles; // index_count entries
+}
+typedef MeshoptAdjacency_;
+
+// NOTE(ljre): FIFO post-transform cache simulation. A vertex is a hit if it was inserted less than
+//             'cache_size' insertions ago. Bumping 'time' by 'cache_size+1' flushes the whole cache.
+struct MeshoptCache_
+{
+	uint32* stamps;
+	int64 time;
+	int32 cache_size;
+}
+typedef MeshoptCache_;
+
+static MeshoptAdjacency_
+MeshoptBuildAdjacency_(uint32 const* indices, intz index_count, intz vertex_count, Arena* arena)
+{
+	MeshoptAdjacency_ adj = {
+		.offsets = ArenaPushArray(arena, uint32, vertex_count+1),
+		.triangles = ArenaPushArray(arena, uint32, index_count),
+	};
+	uint32* cursors = ArenaPushArray(arena, uint32, vertex_count);
+
+	MemoryZero(adj.offsets, sizeof(uint32) * (vertex_count+1));
+	for (intz i = 0; i < index_count; ++i)
+	{
+		SafeAssert(indices[i] < (uint64)vertex_count);
+		++adj.offsets[indices[i] + 1];
+	}
+	for (intz i = 0; i < vertex_count; ++i)
+	{
+		adj.offsets[i+1] += adj.offsets[i];
+		cursors[i] = adj.offsets[i];
+	}
+	for (intz i = 0; i < index_count; ++i)
+		adj.triangles[cursors[indices[i]]++] = (uint32)(i / 3);
+
+	return adj;
+}
+
+static MeshoptCache_
+MeshoptMakeCache_(intz vertex_count, int32 cache_size, Arena* arena)
+{
+	MeshoptCache_ cache = {
+		.stamps = ArenaPushArray(arena, uint32, vertex_count),
+		.time = cache_size + 1,
+		.cache_size = cache_size,
+	};
+	MemoryZero(cache.stamps, sizeof(uint32) * vertex_count);
+	return cache;
+}
+
+static inline bool
+MeshoptCacheAccess_(MeshoptCache_* cache, uint32 vertex)
+{
+	if (cache->time - cache->stamps[vertex] <= cache->cache_size)
+		return false;
+	cache->stamps[vertex] = (uint32)cache->time++;
+	return true;
+}
+
+static inline void
+MeshoptCacheFlush_(MeshoptCache_* cache)
+{
+	cache->time += cache->cache_size + 1;
+}
+
+static inline float32 const*
+MeshoptPosition_(void const* vertices, uint32 vertex_stride, uint32 position_offset, uint32 vertex)
+{
+	return (float32 const*)((uint8 const*)vertices + (uintz)vertex*vertex_stride + position_offset);
+}
+
+// NOTE(ljre): Stable bottom-up merge sort of 'items' by 'keys[item]', from highest to lowest.
+static void
+MeshoptSortDescending_(uint32* items, intz count, float32 const* keys, Arena* arena)
+{
+	uint32* tmp = ArenaPushArray(arena, uint32, count);
+	uint32* src = items;
+	uint32* dst = tmp;
+
+	for (intz width = 1; width < count; width *= 2)
+	{
+		for (intz begin = 0; begin < count; begin += width*2)
+		{
+			intz mid = Min(begin + width, count);
+			intz end = Min(begin + width*2, count);
+			intz l = begin, r = mid, out = begin;
+
+			while (l < mid && r < end)
+				dst[out++] = (keys[src[r]] > keys[src[l]]) ? src[r++] : src[l++];
+			while (l < mid)
+				dst[out++] = src[l++];
+			while (r < end)
+				dst[out++] = src[r++];
+		}
+
+		uint32* swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	if (src != items)
+		MemoryCopy(items, src, sizeof(uint32) * count);
+}
+
+//------------------------------------------------------------------------
+API float32
+R3_AnalyzeVertexCache(uint32 const* indices, intz index_count, intz vertex_count, int32 cache_size, float32* out_atvr)
+{
+	Trace();
+	SafeAssert(index_count % 3 == 0);
+	if (!cache_size)
+		cache_size = 16;
+	if (!index_count)
+	{
+		if (out_atvr)
+			*out_atvr = 0.0f;
+		return 0.0f;
+	}
+
+	ArenaSavepoint scratch = ArenaSave(OS_ScratchArena(NULL, 0));
+	MeshoptCache_ cache = MeshoptMakeCache_(vertex_count, cache_size, scratch.arena);
+	uint8* referenced = ArenaPushArray(scratch.arena, uint8, vertex_count);
+	MemoryZero(referenced, vertex_count);
+
+	intz misses = 0;
+	intz unique = 0;
+	for (intz i = 0; i < index_count; ++i)
+	{
+		uint32 v = indices[i];
+		SafeAssert(v < (uint64)vertex_count);
+		misses += MeshoptCacheAccess_(&cache, v);
+		unique += !referenced[v];
+		referenced[v] = 1;
+	}
+
+	ArenaRestore(scratch);
+	if (out_atvr)
+		*out_atvr = (float32)misses / (float32)unique;
+	return (float32)misses / (float32)(index_count / 3);
+}
+
+// NOTE(ljre): Tipsify, from "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (Sander et al.
+//             2007). Every time we run into a dead-end and have to jump to a vertex that is not in the cache,
+//             a new cluster starts. Those "hard boundaries" are written to 'out_clusters' as the index of the
+//             first triangle of each cluster, and are what R3_OptimizeOverdraw sorts around.
+//
+//             'out_clusters' is optional and, if present, needs space for index_count/3 entries.
+//             Returns the number of clusters.
+API intz
+R3_OptimizeVertexCache(uint32* dst, uint32 const* indices, intz index_count, intz vertex_count, int32 cache_size, uint32* out_clusters)
+{
+	Trace();
+	SafeAssert(index_count % 3 == 0);
+	SafeAssert(dst != indices);
+	if (!cache_size)
+		cache_size = 16;
+	if (!index_count)
+		return 0;
+
+	ArenaSavepoint scratch = ArenaSave(OS_ScratchArena(NULL, 0));
+	intz triangle_count = index_count / 3;
+	MeshoptAdjacency_ adj = MeshoptBuildAdjacency_(indices, index_count, vertex_count, scratch.arena);
+	uint32* live = ArenaPushArray(scratch.arena, uint32, vertex_count);
+	uint32* cache_time = ArenaPushArray(scratch.arena, uint32, vertex_count);
+	uint32* dead_end = ArenaPushArray(scratch.arena, uint32, index_count);
+	uint32* candidates = ArenaPushArray(scratch.arena, uint32, index_count);
+	uint8* emitted = ArenaPushArray(scratch.arena, uint8, triangle_count);
+
+	for (intz i = 0; i < vertex_count; ++i)
+	{
+		live[i] = adj.offsets[i+1] - adj.offsets[i];
+		cache_time[i] = 0;
+	}
+	MemoryZero(emitted, triangle_count);
+
+	int64 timestamp = cache_size + 1;
+	intz dead_end_count = 0;
+	intz cursor = 0;
+	intz out_triangle = 0;
+	intz cluster_count = 0;
+	bool new_cluster = true;
+	int64 fan = indices[0];
+
+	while (fan >= 0)
+	{
+		if (new_cluster)
+		{
+			if (out_clusters)
+				out_clusters[cluster_count] = (uint32)out_triangle;
+			++cluster_count;
+		}
+
+		// Emit every triangle around the fanning vertex
+		intz candidate_count = 0;
+		for (uint32 k = adj.offsets[fan]; k < adj.offsets[fan+1]; ++k)
+		{
+			uint32 triangle = adj.triangles[k];
+			if (emitted[triangle])
+				continue;
+
+			for (intz j = 0; j < 3; ++j)
+			{
+				uint32 v = indices[triangle*3 + j];
+				dst[out_triangle*3 + j] = v;
+				dead_end[dead_end_count++] = v;
+				candidates[candidate_count++] = v;
+				--live[v];
+				if (timestamp - cache_time[v] > cache_size)
+					cache_time[v] = (uint32)timestamp++;
+			}
+
+			emitted[triangle] = 1;
+			++out_triangle;
+		}
+
+		// Pick the next fanning vertex among the ones we just touched
+		int64 best = -1;
+		int64 best_priority = -1;
+		for (intz i = 0; i < candidate_count; ++i)
+		{
+			uint32 v = candidates[i];
+			if (!live[v])
+				continue;
+
+			int64 priority = 0;
+			if (timestamp - cache_time[v] + 2*(int64)live[v] <= cache_size)
+				priority = timestamp - cache_time[v];
+			if (priority > best_priority)
+			{
+				best = v;
+				best_priority = priority;
+			}
+		}
+
+		new_cluster = false;
+		if (best == -1)
+		{
+			new_cluster = true;
+			while (dead_end_count > 0 && best == -1)
+			{
+				uint32 v = dead_end[--dead_end_count];
+				if (live[v])
+					best = v;
+			}
+			while (cursor < vertex_count && best == -1)
+			{
+				if (live[cursor])
+					best = cursor;
+				++cursor;
+			}
+		}
+
+		fan = best;
+	}
+
+	SafeAssert(out_triangle == triangle_count);
+	ArenaRestore(scratch);
+	return cluster_count;
+}
+
+// NOTE(ljre): Splits the clusters produced by R3_OptimizeVertexCache further wherever the local ACMR drops
+//             below 'threshold' times the mesh's ACMR ("soft boundaries"), and then sorts the clusters so the
+//             ones facing away from the mesh's center are drawn first. Those tend to occlude the others, so
+//             we get fewer overwritten fragments for a small ACMR cost.
+API void
+R3_OptimizeOverdraw(uint32* dst, uint32 const* indices, intz index_count, uint32 const* clusters, intz cluster_count, void const* vertices, intz vertex_count, uint32 vertex_stride, uint32 position_offset, int32 cache_size, float32 threshold)
+{
+	Trace();
+	SafeAssert(index_count % 3 == 0);
+	SafeAssert(dst != indices);
+	SafeAssert(cluster_count > 0 || !index_count);
+	if (!cache_size)
+		cache_size = 16;
+	if (threshold <= 0.0f)
+		threshold = 1.05f;
+	if (!index_count)
+		return;
+
+	ArenaSavepoint scratch = ArenaSave(OS_ScratchArena(NULL, 0));
+	intz triangle_count = index_count / 3;
+	float32 target_acmr = threshold * R3_AnalyzeVertexCache(indices, index_count, vertex_count, cache_size, NULL);
+
+	//------------------------------------------------------------------------
+	// Soft boundaries
+	uint32* splits = ArenaPushArray(scratch.arena, uint32, triangle_count + 1);
+	intz split_count = 0;
+	MeshoptCache_ cache = MeshoptMakeCache_(vertex_count, cache_size, scratch.arena);
+
+	for (intz c = 0; c < cluster_count; ++c)
+	{
+		intz begin = clusters[c];
+		intz end = (c+1 < cluster_count) ? clusters[c+1] : triangle_count;
+		intz misses = 0;
+		intz local_begin = begin;
+
+		splits[split_count++] = (uint32)begin;
+		MeshoptCacheFlush_(&cache);
+		for (intz t = begin; t < end; ++t)
+		{
+			misses += MeshoptCacheAccess_(&cache, indices[t*3 + 0]);
+			misses += MeshoptCacheAccess_(&cache, indices[t*3 + 1]);
+			misses += MeshoptCacheAccess_(&cache, indices[t*3 + 2]);
+
+			if (t+1 < end && (float32)misses <= target_acmr * (float32)(t+1 - local_begin))
+			{
+				splits[split_count++] = (uint32)(t+1);
+				local_begin = t+1;
+				misses = 0;
+				MeshoptCacheFlush_(&cache);
+			}
+		}
+	}
+	splits[split_count] = (uint32)triangle_count;
+
+	//------------------------------------------------------------------------
+	// Sort key of each cluster: how much it faces away from the mesh's centroid
+	float32 (*centroids)[3] = ArenaPushAligned(scratch.arena, sizeof(float32[3]) * split_count, 4);
+	float32 (*normals)[3] = ArenaPushAligned(scratch.arena, sizeof(float32[3]) * split_count, 4);
+	float32* keys = ArenaPushArray(scratch.arena, float32, split_count);
+	uint32* order = ArenaPushArray(scratch.arena, uint32, split_count);
+	float32 mesh_centroid[3] = {};
+	float32 mesh_area = 0.0f;
+
+	for (intz c = 0; c < split_count; ++c)
+	{
+		float32 normal[3] = {};
+		float32 centroid[3] = {};
+		float32 area = 0.0f;
+
+		for (intz t = splits[c]; t < splits[c+1]; ++t)
+		{
+			float32 const* a = MeshoptPosition_(vertices, vertex_stride, position_offset, indices[t*3 + 0]);
+			float32 const* b = MeshoptPosition_(vertices, vertex_stride, position_offset, indices[t*3 + 1]);
+			float32 const* d = MeshoptPosition_(vertices, vertex_stride, position_offset, indices[t*3 + 2]);
+			float32 ab[3] = { b[0]-a[0], b[1]-a[1], b[2]-a[2] };
+			float32 ad[3] = { d[0]-a[0], d[1]-a[1], d[2]-a[2] };
+			float32 cross[3] = {
+				ab[1]*ad[2] - ab[2]*ad[1],
+				ab[2]*ad[0] - ab[0]*ad[2],
+				ab[0]*ad[1] - ab[1]*ad[0],
+			};
+			// NOTE(ljre): |cross| is twice the area, which cancels out when we divide by the total
+			float32 tri_area = __builtin_sqrtf(cross[0]*cross[0] + cross[1]*cross[1] + cross[2]*cross[2]);
+
+			for (intz k = 0; k < 3; ++k)
+			{
+				normal[k] += cross[k];
+				centroid[k] += (a[k] + b[k] + d[k]) * (1.0f/3.0f) * tri_area;
+			}
+			area += tri_area;
+		}
+
+		float32 inv_area = (area > 0.0f) ? 1.0f / area : 0.0f;
+		float32 normal_len = __builtin_sqrtf(normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2]);
+		float32 inv_normal_len = (normal_len > 0.0f) ? 1.0f / normal_len : 0.0f;
+
+		for (intz k = 0; k < 3; ++k)
+		{
+			mesh_centroid[k] += centroid[k];
+			centroids[c][k] = centroid[k] * inv_area;
+			normals[c][k] = normal[k] * inv_normal_len;
+		}
+		mesh_area += area;
+		order[c] = (uint32)c;
+	}
+
+	if (mesh_area > 0.0f)
+	{
+		for (intz k = 0; k < 3; ++k)
+			mesh_centroid[k] /= mesh_area;
+	}
+
+	for (intz c = 0; c < split_count; ++c)
+	{
+		keys[c] =
+			(centroids[c][0] - mesh_centroid[0]) * normals[c][0] +
+			(centroids[c][1] - mesh_centroid[1]) * normals[c][1] +
+			(centroids[c][2] - mesh_centroid[2]) * normals[c][2];
+	}
+
+	MeshoptSortDescending_(order, split_count, keys, scratch.arena);
+
+	//------------------------------------------------------------------------
+	intz out = 0;
+	for (intz i = 0; i < split_count; ++i)
+	{
+		uint32 c = order[i];
+		intz count = (splits[c+1] - splits[c]) * 3;
+		MemoryCopy(dst + out, indices + splits[c]*3, sizeof(uint32) * count);
+		out += count;
+	}
+
+	SafeAssert(out == index_count);
+	ArenaRestore(scratch);
+}
+
+// NOTE(ljre): Reorders the vertices in the order they are first referenced by the index buffer and remaps the
+//             indices in place. Vertices that are never referenced are dropped. Returns the new vertex count.
+API intz
+R3_OptimizeVertexFetch(void* dst_vertices, uint32* indices, intz index_count, void const* vertices, intz vertex_count, uint32 vertex_stride)
+{
+	Trace();
+	SafeAssert(dst_vertices != vertices);
+
+	ArenaSavepoint scratch = ArenaSave(OS_ScratchArena(NULL, 0));
+	uint32* remap = ArenaPushArray(scratch.arena, uint32, vertex_count);
+	MemorySet(remap, 0xFF, sizeof(uint32) * vertex_count);
+
+	uint32 next = 0;
+	for (intz i = 0; i < index_count; ++i)
+	{
+		uint32 v = indices[i];
+		SafeAssert(v < (uint64)vertex_count);
+		if (remap[v] == UINT32_MAX)
+		{
+			MemoryCopy((uint8*)dst_vertices + (uintz)next*vertex_stride, (uint8 const*)vertices + (uintz)v*vertex_stride, vertex_stride);
+			remap[v] = next++;
+		}
+		indices[i] = remap[v];
+	}
+
+	ArenaRestore(scratch);
+	return next;
+}
+
+API R3_Format
+R3_CompactIndices(void* dst, uint32 const* indices, intz index_count)
+{
+	Trace();
+	uint32 max_index = 0;
+	for (intz i = 0; i < index_count; ++i)
+		max_index = Max(max_index, indices[i]);
+
+	if (max_index > UINT16_MAX)
+	{
+		if (dst != indices)
+			MemoryMove(dst, indices, sizeof(uint32) * index_count);
+		return R3_Format_U32x1;
+	}
+
+	// NOTE(ljre): Going forward is fine even if 'dst' aliases 'indices', since we always write behind what
+	//             we've already read.
+	uint16* dst16 = dst;
+	for (intz i = 0; i < index_count; ++i)
+		dst16[i] = (uint16)indices[i];
+	return R3_Format_U16x1;
+}
+
+API R3_MeshOptimizeStats
+R3_OptimizeMesh(R3_MeshOptimizeDesc const* desc)
+{
+	Trace();
+	R3_MeshOptimizeStats stats = {};
+	int32 cache_size = desc->cache_size ? desc->cache_size : 16;
+	intz index_count = desc->index_count;
+	intz vertex_count = desc->vertex_count;
+	uint32* indices = desc->indices;
+
+	stats.acmr_before = R3_AnalyzeVertexCache(indices, index_count, vertex_count, cache_size, &stats.atvr_before);
+	stats.vertex_count = vertex_count;
+
+	ArenaSavepoint scratch = ArenaSave(OS_ScratchArena(NULL, 0));
+	uint32* tmp_indices = ArenaPushArray(scratch.arena, uint32, index_count);
+
+	if (desc->flag_vertex_cache || desc->flag_overdraw)
+	{
+		uint32* clusters = ArenaPushArray(scratch.arena, uint32, index_count/3 + 1);
+		stats.cluster_count = R3_OptimizeVertexCache(tmp_indices, indices, index_count, vertex_count, cache_size, clusters);
+		MemoryCopy(indices, tmp_indices, sizeof(uint32) * index_count);
+
+		if (desc->flag_overdraw)
+		{
+			SafeAssert(desc->vertex_stride >= desc->position_offset + sizeof(float32[3]));
+			R3_OptimizeOverdraw(tmp_indices, indices, index_count, clusters, stats.cluster_count, desc->vertices, vertex_count, desc->vertex_stride, desc->position_offset, cache_size, desc->overdraw_threshold);
+			MemoryCopy(indices, tmp_indices, sizeof(uint32) * index_count);
+		}
+	}
+
+	if (desc->flag_vertex_fetch)
+	{
+		void* tmp_vertices = ArenaPushAligned(scratch.arena, (uintz)vertex_count * desc->vertex_stride, 16);
+		stats.vertex_count = R3_OptimizeVertexFetch(tmp_vertices, indices, index_count, desc->vertices, vertex_count, desc->vertex_stride);
+		MemoryCopy(desc->vertices, tmp_vertices, (uintz)stats.vertex_count * desc->vertex_stride);
+	}
+
+	ArenaRestore(scratch);
+	stats.acmr_after = R3_AnalyzeVertexCache(indices, index_count, stats.vertex_count, cache_size, &stats.atvr_after);
+
+	Log(LOG_INFO, "render3: mesh optimized: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, %ti clusters", stats.acmr_before, stats.acmr_after, stats.atvr_before, stats.atvr_after, stats.cluster_count);
+	return stats;
+}
@@ -0,0 +1,161 @@
+#include <base/base.h>
+#include <base/base_intrinsics.h>
+#include <base/base_assert.h>
+#include <base/base_arena.h>
+#include <layer_os/api.h>
+#include "api.h"
+
+struct R3_PipelineVariant_
+{
+	uint64 key;
+	bool used;
+	R3_Pipeline pipeline;
+}
+typedef R3_PipelineVariant_;
+
+static intz
+PermAppend_(uint8* out, intz at, String str)
+{
+	MemoryCopy(out + at, str.data, str.size);
+	return at + str.size;
+}
+
+static intz
+PermAppendUint_(uint8* out, intz at, uint64 value)
+{
+	uint8 digits[20];
+	intz count = 0;
+	do
+	{
+		digits[count++] = '0' + value % 10;
+		value /= 10;
+	}
+	while (value);
+
+	while (count)
+		out[at++] = digits[--count];
+	return at;
+}
+
+// NOTE(ljre): Builds one '#define NAME value' line per feature. Every feature is always defined, so shaders
+//             should test them with '#if NAME' rather than '#ifdef NAME'.
+static Buffer
+PermMakeDefines_(R3_PipelinePermutations const* perms, uint64 key, Arena* arena)
+{
+	intz size = 1;
+	for (int32 i = 0; i < perms->feature_count; ++i)
+		size += perms->features[i].name.size + 32;
+
+	uint8* out = ArenaPushArray(arena, uint8, size);
+	SafeAssert(out);
+
+	intz at = 0;
+	for (int32 i = 0; i < perms->feature_count; ++i)
+	{
+		R3_ShaderFeature const* feature = &perms->features[i];
+		uint64 value = key & ((1ull << feature->bits) - 1);
+		key >>= feature->bits;
+
+		at = PermAppend_(out, at, Str("#define "));
+		at = PermAppend_(out, at, feature->name);
+		out[at++] = ' ';
+		at = PermAppendUint_(out, at, value);
+		out[at++] = '\n';
+	}
+	out[at++] = 0;
+	SafeAssert(at <= size);
+
+	return (Buffer) { .data = out, .size = at };
+}
+
+//------------------------------------------------------------------------
+API R3_PipelinePermutations
+R3_MakePipelinePermutations(R3_Context* ctx, R3_PipelinePermutationsDesc const* desc)
+{
+	Trace();
+	R3_PipelinePermutations out = {};
+	SafeAssert(desc->arena);
+	SafeAssert(desc->feature_count >= 0 && desc->feature_count <= ArrayLength(desc->features));
+	SafeAssert(!desc->base.glsl.defines.size);
+
+	int32 key_bits = 0;
+	for (int32 i = 0; i < desc->feature_count; ++i)
+	{
+		SafeAssert(desc->features[i].bits >= 1 && desc->features[i].name.size > 0);
+		key_bits += desc->features[i].bits;
+	}
+	SafeAssert(key_bits < 64);
+
+	// NOTE(ljre): Keep the load factor at 50% at most.
+	uint32 capacity = 16;
+	while (capacity < desc->max_variants*2)
+		capacity <<= 1;
+
+	out.base = desc->base;
+	MemoryCopy(out.features, desc->features, sizeof(out.features));
+	out.feature_count = desc->feature_count;
+	out.key_bits = key_bits;
+	out.user_data = desc->user_data;
+	out.specialize = desc->specialize;
+	out.variant_capacity = capacity;
+	out.variants = ArenaPushArray(desc->arena, R3_PipelineVariant_, capacity);
+	SafeAssert(out.variants);
+	MemoryZero(out.variants, sizeof(R3_PipelineVariant_) * capacity);
+
+	return out;
+}
+
+API void
+R3_FreePipelinePermutations(R3_Context* ctx, R3_PipelinePermutations* perms)
+{
+	Trace();
+
+	for (uint32 i = 0; i < perms->variant_capacity; ++i)
+	{
+		if (perms->variants[i].used)
+			R3_FreePipeline(ctx, &perms->variants[i].pipeline);
+	}
+
+	*perms = (R3_PipelinePermutations) {};
+}
+
+API R3_Pipeline*
+R3_GetPipelineVariant(R3_Context* ctx, R3_PipelinePermutations* perms, uint64 key)
+{
+	Trace();
+	SafeAssert(key >> perms->key_bits == 0);
+
+	// NOTE(ljre): Fibonacci hashing, keys are usually small and dense.
+	uint64 hash = key * 0x9e3779b97f4a7c15ull;
+	uint32 mask = perms->variant_capacity - 1;
+	R3_PipelineVariant_* entry = NULL;
+	for (uint32 i = 0, at = (uint32)(hash >> 32) & mask; i < perms->variant_capacity; ++i, at = (at+1) & mask)
+	{
+		entry = &perms->variants[at];
+		if (!entry->used || entry->key == key)
+			break;
+	}
+	SafeAssert(entry);
+
+	if (entry->used && entry->key == key)
+	{
+		++perms->hits;
+		return &entry->pipeline;
+	}
+
+	SafeAssert(!entry->used && perms->variant_count*2 < perms->variant_capacity);
+	ArenaSavepoint scratch = ArenaSave(OS_ScratchArena(NULL, 0));
+
+	R3_PipelineDesc desc = perms->base;
+	desc.glsl.defines = PermMakeDefines_(perms, key, scratch.arena);
+	if (perms->specialize)
+		perms->specialize(perms->user_data, key, &desc);
+
+	entry->key = key;
+	entry->used = true;
+	entry->pipeline = R3_MakePipeline(ctx, &desc);
+	++perms->variant_count;
+
+	ArenaRestore(scratch);
+	return &entry->pipeline;
+}
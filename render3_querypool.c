@@ -0,0 +1,75 @@
+#include <base/base.h>
+#include <base/base_intrinsics.h>
+#include <base/base_assert.h>
+#include <base/base_arena.h>
+#include <layer_os/api.h>
+#include "api.h"
+
+//------------------------------------------------------------------------
+API R3_QueryPool
+R3_MakeQueryPool(R3_Context* ctx, R3_QueryPoolDesc const* desc)
+{
+	Trace();
+	R3_QueryPool out = {};
+	SafeAssert(desc->arena && desc->capacity > 0);
+
+	out.kind = desc->kind;
+	out.capacity = desc->capacity;
+	out.queries = ArenaPushArray(desc->arena, R3_Query, desc->capacity);
+	out.free_list = ArenaPushArray(desc->arena, int32, desc->capacity);
+	SafeAssert(out.queries && out.free_list);
+	MemoryZero(out.queries, sizeof(R3_Query) * desc->capacity);
+
+	return out;
+}
+
+API void
+R3_FreeQueryPool(R3_Context* ctx, R3_QueryPool* pool)
+{
+	Trace();
+
+	for (int32 i = 0; i < pool->made_count; ++i)
+		R3_FreeQuery(ctx, &pool->queries[i]);
+
+	*pool = (R3_QueryPool) {};
+}
+
+API R3_Query*
+R3_AcquirePooledQuery(R3_Context* ctx, R3_QueryPool* pool)
+{
+	Trace();
+
+	// NOTE(ljre): Recycle before making new ones, so the pool only grows as far as the latency requires.
+	if (pool->free_count > 0)
+		return &pool->queries[pool->free_list[--pool->free_count]];
+	if (pool->made_count < pool->capacity)
+	{
+		R3_Query* query = &pool->queries[pool->made_count++];
+		*query = R3_MakeQuery(ctx, pool->kind);
+		return query;
+	}
+
+	return NULL;
+}
+
+API void
+R3_ReleasePooledQuery(R3_Context* ctx, R3_QueryPool* pool, R3_Query* query)
+{
+	Trace();
+	intz index = query - pool->queries;
+	SafeAssert(index >= 0 && index < pool->made_count);
+	SafeAssert(pool->free_count < pool->made_count);
+
+	pool->free_list[pool->free_count++] = (int32)index;
+}
+
+API bool
+R3_PollPooledQuery(R3_Context* ctx, R3_QueryPool* pool, R3_Query* query, R3_QueryResult* out_result)
+{
+	Trace();
+	if (!R3_GetQueryResult(ctx, query, out_result))
+		return false;
+
+	R3_ReleasePooledQuery(ctx, pool, query);
+	return true;
+}
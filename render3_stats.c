@@ -0,0 +1,86 @@
+#include <base/base.h>
+#include <base/base_intrinsics.h>
+#include <base/base_assert.h>
+#include <base/base_arena.h>
+#include <layer_os/api.h>
+#include "api.h"
+
+static uint32
+StatsBitsPerPixel_(R3_Format format)
+{
+	switch (format)
+	{
+		case R3_Format_U8x1Norm:
+		case R3_Format_U8x1Norm_ToAlpha:
+		case R3_Format_U8x1:
+			return 8;
+		case R3_Format_U8x2Norm:
+		case R3_Format_U8x2:
+		case R3_Format_U16x1Norm:
+		case R3_Format_U16x1:
+		case R3_Format_D16:
+			return 16;
+		case R3_Format_U8x4Norm:
+		case R3_Format_U8x4Norm_Srgb:
+		case R3_Format_U8x4Norm_Bgrx:
+		case R3_Format_U8x4Norm_Bgra:
+		case R3_Format_U8x4:
+		case R3_Format_I16x2Norm:
+		case R3_Format_I16x2:
+		case R3_Format_U16x2Norm:
+		case R3_Format_U16x2:
+		case R3_Format_U32x1:
+		case R3_Format_F16x2:
+		case R3_Format_F32x1:
+		case R3_Format_D24S8:
+			return 32;
+		case R3_Format_I16x4Norm:
+		case R3_Format_I16x4:
+		case R3_Format_U16x4Norm:
+		case R3_Format_U16x4:
+		case R3_Format_U32x2:
+		case R3_Format_F16x4:
+		case R3_Format_F32x2:
+			return 64;
+		case R3_Format_F32x3:
+			return 96;
+		case R3_Format_U32x4:
+		case R3_Format_F32x4:
+			return 128;
+		case R3_Format_BC1:
+		case R3_Format_BC4:
+			return 4;
+		case R3_Format_BC2:
+		case R3_Format_BC3:
+		case R3_Format_BC5:
+		case R3_Format_BC6:
+		case R3_Format_BC7:
+			return 8;
+		case R3_Format_Null:
+		case R3_Format__Count:
+			break;
+	}
+	return 0;
+}
+
+//------------------------------------------------------------------------
+API uint64
+R3_EstimateTextureSize(R3_TextureDesc const* desc)
+{
+	Trace();
+	uint64 bits = StatsBitsPerPixel_(desc->format) * (uint64)ClampMin(desc->sample_count, 1);
+	int32 levels = 1;
+	if (desc->mipmap_count == -1)
+		levels = 1 + Bsr((uint32)Max(desc->width, desc->height));
+	else if (desc->mipmap_count > 0)
+		levels = desc->mipmap_count;
+
+	uint64 size = 0;
+	for (int32 i = 0; i < levels; ++i)
+	{
+		uint64 width = ClampMin(desc->width >> i, 1);
+		uint64 height = ClampMin(desc->height >> i, 1);
+		size += width * height * bits / 8;
+	}
+	return size * (uint64)ClampMin(desc->depth, 1);
+}
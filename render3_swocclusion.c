@@ -0,0 +1,628 @@
+#include <base/base.h>
+#include <base/base_intrinsics.h>
+#include <base/base_assert.h>
+#include <base/base_arena.h>
+#include <layer_os/api.h>
+#include "api.h"
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#   include <immintrin.h>
+#endif
+
+#define SWOCC_TILE_W_ 64
+#define SWOCC_TILE_H_ 32
+#define SWOCC_BLOCK_SIZE_ 8
+#define SWOCC_BLOCKS_X_ (SWOCC_TILE_W_ / SWOCC_BLOCK_SIZE_)
+#define SWOCC_BLOCKS_Y_ (SWOCC_TILE_H_ / SWOCC_BLOCK_SIZE_)
+#define SWOCC_BIN_CHUNK_SIZE_ 64
+
+struct R3_SwOcclusionTile_
+{
+	int32 first_chunk; // -1 if empty
+	int32 last_chunk;
+	int32 last_chunk_count;
+	uint64 ticks;
+};
+
+struct R3_SwOcclusionTriangle_
+{
+	// NOTE(ljre): Edge i goes from vertex i to vertex i+1. A pixel center p is inside the triangle if
+	//             'edge_a[i]*(p.x - x[i]) + edge_b[i]*(p.y - y[i]) >= 0' for all 3 edges, regardless of
+	//             winding.
+	float32 x[3], y[3];
+	float32 edge_a[3], edge_b[3];
+	float32 dzdx, dzdy, z0; // z(p) = z0 + dzdx*(p.x - x[0]) + dzdy*(p.y - y[0])
+	int32 min_x, min_y, max_x, max_y; // inclusive, clamped to the screen
+};
+
+//- SIMD
+// NOTE(ljre): Just enough of a vector type to rasterize rows and reduce Hi-Z blocks. The lane count always
+//             divides SWOCC_BLOCK_SIZE_, so tile rows never need a scalar tail.
+#if defined(__AVX2__)
+#define SWOCC_LANES_ 8
+typedef __m256 SwoccVec_;
+
+static inline SwoccVec_ SwoccSet1_(float32 x) { return _mm256_set1_ps(x); }
+static inline SwoccVec_ SwoccLaneOffsets_(void) { return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7); }
+static inline SwoccVec_ SwoccLoad_(float32 const* p) { return _mm256_load_ps(p); }
+static inline void SwoccStore_(float32* p, SwoccVec_ v) { _mm256_store_ps(p, v); }
+static inline SwoccVec_ SwoccAdd_(SwoccVec_ a, SwoccVec_ b) { return _mm256_add_ps(a, b); }
+static inline SwoccVec_ SwoccMul_(SwoccVec_ a, SwoccVec_ b) { return _mm256_mul_ps(a, b); }
+static inline SwoccVec_ SwoccMax_(SwoccVec_ a, SwoccVec_ b) { return _mm256_max_ps(a, b); }
+
+// NOTE(ljre): blendv only looks at the sign bit, so OR'ing the edge functions together gives us "any edge
+//             is negative" for free.
+static inline SwoccVec_
+SwoccDepthTest_(SwoccVec_ old, SwoccVec_ z, SwoccVec_ e0, SwoccVec_ e1, SwoccVec_ e2)
+{
+	SwoccVec_ outside = _mm256_or_ps(_mm256_or_ps(e0, e1), e2);
+	return _mm256_blendv_ps(_mm256_min_ps(old, z), old, outside);
+}
+
+static inline float32
+SwoccHorizontalMax_(SwoccVec_ v)
+{
+	__m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+	m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+	m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+	return _mm_cvtss_f32(m);
+}
+#elif defined(__SSE4_1__)
+#define SWOCC_LANES_ 4
+typedef __m128 SwoccVec_;
+
+static inline SwoccVec_ SwoccSet1_(float32 x) { return _mm_set1_ps(x); }
+static inline SwoccVec_ SwoccLaneOffsets_(void) { return _mm_setr_ps(0, 1, 2, 3); }
+static inline SwoccVec_ SwoccLoad_(float32 const* p) { return _mm_load_ps(p); }
+static inline void SwoccStore_(float32* p, SwoccVec_ v) { _mm_store_ps(p, v); }
+static inline SwoccVec_ SwoccAdd_(SwoccVec_ a, SwoccVec_ b) { return _mm_add_ps(a, b); }
+static inline SwoccVec_ SwoccMul_(SwoccVec_ a, SwoccVec_ b) { return _mm_mul_ps(a, b); }
+static inline SwoccVec_ SwoccMax_(SwoccVec_ a, SwoccVec_ b) { return _mm_max_ps(a, b); }
+
+static inline SwoccVec_
+SwoccDepthTest_(SwoccVec_ old, SwoccVec_ z, SwoccVec_ e0, SwoccVec_ e1, SwoccVec_ e2)
+{
+	SwoccVec_ outside = _mm_or_ps(_mm_or_ps(e0, e1), e2);
+	return _mm_blendv_ps(_mm_min_ps(old, z), old, outside);
+}
+
+static inline float32
+SwoccHorizontalMax_(SwoccVec_ v)
+{
+	v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+	v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+	return _mm_cvtss_f32(v);
+}
+#else
+#define SWOCC_LANES_ 1
+typedef float32 SwoccVec_;
+
+static inline SwoccVec_ SwoccSet1_(float32 x) { return x; }
+static inline SwoccVec_ SwoccLaneOffsets_(void) { return 0.0f; }
+static inline SwoccVec_ SwoccLoad_(float32 const* p) { return *p; }
+static inline void SwoccStore_(float32* p, SwoccVec_ v) { *p = v; }
+static inline SwoccVec_ SwoccAdd_(SwoccVec_ a, SwoccVec_ b) { return a + b; }
+static inline SwoccVec_ SwoccMul_(SwoccVec_ a, SwoccVec_ b) { return a * b; }
+static inline SwoccVec_ SwoccMax_(SwoccVec_ a, SwoccVec_ b) { return Max(a, b); }
+
+static inline SwoccVec_
+SwoccDepthTest_(SwoccVec_ old, SwoccVec_ z, SwoccVec_ e0, SwoccVec_ e1, SwoccVec_ e2)
+{
+	if (e0 < 0.0f || e1 < 0.0f || e2 < 0.0f)
+		return old;
+	return Min(old, z);
+}
+
+static inline float32 SwoccHorizontalMax_(SwoccVec_ v) { return v; }
+#endif
+
+//- Setup & binning
+static void
+SwoccMulMatrix_(float32 const a[4][4], float32 const b[4][4], float32 out[4][4])
+{
+	for (intz col = 0; col < 4; ++col)
+	{
+		for (intz row = 0; row < 4; ++row)
+		{
+			out[col][row] =
+				a[0][row] * b[col][0] +
+				a[1][row] * b[col][1] +
+				a[2][row] * b[col][2] +
+				a[3][row] * b[col][3];
+		}
+	}
+}
+
+static inline void
+SwoccTransform_(float32 const m[4][4], float32 const v[3], float32 out[4])
+{
+	for (intz row = 0; row < 4; ++row)
+		out[row] = m[0][row]*v[0] + m[1][row]*v[1] + m[2][row]*v[2] + m[3][row];
+}
+
+// NOTE(ljre): Bit i set means the vertex is outside of plane i. Planes are -x, +x, -y, +y, near, far.
+static inline uint32
+SwoccOutcode_(float32 const clip[4], bool zero_to_one_depth)
+{
+	float32 w = clip[3];
+	float32 near = zero_to_one_depth ? 0.0f : -w;
+	return (clip[0] < -w) << 0 | (clip[0] > w) << 1
+		| (clip[1] < -w) << 2 | (clip[1] > w) << 3
+		| (clip[2] < near) << 4 | (clip[2] > w) << 5;
+}
+
+static inline void
+SwoccToScreen_(R3_SwOcclusion const* occ, float32 const clip[4], float32* out_x, float32* out_y, float32* out_z)
+{
+	float32 inv_w = 1.0f / clip[3];
+	float32 z = clip[2] * inv_w;
+
+	*out_x = (clip[0] * inv_w * 0.5f + 0.5f) * (float32)occ->width;
+	*out_y = (0.5f - clip[1] * inv_w * 0.5f) * (float32)occ->height;
+	*out_z = occ->zero_to_one_depth ? z : z * 0.5f + 0.5f;
+}
+
+static bool
+SwoccBinTriangle_(R3_SwOcclusion* occ, R3_SwOcclusionTriangle_ const* tri, uint32 tri_index)
+{
+	int32 tile_x0 = tri->min_x / SWOCC_TILE_W_;
+	int32 tile_x1 = tri->max_x / SWOCC_TILE_W_;
+	int32 tile_y0 = tri->min_y / SWOCC_TILE_H_;
+	int32 tile_y1 = tri->max_y / SWOCC_TILE_H_;
+
+	for (int32 ty = tile_y0; ty <= tile_y1; ++ty)
+	{
+		for (int32 tx = tile_x0; tx <= tile_x1; ++tx)
+		{
+			R3_SwOcclusionTile_* tile = &occ->tiles[ty * occ->tiles_x + tx];
+			if (tile->first_chunk == -1 || tile->last_chunk_count == SWOCC_BIN_CHUNK_SIZE_)
+			{
+				// NOTE(ljre): Out of chunks. A triangle missing from some of its tiles only makes occlusion
+				//             weaker, never wrong, so just stop here.
+				if (occ->bin_chunk_count >= occ->max_bin_chunks)
+					return false;
+
+				int32 chunk = occ->bin_chunk_count++;
+				occ->bin_chunk_next[chunk] = -1;
+				if (tile->first_chunk == -1)
+					tile->first_chunk = chunk;
+				else
+					occ->bin_chunk_next[tile->last_chunk] = chunk;
+				tile->last_chunk = chunk;
+				tile->last_chunk_count = 0;
+			}
+
+			occ->bin_chunks[tile->last_chunk * SWOCC_BIN_CHUNK_SIZE_ + tile->last_chunk_count++] = tri_index;
+		}
+	}
+
+	return true;
+}
+
+static void
+SwoccSetupTriangle_(R3_SwOcclusion* occ, float32 const clip[3][4])
+{
+	R3_SwOcclusionTriangle_ tri;
+	float32 z[3];
+	float32 min_x = FLT_MAX, min_y = FLT_MAX;
+	float32 max_x = -FLT_MAX, max_y = -FLT_MAX;
+
+	for (intz i = 0; i < 3; ++i)
+	{
+		SwoccToScreen_(occ, clip[i], &tri.x[i], &tri.y[i], &z[i]);
+		min_x = Min(min_x, tri.x[i]);
+		min_y = Min(min_y, tri.y[i]);
+		max_x = Max(max_x, tri.x[i]);
+		max_y = Max(max_y, tri.y[i]);
+	}
+
+	if (max_x < 0.0f || max_y < 0.0f || min_x >= (float32)occ->width || min_y >= (float32)occ->height)
+		return;
+
+	float32 area = (tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) - (tri.x[2] - tri.x[0]) * (tri.y[1] - tri.y[0]);
+	if (area > -1e-6f && area < 1e-6f)
+		return;
+
+	// NOTE(ljre): Flip the edges of clockwise triangles so that "inside" is always positive.
+	float32 sign = (area > 0.0f) ? -1.0f : 1.0f;
+	for (intz i = 0; i < 3; ++i)
+	{
+		intz next = (i + 1) % 3;
+		tri.edge_a[i] = sign * (tri.y[next] - tri.y[i]);
+		tri.edge_b[i] = sign * (tri.x[i] - tri.x[next]);
+	}
+
+	float32 inv_area = 1.0f / area;
+	tri.dzdx = ((z[1] - z[0]) * (tri.y[2] - tri.y[0]) - (z[2] - z[0]) * (tri.y[1] - tri.y[0])) * inv_area;
+	tri.dzdy = ((z[2] - z[0]) * (tri.x[1] - tri.x[0]) - (z[1] - z[0]) * (tri.x[2] - tri.x[0])) * inv_area;
+	tri.z0 = z[0];
+
+	// NOTE(ljre): Clamp before converting so that huge guard band coordinates don't overflow.
+	tri.min_x = (int32)ClampMax(ClampMin(min_x, 0.0f), (float32)(occ->width - 1));
+	tri.min_y = (int32)ClampMax(ClampMin(min_y, 0.0f), (float32)(occ->height - 1));
+	tri.max_x = (int32)ClampMax(ClampMin(max_x, 0.0f), (float32)(occ->width - 1));
+	tri.max_y = (int32)ClampMax(ClampMin(max_y, 0.0f), (float32)(occ->height - 1));
+
+	++occ->stats.rasterized_triangles;
+	if (occ->triangle_count >= occ->max_triangles)
+	{
+		++occ->stats.dropped_triangles;
+		return;
+	}
+
+	uint32 tri_index = (uint32)occ->triangle_count++;
+	occ->triangles[tri_index] = tri;
+	if (!SwoccBinTriangle_(occ, &tri, tri_index))
+		++occ->stats.dropped_triangles;
+}
+
+// NOTE(ljre): Sutherland-Hodgman against the near plane only. Everything else is handled by the guard band
+//             and by clamping the bounding box.
+static void
+SwoccClipAndSetup_(R3_SwOcclusion* occ, float32 const clip[3][4])
+{
+	float32 dist[3];
+	bool all_inside = true;
+	for (intz i = 0; i < 3; ++i)
+	{
+		dist[i] = occ->zero_to_one_depth ? clip[i][2] : clip[i][2] + clip[i][3];
+		all_inside = all_inside && dist[i] >= 0.0f;
+	}
+
+	if (all_inside)
+	{
+		if (clip[0][3] > 0.0f && clip[1][3] > 0.0f && clip[2][3] > 0.0f)
+			SwoccSetupTriangle_(occ, clip);
+		return;
+	}
+
+	float32 poly[4][4];
+	intz poly_count = 0;
+	for (intz i = 0; i < 3; ++i)
+	{
+		intz next = (i + 1) % 3;
+		if (dist[i] >= 0.0f)
+			MemoryCopy(poly[poly_count++], clip[i], sizeof(float32[4]));
+		if ((dist[i] >= 0.0f) != (dist[next] >= 0.0f))
+		{
+			float32 t = dist[i] / (dist[i] - dist[next]);
+			for (intz j = 0; j < 4; ++j)
+				poly[poly_count][j] = clip[i][j] + (clip[next][j] - clip[i][j]) * t;
+			++poly_count;
+		}
+	}
+
+	for (intz i = 2; i < poly_count; ++i)
+	{
+		float32 fan[3][4];
+		MemoryCopy(fan[0], poly[0], sizeof(float32[4]));
+		MemoryCopy(fan[1], poly[i-1], sizeof(float32[4]));
+		MemoryCopy(fan[2], poly[i], sizeof(float32[4]));
+		if (fan[0][3] > 0.0f && fan[1][3] > 0.0f && fan[2][3] > 0.0f)
+			SwoccSetupTriangle_(occ, fan);
+	}
+}
+
+//- Rasterization
+static void
+SwoccRasterizeTriangle_(R3_SwOcclusionTriangle_ const* tri, float32* tile_depth, int32 tile_x, int32 tile_y)
+{
+	int32 x0 = Max(tri->min_x - tile_x, 0);
+	int32 y0 = Max(tri->min_y - tile_y, 0);
+	int32 x1 = Min(tri->max_x - tile_x, SWOCC_TILE_W_-1);
+	int32 y1 = Min(tri->max_y - tile_y, SWOCC_TILE_H_-1);
+	if (x0 > x1 || y0 > y1)
+		return;
+	x0 &= ~(SWOCC_LANES_-1);
+
+	SwoccVec_ lanes = SwoccLaneOffsets_();
+	SwoccVec_ a[3], step[3];
+	for (intz i = 0; i < 3; ++i)
+	{
+		a[i] = SwoccSet1_(tri->edge_a[i]);
+		step[i] = SwoccSet1_(tri->edge_a[i] * SWOCC_LANES_);
+	}
+	SwoccVec_ dzdx = SwoccSet1_(tri->dzdx);
+	SwoccVec_ zstep = SwoccSet1_(tri->dzdx * SWOCC_LANES_);
+
+	// NOTE(ljre): Evaluate everything relative to the vertices rather than to the screen origin, which keeps
+	//             the magnitudes (and so the float error) down.
+	float32 px = (float32)(tile_x + x0) + 0.5f;
+	for (int32 y = y0; y <= y1; ++y)
+	{
+		float32 py = (float32)(tile_y + y) + 0.5f;
+		SwoccVec_ e[3];
+		for (intz i = 0; i < 3; ++i)
+		{
+			float32 base = tri->edge_a[i] * (px - tri->x[i]) + tri->edge_b[i] * (py - tri->y[i]);
+			e[i] = SwoccAdd_(SwoccSet1_(base), SwoccMul_(a[i], lanes));
+		}
+		float32 zbase = tri->z0 + tri->dzdx * (px - tri->x[0]) + tri->dzdy * (py - tri->y[0]);
+		SwoccVec_ z = SwoccAdd_(SwoccSet1_(zbase), SwoccMul_(dzdx, lanes));
+
+		float32* row = tile_depth + y * SWOCC_TILE_W_;
+		for (int32 x = x0; x <= x1; x += SWOCC_LANES_)
+		{
+			SwoccStore_(row + x, SwoccDepthTest_(SwoccLoad_(row + x), z, e[0], e[1], e[2]));
+			e[0] = SwoccAdd_(e[0], step[0]);
+			e[1] = SwoccAdd_(e[1], step[1]);
+			e[2] = SwoccAdd_(e[2], step[2]);
+			z = SwoccAdd_(z, zstep);
+		}
+	}
+}
+
+static void
+SwoccBuildHiz_(float32 const* tile_depth, float32* tile_hiz)
+{
+	for (intz by = 0; by < SWOCC_BLOCKS_Y_; ++by)
+	{
+		for (intz bx = 0; bx < SWOCC_BLOCKS_X_; ++bx)
+		{
+			float32 const* block = tile_depth + by * SWOCC_BLOCK_SIZE_ * SWOCC_TILE_W_ + bx * SWOCC_BLOCK_SIZE_;
+			SwoccVec_ farthest = SwoccSet1_(0.0f);
+			for (intz y = 0; y < SWOCC_BLOCK_SIZE_; ++y)
+			{
+				for (intz x = 0; x < SWOCC_BLOCK_SIZE_; x += SWOCC_LANES_)
+					farthest = SwoccMax_(farthest, SwoccLoad_(block + y * SWOCC_TILE_W_ + x));
+			}
+			tile_hiz[by * SWOCC_BLOCKS_X_ + bx] = SwoccHorizontalMax_(farthest);
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+API R3_SwOcclusion
+R3_MakeSwOcclusion(R3_SwOcclusionDesc const* desc)
+{
+	Trace();
+	SafeAssert(desc->width > 0 && desc->height > 0 && desc->arena);
+	R3_SwOcclusion out = {};
+
+	out.width = desc->width;
+	out.height = desc->height;
+	out.tiles_x = (desc->width + SWOCC_TILE_W_-1) / SWOCC_TILE_W_;
+	out.tiles_y = (desc->height + SWOCC_TILE_H_-1) / SWOCC_TILE_H_;
+	out.tile_count = out.tiles_x * out.tiles_y;
+	out.max_triangles = desc->max_triangles ? desc->max_triangles : 8192;
+	// NOTE(ljre): Enough for every triangle to touch ~4 tiles, plus a partially filled chunk per tile.
+	out.max_bin_chunks = out.tile_count + out.max_triangles * 4 / SWOCC_BIN_CHUNK_SIZE_;
+
+	intz pixel_count = (intz)out.tile_count * SWOCC_TILE_W_ * SWOCC_TILE_H_;
+	intz block_count = (intz)out.tile_count * SWOCC_BLOCKS_X_ * SWOCC_BLOCKS_Y_;
+	out.triangles = ArenaPushArray(desc->arena, R3_SwOcclusionTriangle_, out.max_triangles);
+	out.bin_chunk_next = ArenaPushArray(desc->arena, int32, out.max_bin_chunks);
+	out.bin_chunks = ArenaPushArray(desc->arena, uint32, (intz)out.max_bin_chunks * SWOCC_BIN_CHUNK_SIZE_);
+	out.tiles = ArenaPushArray(desc->arena, R3_SwOcclusionTile_, out.tile_count);
+	out.depth = ArenaPushAligned(desc->arena, sizeof(float32) * pixel_count, 64);
+	out.hiz = ArenaPushAligned(desc->arena, sizeof(float32) * block_count, 64);
+
+	MemoryZero(out.tiles, sizeof(R3_SwOcclusionTile_) * out.tile_count);
+	for (intz i = 0; i < pixel_count; ++i)
+		out.depth[i] = 1.0f;
+	for (intz i = 0; i < block_count; ++i)
+		out.hiz[i] = 1.0f;
+	for (intz i = 0; i < out.tile_count; ++i)
+		out.tiles[i].first_chunk = -1;
+
+	return out;
+}
+
+API void
+R3_SwOcclusionBegin(R3_SwOcclusion* occ, float32 const view_proj[4][4], bool zero_to_one_depth)
+{
+	Trace();
+	MemoryCopy(occ->view_proj, view_proj, sizeof(occ->view_proj));
+	occ->zero_to_one_depth = zero_to_one_depth;
+	occ->triangle_count = 0;
+	occ->bin_chunk_count = 0;
+	for (intz i = 0; i < occ->tile_count; ++i)
+		occ->tiles[i].first_chunk = -1;
+}
+
+API void
+R3_SwOcclusionAddOccluder(R3_SwOcclusion* occ, void const* positions, intz vertex_count, uint32 stride, uint32 const* indices, intz index_count, float32 const model[4][4])
+{
+	Trace();
+	SafeAssert(index_count % 3 == 0);
+	occ->stats.occluder_triangles += index_count / 3;
+
+	float32 mvp[4][4];
+	if (model)
+		SwoccMulMatrix_(occ->view_proj, model, mvp);
+	else
+		MemoryCopy(mvp, occ->view_proj, sizeof(mvp));
+
+	ArenaSavepoint scratch = ArenaSave(OS_ScratchArena(NULL, 0));
+	float32 (*clip)[4] = (float32 (*)[4])ArenaPushArray(scratch.arena, float32, vertex_count * 4);
+	uint8* outcodes = ArenaPushArray(scratch.arena, uint8, vertex_count);
+	for (intz i = 0; i < vertex_count; ++i)
+	{
+		float32 const* pos = (float32 const*)((uint8 const*)positions + i * stride);
+		SwoccTransform_(mvp, pos, clip[i]);
+		outcodes[i] = (uint8)SwoccOutcode_(clip[i], occ->zero_to_one_depth);
+	}
+
+	for (intz i = 0; i < index_count; i += 3)
+	{
+		uint32 i0 = indices[i+0], i1 = indices[i+1], i2 = indices[i+2];
+		SafeAssert(i0 < (uint64)vertex_count && i1 < (uint64)vertex_count && i2 < (uint64)vertex_count);
+		if (outcodes[i0] & outcodes[i1] & outcodes[i2])
+			continue;
+
+		float32 tri[3][4];
+		MemoryCopy(tri[0], clip[i0], sizeof(float32[4]));
+		MemoryCopy(tri[1], clip[i1], sizeof(float32[4]));
+		MemoryCopy(tri[2], clip[i2], sizeof(float32[4]));
+		SwoccClipAndSetup_(occ, tri);
+	}
+
+	ArenaRestore(scratch);
+}
+
+API void
+R3_SwOcclusionRasterizeTile(R3_SwOcclusion* occ, int32 tile_index)
+{
+	Trace();
+	SafeAssert(tile_index >= 0 && tile_index < occ->tile_count);
+	uint64 begin = OS_CurrentTick();
+
+	R3_SwOcclusionTile_* tile = &occ->tiles[tile_index];
+	float32* tile_depth = occ->depth + (intz)tile_index * SWOCC_TILE_W_ * SWOCC_TILE_H_;
+	float32* tile_hiz = occ->hiz + (intz)tile_index * SWOCC_BLOCKS_X_ * SWOCC_BLOCKS_Y_;
+	int32 tile_x = (tile_index % occ->tiles_x) * SWOCC_TILE_W_;
+	int32 tile_y = (tile_index / occ->tiles_x) * SWOCC_TILE_H_;
+
+	SwoccVec_ far = SwoccSet1_(1.0f);
+	for (intz i = 0; i < SWOCC_TILE_W_ * SWOCC_TILE_H_; i += SWOCC_LANES_)
+		SwoccStore_(tile_depth + i, far);
+
+	for (int32 chunk = tile->first_chunk; chunk != -1; chunk = occ->bin_chunk_next[chunk])
+	{
+		int32 count = (chunk == tile->last_chunk) ? tile->last_chunk_count : SWOCC_BIN_CHUNK_SIZE_;
+		uint32 const* entries = occ->bin_chunks + chunk * SWOCC_BIN_CHUNK_SIZE_;
+		for (int32 i = 0; i < count; ++i)
+			SwoccRasterizeTriangle_(&occ->triangles[entries[i]], tile_depth, tile_x, tile_y);
+	}
+
+	SwoccBuildHiz_(tile_depth, tile_hiz);
+	tile->ticks += OS_CurrentTick() - begin;
+}
+
+API void
+R3_SwOcclusionRasterize(R3_SwOcclusion* occ)
+{
+	Trace();
+	for (int32 i = 0; i < occ->tile_count; ++i)
+		R3_SwOcclusionRasterizeTile(occ, i);
+}
+
+API float32
+R3_SwOcclusionDepthAt(R3_SwOcclusion const* occ, int32 x, int32 y)
+{
+	SafeAssert(x >= 0 && x < occ->width && y >= 0 && y < occ->height);
+	intz tile_index = (y / SWOCC_TILE_H_) * occ->tiles_x + x / SWOCC_TILE_W_;
+	intz offset = (y % SWOCC_TILE_H_) * SWOCC_TILE_W_ + x % SWOCC_TILE_W_;
+	return occ->depth[tile_index * SWOCC_TILE_W_ * SWOCC_TILE_H_ + offset];
+}
+
+API bool
+R3_SwOcclusionTestAabb(R3_SwOcclusion* occ, float32 const aabb_min[3], float32 const aabb_max[3])
+{
+	Trace();
+	++occ->stats.tested_objects;
+
+	float32 min_x = FLT_MAX, min_y = FLT_MAX, min_z = FLT_MAX;
+	float32 max_x = -FLT_MAX, max_y = -FLT_MAX;
+	uint32 outcode_and = ~0u;
+	bool crosses_near = false;
+
+	for (intz i = 0; i < 8; ++i)
+	{
+		float32 corner[3] = {
+			(i & 1) ? aabb_max[0] : aabb_min[0],
+			(i & 2) ? aabb_max[1] : aabb_min[1],
+			(i & 4) ? aabb_max[2] : aabb_min[2],
+		};
+		float32 clip[4];
+		SwoccTransform_(occ->view_proj, corner, clip);
+
+		uint32 outcode = SwoccOutcode_(clip, occ->zero_to_one_depth);
+		outcode_and &= outcode;
+		if ((outcode & 0x10) || clip[3] <= 0.0f)
+		{
+			crosses_near = true;
+			continue;
+		}
+
+		float32 x, y, z;
+		SwoccToScreen_(occ, clip, &x, &y, &z);
+		min_x = Min(min_x, x);
+		min_y = Min(min_y, y);
+		min_z = Min(min_z, z);
+		max_x = Max(max_x, x);
+		max_y = Max(max_y, y);
+	}
+
+	if (outcode_and)
+	{
+		++occ->stats.frustum_culled_objects;
+		return false;
+	}
+	// NOTE(ljre): We're probably inside of it or very close to it, it's not worth clipping.
+	if (crosses_near)
+		return true;
+	if (max_x < 0.0f || max_y < 0.0f || min_x >= (float32)occ->width || min_y >= (float32)occ->height)
+		return true;
+
+	int32 x0 = (int32)ClampMin(min_x, 0.0f);
+	int32 y0 = (int32)ClampMin(min_y, 0.0f);
+	int32 x1 = (int32)ClampMax(max_x, (float32)(occ->width - 1));
+	int32 y1 = (int32)ClampMax(max_y, (float32)(occ->height - 1));
+
+	// NOTE(ljre): Hi-Z first, then look at the actual pixels of the blocks that didn't reject the box.
+	for (int32 by = y0 / SWOCC_BLOCK_SIZE_; by <= y1 / SWOCC_BLOCK_SIZE_; ++by)
+	{
+		for (int32 bx = x0 / SWOCC_BLOCK_SIZE_; bx <= x1 / SWOCC_BLOCK_SIZE_; ++bx)
+		{
+			intz tile_index = (by / SWOCC_BLOCKS_Y_) * occ->tiles_x + bx / SWOCC_BLOCKS_X_;
+			intz block_index = (by % SWOCC_BLOCKS_Y_) * SWOCC_BLOCKS_X_ + bx % SWOCC_BLOCKS_X_;
+			if (occ->hiz[tile_index * SWOCC_BLOCKS_X_ * SWOCC_BLOCKS_Y_ + block_index] < min_z)
+				continue;
+
+			int32 px0 = Max(x0, bx * SWOCC_BLOCK_SIZE_);
+			int32 py0 = Max(y0, by * SWOCC_BLOCK_SIZE_);
+			int32 px1 = Min(x1, bx * SWOCC_BLOCK_SIZE_ + SWOCC_BLOCK_SIZE_-1);
+			int32 py1 = Min(y1, by * SWOCC_BLOCK_SIZE_ + SWOCC_BLOCK_SIZE_-1);
+			for (int32 py = py0; py <= py1; ++py)
+			{
+				for (int32 px = px0; px <= px1; ++px)
+				{
+					if (R3_SwOcclusionDepthAt(occ, px, py) >= min_z)
+						return true;
+				}
+			}
+		}
+	}
+
+	++occ->stats.occlusion_culled_objects;
+	return false;
+}
+
+API bool
+R3_SwOcclusionDrawIndexed(R3_Context* ctx, R3_SwOcclusion* occ, float32 const aabb_min[3], float32 const aabb_max[3], uint32 start_index, uint32 index_count, uint32 start_instance, uint32 instance_count, int32 base_vertex)
+{
+	Trace();
+	if (!R3_SwOcclusionTestAabb(occ, aabb_min, aabb_max))
+		return false;
+
+	R3_DrawIndexed(ctx, start_index, index_count, start_instance, instance_count, base_vertex);
+	return true;
+}
+
+API R3_SwOcclusionStats
+R3_SwOcclusionTakeStats(R3_SwOcclusion* occ)
+{
+	Trace();
+	R3_SwOcclusionStats stats = occ->stats;
+
+	for (intz i = 0; i < occ->tile_count; ++i)
+	{
+		stats.rasterize_ticks += occ->tiles[i].ticks;
+		occ->tiles[i].ticks = 0;
+	}
+
+	if (stats.rasterize_ticks)
+	{
+		float64 ms = (float64)stats.rasterize_ticks * 1000.0 / (float64)OS_TickRate();
+		stats.triangles_per_ms = (float64)stats.rasterized_triangles / ms;
+	}
+	if (stats.tested_objects)
+	{
+		uint64 culled = stats.frustum_culled_objects + stats.occlusion_culled_objects;
+		stats.culled_ratio = (float64)culled / (float64)stats.tested_objects;
+	}
+
+	occ->stats = (R3_SwOcclusionStats) {};
+	return stats;
+}
@@ -0,0 +1,239 @@
+#include <base/base.h>
+#include <base/base_intrinsics.h>
+#include <base/base_assert.h>
+#include <base/base_string.h>
+#include <base/base_arena.h>
+#include <layer_os/api.h>
+#include "api.h"
+
+// NOTE(ljre): 0 is the GPU track, CPU threads get their id the first time they push an event.
+static uint32 g_timeline_thread_count;
+static _Thread_local uint32 tls_timeline_thread;
+
+static uint32
+TimelineThreadId_(void)
+{
+	if (!tls_timeline_thread)
+		tls_timeline_thread = __atomic_add_fetch(&g_timeline_thread_count, 1, __ATOMIC_RELAXED);
+	return tls_timeline_thread;
+}
+
+struct TimelineWriter_
+{
+	uint8* data;
+	uintz size;
+	uintz capacity;
+}
+typedef TimelineWriter_;
+
+static void
+TimelineWrite_(TimelineWriter_* w, String str)
+{
+	SafeAssert(w->size + str.size <= w->capacity);
+	MemoryCopy(w->data + w->size, str.data, str.size);
+	w->size += str.size;
+}
+
+static void
+TimelineWriteUint_(TimelineWriter_* w, uint64 value)
+{
+	uint8 digits[20];
+	intz count = 0;
+	do
+		digits[count++] = '0' + value % 10;
+	while (value /= 10);
+
+	SafeAssert(w->size + count <= w->capacity);
+	while (count > 0)
+		w->data[w->size++] = digits[--count];
+}
+
+// NOTE(ljre): Chrome wants microseconds. Keep nanosecond precision as 3 decimal places.
+static void
+TimelineWriteMicroseconds_(TimelineWriter_* w, uint64 ticks, uint64 tick_rate)
+{
+	uint64 ns = ticks / tick_rate * 1000000000ull + ticks % tick_rate * 1000000000ull / tick_rate;
+	TimelineWriteUint_(w, ns / 1000);
+	TimelineWrite_(w, Str("."));
+	uint64 frac = ns % 1000;
+	uint8 decimals[3] = { '0' + frac / 100, '0' + frac / 10 % 10, '0' + frac % 10 };
+	TimelineWrite_(w, (String) { .data = decimals, .size = 3 });
+}
+
+static void
+TimelineWriteJsonString_(TimelineWriter_* w, String str)
+{
+	static char const hex[] = "0123456789abcdef";
+	TimelineWrite_(w, Str("\""));
+	for (intz i = 0; i < str.size; ++i)
+	{
+		uint8 c = str.data[i];
+		if (c == '"' || c == '\\')
+		{
+			uint8 escaped[2] = { '\\', c };
+			TimelineWrite_(w, (String) { .data = escaped, .size = 2 });
+		}
+		else if (c < 0x20)
+		{
+			uint8 escaped[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+			TimelineWrite_(w, (String) { .data = escaped, .size = 6 });
+		}
+		else
+			TimelineWrite_(w, (String) { .data = &c, .size = 1 });
+	}
+	TimelineWrite_(w, Str("\""));
+}
+
+//------------------------------------------------------------------------
+API R3_Timeline
+R3_MakeTimeline(R3_TimelineDesc const* desc)
+{
+	Trace();
+	R3_Timeline out = {};
+	SafeAssert(desc->arena);
+
+	uint64 capacity = 1024;
+	while (capacity < (uint64)desc->max_events)
+		capacity <<= 1;
+	out.events = ArenaPushArray(desc->arena, R3_TimelineEvent, capacity);
+	SafeAssert(out.events);
+	MemoryZero(out.events, sizeof(R3_TimelineEvent) * capacity);
+	out.mask = capacity - 1;
+	out.enabled = desc->enabled;
+
+	return out;
+}
+
+API void
+R3_SetTimelineEnabled(R3_Timeline* timeline, bool enabled)
+{
+	Trace();
+	__atomic_store_n(&timeline->enabled, enabled, __ATOMIC_RELAXED);
+}
+
+API uint64
+R3_TimelineBegin(R3_Timeline* timeline)
+{
+	if (!timeline || !__atomic_load_n(&timeline->enabled, __ATOMIC_RELAXED))
+		return 0;
+	return OS_CurrentTick();
+}
+
+API void
+R3_TimelineEnd(R3_Timeline* timeline, R3_TimelineKind kind, String name, uint64 begin_tick, uint64 bytes)
+{
+	if (!begin_tick)
+		return;
+	R3_PushTimelineEvent(timeline, kind, name, begin_tick, OS_CurrentTick(), bytes);
+}
+
+// NOTE(ljre): Multiple producers, and the exporter as a reader. A slot's 'sequence' is zeroed while it's
+//             written and set to its index + 1 once it's done, so readers can tell finished events from ones
+//             in progress or overwritten under them (seqlock style).
+API void
+R3_PushTimelineEvent(R3_Timeline* timeline, R3_TimelineKind kind, String name, uint64 begin_tick, uint64 end_tick, uint64 bytes)
+{
+	if (!timeline || !__atomic_load_n(&timeline->enabled, __ATOMIC_RELAXED))
+		return;
+
+	uint64 index = __atomic_fetch_add(&timeline->head, 1, __ATOMIC_RELAXED);
+	R3_TimelineEvent* event = &timeline->events[index & timeline->mask];
+	__atomic_store_n(&event->sequence, 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	event->name = name;
+	event->begin_tick = begin_tick;
+	event->end_tick = end_tick;
+	event->bytes = bytes;
+	event->kind = kind;
+	event->thread = (kind == R3_TimelineKind_Gpu) ? 0 : TimelineThreadId_();
+
+	__atomic_store_n(&event->sequence, index + 1, __ATOMIC_RELEASE);
+}
+
+API String
+R3_ExportTimelineJson(R3_Timeline* timeline, Arena* output_arena)
+{
+	Trace();
+	ArenaSavepoint scratch = ArenaSave(OS_ScratchArena(&output_arena, 1));
+
+	// NOTE(ljre): Copy the events out first, dropping anything that was being written or got overwritten.
+	uint64 head = __atomic_load_n(&timeline->head, __ATOMIC_ACQUIRE);
+	uint64 capacity = timeline->mask + 1;
+	uint64 first = (head > capacity) ? head - capacity : 0;
+	R3_TimelineEvent* events = ArenaPushArray(scratch.arena, R3_TimelineEvent, head - first);
+	SafeAssert(events || head == first);
+	intz count = 0;
+	uintz max_size = 256;
+	for (uint64 i = first; i < head; ++i)
+	{
+		R3_TimelineEvent* slot = &timeline->events[i & timeline->mask];
+		if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != i + 1)
+			continue;
+		R3_TimelineEvent event = *slot;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) != i + 1)
+			continue;
+
+		events[count++] = event;
+		max_size += 192 + event.name.size * 6;
+	}
+
+	uint32 thread_count = __atomic_load_n(&g_timeline_thread_count, __ATOMIC_RELAXED);
+	max_size += (thread_count + 1) * 96;
+
+	TimelineWriter_ w = {
+		.data = ArenaPushArray(output_arena, uint8, max_size),
+		.capacity = max_size,
+	};
+	SafeAssert(w.data);
+
+	static String const categories[R3_TimelineKind__Count] = {
+		[R3_TimelineKind_Cpu] = StrInit("cpu"),
+		[R3_TimelineKind_Gpu] = StrInit("gpu"),
+		[R3_TimelineKind_Upload] = StrInit("upload"),
+		[R3_TimelineKind_Present] = StrInit("present"),
+	};
+	uint64 tick_rate = OS_TickRate();
+	uint64 origin = (count > 0) ? events[0].begin_tick : 0;
+	for (intz i = 1; i < count; ++i)
+		origin = Min(origin, events[i].begin_tick);
+
+	TimelineWrite_(&w, Str("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"));
+	TimelineWrite_(&w, Str("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}"));
+	for (uint32 i = 1; i <= thread_count; ++i)
+	{
+		TimelineWrite_(&w, Str(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"));
+		TimelineWriteUint_(&w, i);
+		TimelineWrite_(&w, Str(",\"args\":{\"name\":\"CPU "));
+		TimelineWriteUint_(&w, i);
+		TimelineWrite_(&w, Str("\"}}"));
+	}
+	for (intz i = 0; i < count; ++i)
+	{
+		R3_TimelineEvent const* event = &events[i];
+		uint64 end = Max(event->end_tick, event->begin_tick);
+
+		TimelineWrite_(&w, Str(",\n{\"name\":"));
+		TimelineWriteJsonString_(&w, event->name);
+		TimelineWrite_(&w, Str(",\"cat\":\""));
+		TimelineWrite_(&w, categories[event->kind]);
+		TimelineWrite_(&w, Str("\",\"ph\":\"X\",\"pid\":1,\"tid\":"));
+		TimelineWriteUint_(&w, event->thread);
+		TimelineWrite_(&w, Str(",\"ts\":"));
+		TimelineWriteMicroseconds_(&w, event->begin_tick - origin, tick_rate);
+		TimelineWrite_(&w, Str(",\"dur\":"));
+		TimelineWriteMicroseconds_(&w, end - event->begin_tick, tick_rate);
+		if (event->bytes)
+		{
+			TimelineWrite_(&w, Str(",\"args\":{\"bytes\":"));
+			TimelineWriteUint_(&w, event->bytes);
+			TimelineWrite_(&w, Str("}"));
+		}
+		TimelineWrite_(&w, Str("}"));
+	}
+	TimelineWrite_(&w, Str("\n]}\n"));
+
+	ArenaRestore(scratch);
+	return (String) { .data = w.data, .size = w.size };
+}
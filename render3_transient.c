@@ -0,0 +1,151 @@
+#include <base/base.h>
+#include <base/base_intrinsics.h>
+#include <base/base_assert.h>
+#include <base/base_arena.h>
+#include <layer_os/api.h>
+#include "api.h"
+
+struct R3_TransientTexture_
+{
+	R3_TextureDesc desc; // 'initial_data' is always NULL
+	R3_Texture texture;
+	uint64 size;
+	uint64 last_frame; // last frame it was acquired in
+	bool used;
+	bool in_use;
+}
+typedef R3_TransientTexture_;
+
+static bool
+TransientDescMatches_(R3_TextureDesc const* a, R3_TextureDesc const* b)
+{
+	return
+		a->width == b->width &&
+		a->height == b->height &&
+		a->depth == b->depth &&
+		a->format == b->format &&
+		a->usage == b->usage &&
+		a->binding_flags == b->binding_flags &&
+		a->mipmap_count == b->mipmap_count &&
+		a->flag_cubemap == b->flag_cubemap &&
+		ClampMin(a->sample_count, 1) == ClampMin(b->sample_count, 1);
+}
+
+//------------------------------------------------------------------------
+API R3_TransientPool
+R3_MakeTransientPool(R3_Context* ctx, R3_TransientPoolDesc const* desc)
+{
+	Trace();
+	R3_TransientPool out = {};
+	SafeAssert(desc->arena && desc->max_textures > 0);
+
+	out.capacity = desc->max_textures;
+	out.max_unused_frames = desc->max_unused_frames;
+	out.textures = ArenaPushArray(desc->arena, R3_TransientTexture_, out.capacity);
+	SafeAssert(out.textures);
+	MemoryZero(out.textures, sizeof(R3_TransientTexture_) * out.capacity);
+
+	return out;
+}
+
+API void
+R3_FreeTransientPool(R3_Context* ctx, R3_TransientPool* pool)
+{
+	Trace();
+
+	for (uint32 i = 0; i < pool->capacity; ++i)
+	{
+		if (pool->textures[i].used)
+			R3_FreeTexture(ctx, &pool->textures[i].texture);
+	}
+
+	*pool = (R3_TransientPool) {};
+}
+
+API void
+R3_BeginTransientFrame(R3_Context* ctx, R3_TransientPool* pool)
+{
+	Trace();
+	pool->last_frame_stats = pool->stats;
+	pool->stats = (R3_TransientStats) {};
+	++pool->frame;
+
+	for (uint32 i = 0; i < pool->capacity; ++i)
+	{
+		R3_TransientTexture_* entry = &pool->textures[i];
+		if (!entry->used)
+			continue;
+		SafeAssert(!entry->in_use);
+
+		if (pool->max_unused_frames && pool->frame - entry->last_frame > pool->max_unused_frames)
+		{
+			R3_FreeTexture(ctx, &entry->texture);
+			pool->allocated_bytes -= entry->size;
+			*entry = (R3_TransientTexture_) {};
+		}
+	}
+}
+
+API R3_Texture*
+R3_AcquireTransientTexture(R3_Context* ctx, R3_TransientPool* pool, R3_TextureDesc const* desc)
+{
+	Trace();
+	SafeAssert(!desc->initial_data);
+
+	R3_TransientTexture_* found = NULL;
+	R3_TransientTexture_* free_entry = NULL;
+	for (uint32 i = 0; i < pool->capacity; ++i)
+	{
+		R3_TransientTexture_* entry = &pool->textures[i];
+		if (!entry->used)
+		{
+			if (!free_entry)
+				free_entry = entry;
+		}
+		else if (!entry->in_use && TransientDescMatches_(&entry->desc, desc))
+		{
+			found = entry;
+			break;
+		}
+	}
+
+	if (!found)
+	{
+		SafeAssert(free_entry);
+		found = free_entry;
+		found->used = true;
+		found->desc = *desc;
+		found->size = R3_EstimateTextureSize(desc);
+		found->texture = R3_MakeTexture(ctx, desc);
+		found->last_frame = 0;
+		pool->allocated_bytes += found->size;
+	}
+
+	// NOTE(ljre): The first acquire of a physical texture in a frame is what counts towards its footprint,
+	//             every acquire counts towards what it would take without aliasing.
+	if (found->last_frame != pool->frame)
+	{
+		pool->stats.physical_bytes += found->size;
+		++pool->stats.physical_count;
+	}
+	pool->stats.requested_bytes += found->size;
+	++pool->stats.acquire_count;
+	pool->live_bytes += found->size;
+	pool->stats.peak_live_bytes = Max(pool->stats.peak_live_bytes, pool->live_bytes);
+
+	found->in_use = true;
+	found->last_frame = pool->frame;
+	return &found->texture;
+}
+
+API void
+R3_ReleaseTransientTexture(R3_Context* ctx, R3_TransientPool* pool, R3_Texture* texture)
+{
+	Trace();
+	R3_TransientTexture_* entry = (R3_TransientTexture_*)((uint8*)texture - offsetof(R3_TransientTexture_, texture));
+	SafeAssert(entry >= pool->textures && entry < pool->textures + pool->capacity);
+	SafeAssert(entry->used && entry->in_use);
+
+	entry->in_use = false;
+	pool->live_bytes -= entry->size;
+}